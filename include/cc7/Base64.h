@@ -38,6 +38,13 @@ namespace cc7
 	 */
 	bool Base64_Decode(const std::string & in_string, size_t wrap_size, ByteArray & out_data);
 	
+	/**
+	 Converts Base64 encoded characters from |in_string| range into ByteArray. The function
+	 behaves exactly as Base64_Decode() for std::string, but the characters don't need to be
+	 copied into the string object.
+	 */
+	bool Base64_Decode(const ByteRange & in_string, size_t wrap_size, ByteArray & out_data);
+	
 	/**
 	 Converts input byte range into Base64 encoded string. This variant of encoding function may be
 	 easier to use, but unlike the Base64_Encode(), you are not able to determine whether
@@ -18,6 +18,7 @@
 
 #include <cc7/Platform.h>
 #include <cc7/DebugFeatures.h>
+#include <cc7/Trace.h>
 #include <cc7/Endian.h>
 #include <cc7/ByteArray.h>
 #include <cc7/Utilities.h>
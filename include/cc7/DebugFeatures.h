@@ -57,6 +57,45 @@ namespace debug
 	};
 
 
+	/**
+	 The AllocationStats structure contains statistics collected by the CleanupAllocator.
+	 All counters are collected per-thread.
+	 */
+	struct AllocationStats
+	{
+		/**
+		 Number of allocations.
+		 */
+		cc7::U64	allocations;
+		/**
+		 Number of deallocations.
+		 */
+		cc7::U64	deallocations;
+		/**
+		 Sum of all allocated bytes.
+		 */
+		cc7::U64	allocated_bytes;
+		/**
+		 Number of currently allocated bytes. The value may be negative, when the memory
+		 allocated in other thread, or before the reset, was released.
+		 */
+		int64_t		live_bytes;
+		/**
+		 Peak value of live_bytes.
+		 */
+		int64_t		peak_live_bytes;
+		/**
+		 Sum of bytes securely cleaned before the deallocation.
+		 */
+		cc7::U64	wiped_bytes;
+		/**
+		 Number of detected reallocations. The reallocation is detected when the
+		 deallocation of a smaller block immediately follows the allocation of
+		 a larger block. This is typical for std::vector's growth.
+		 */
+		cc7::U64	reallocations;
+	};
+	
 	/**
 	 Returns true if the library was compiled with a debug features turned on.
 	 It is highly recommended to NOT use this kind of build in the production environment.
@@ -88,6 +127,33 @@ namespace debug
 	 */
 	AssertionHandlerSetup Platform_GetDefaultAssertionHandler();
 	
+	/**
+	 Sets how many failures of one CC7_ASSERT or CC7_CHECK call site are passed to
+	 the assertion handler. Further failures are only counted, and a summary is
+	 reported each time the counter reaches a power of two. If the |limit| is 0,
+	 then all failures are reported. The default limit is 4.
+	 
+	 The failures from C code are always reported.
+	 */
+	void SetAssertionReportLimit(unsigned int limit);
+	
+	/**
+	 Returns current limit of reported failures per call site.
+	 */
+	unsigned int GetAssertionReportLimit();
+	
+	/**
+	 Reports summary for all call sites, which have some failures suppressed.
+	 */
+	void ReportSuppressedAssertions();
+	
+	/**
+	 Resets failure counters for all call sites. The function is not synchronized with
+	 failing assertions in other threads, so it's recommended to use it only during
+	 the unit testing.
+	 */
+	void ResetAssertionCounters();
+	
 #endif // defined(ENABLE_CC7_ASSERT)
 
 	
@@ -118,5 +184,29 @@ namespace debug
 
 #endif // defined(ENABLE_CC7_LOG)
 
+	
+#if defined(ENABLE_CC7_ALLOCATION_STATS)
+	
+	/**
+	 Returns allocation statistics collected by the CleanupAllocator for the calling thread.
+	 This function is available only when the library is compiled with
+	 ENABLE_CC7_ALLOCATION_STATS macro.
+	 */
+	AllocationStats GetAllocationStats();
+	
+	/**
+	 Resets allocation statistics for the calling thread.
+	 */
+	void ResetAllocationStats();
+	
+	namespace detail
+	{
+		// Hooks called from the CleanupAllocator
+		void AllocationStatsOnAllocate(const void * ptr, size_t size);
+		void AllocationStatsOnDeallocate(const void * ptr, size_t size);
+	}
+	
+#endif // defined(ENABLE_CC7_ALLOCATION_STATS)
+
 } // cc7::debug
 } // cc7
@@ -32,6 +32,12 @@ namespace cc7
 	 */
 	bool HexString_Decode(const std::string & in_string, ByteArray & out_data);
 	
+	/**
+	 Converts hexadecimal characters from |in_string| range into ByteArray. Returns false
+	 if the range doesn't contain a valid hexadecimal string.
+	 */
+	bool HexString_Decode(const ByteRange & in_string, ByteArray & out_data);
+	
 	/**
 	 Converts input byte range into hexadecimal upper, or lowercase string. 
 	 This variant of encoding function may be easier to use, but unlike 
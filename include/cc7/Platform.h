@@ -187,6 +187,25 @@
 	//
 	CC7_EXTERN_C int CC7AssertImpl(int condition, const char * file, int line, const char * format, ...);
 
+	#ifdef __cplusplus
+		#include <atomic>
+		/*
+		 The CC7AssertSite is a per-call-site state of CC7_ASSERT & CC7_CHECK macros.
+		 The structure is allocated as a function-local static variable, so it's zero
+		 initialized without any runtime guard. Sites are registered to the global
+		 lock-free list at their first failure.
+		 */
+		struct CC7AssertSite
+		{
+			std::atomic<unsigned int>	count;
+			std::atomic<bool>			registered;
+			const char *				file;
+			int							line;
+			CC7AssertSite *				next;
+		};
+		int CC7AssertSiteImpl(CC7AssertSite * site, const char * file, int line, const char * format, ...);
+	#endif
+
 	#ifdef CC7_IOS
 		#if	TARGET_CPU_ARM == 1
 			// 32 bit ARM
@@ -220,12 +239,30 @@
 		#define CC7_BREAKPOINT()
 	#endif // CC7_WINDOWS
 
-	#define CC7_ASSERT(cond, ...)												\
-		if (!(cond)) {															\
-			CC7AssertImpl(0, __FILE__, __LINE__, "" __VA_ARGS__);				\
-		}
-	#define CC7_CHECK(cond, ...)												\
-		CC7AssertImpl(cond, __FILE__, __LINE__, "" __VA_ARGS__)
+	#ifdef __cplusplus
+		// C++, failures are deduplicated and rate limited per call site
+		#define CC7_ASSERT(cond, ...)											\
+			if (!(cond)) {														\
+				static CC7AssertSite cc7_assert_site_;							\
+				CC7AssertSiteImpl(&cc7_assert_site_, __FILE__, __LINE__, "" __VA_ARGS__);	\
+			}
+		#define CC7_CHECK(cond, ...)											\
+			([&]() -> int {														\
+				if (cond) {														\
+					return 1;													\
+				}																\
+				static CC7AssertSite cc7_assert_site_;							\
+				return CC7AssertSiteImpl(&cc7_assert_site_, __FILE__, __LINE__, "" __VA_ARGS__);	\
+			}())
+	#else
+		// C, each failure is reported
+		#define CC7_ASSERT(cond, ...)											\
+			if (!(cond)) {														\
+				CC7AssertImpl(0, __FILE__, __LINE__, "" __VA_ARGS__);			\
+			}
+		#define CC7_CHECK(cond, ...)											\
+			CC7AssertImpl(cond, __FILE__, __LINE__, "" __VA_ARGS__)
+	#endif
 
 #else
 	//
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cc7/Platform.h>
+
+#if defined(ENABLE_CC7_TRACE)
+#include <atomic>
+#endif
+
+namespace cc7
+{
+namespace debug
+{
+	/**
+	 Defines function returning current time for the trace recorder. The returned
+	 value is in platform specific units, the TraceTimeDiffFunction is used for
+	 the conversion to milliseconds.
+	 */
+	typedef cc7::U64 (*TraceGetTimeFunction)();
+
+	/**
+	 Defines function which returns difference between two time values, produced
+	 by TraceGetTimeFunction. The returned value is in milliseconds.
+	 */
+	typedef double (*TraceTimeDiffFunction)(cc7::U64 start, cc7::U64 future);
+
+	/**
+	 The TraceClockSetup structure contains clock functions used by the trace recorder.
+	 The cc7tests library installs its Platform_GetCurrentTime & Platform_GetTimeDiff
+	 functions, so the traces are comparable with times reported in the test log.
+	 */
+	struct TraceClockSetup
+	{
+		TraceGetTimeFunction	get_time;
+		TraceTimeDiffFunction	time_diff;
+	};
+
+#if defined(ENABLE_CC7_TRACE)
+
+	/**
+	 Sets a new clock to the trace recorder. If the |new_setup| contains
+	 NULL functions, then the default, std::chrono based clock is used.
+	 The new clock is applied at next call to StartTracing().
+
+	 Note that the function is not thread-safe. It is recommended to change
+	 the clock only when the tracing is not active.
+	 */
+	void SetTraceClock(const TraceClockSetup & new_setup);
+
+	/**
+	 Returns current clock setup of the trace recorder.
+	 */
+	TraceClockSetup GetTraceClock();
+
+	/**
+	 Clears all previously recorded events and starts recording of new ones.
+	 */
+	void StartTracing();
+
+	/**
+	 Stops recording of events. The recorded events are kept until the next
+	 StartTracing() or ClearTraceEvents() call.
+	 */
+	void StopTracing();
+
+	/**
+	 Returns true if the trace recorder is recording events.
+	 */
+	bool IsTracingActive();
+
+	/**
+	 Clears all recorded events and frees the buffers of already finished threads.
+	 The function should be called only when the tracing is not active.
+	 */
+	void ClearTraceEvents();
+
+	/**
+	 Returns number of events which did not fit to the per-thread buffers.
+	 */
+	size_t DroppedTraceEventsCount();
+
+	/**
+	 Returns all recorded events as Chrome "trace_event" JSON document. The document
+	 can be opened in Perfetto UI, or in chrome://tracing.
+	 */
+	std::string ExportTraceEvents();
+
+
+	namespace detail
+	{
+		/**
+		 Global flag, telling whether the recording is active.
+		 Don't use this variable directly, use IsTracingActive() instead.
+		 */
+		extern std::atomic<bool> g_trace_active;
+
+		void TraceRecordBegin(const char * name);
+		void TraceRecordEnd(const char * name);
+		void TraceRecordCounter(const char * name, int64_t value);
+
+		/**
+		 The TraceScope records begin event at its construction and matching end
+		 event at its destruction. The |name| must be a string with static storage
+		 duration, because only the pointer is stored to the trace buffer.
+		 */
+		class TraceScope
+		{
+		public:
+			TraceScope(const char * name) :
+				_name(g_trace_active.load(std::memory_order_relaxed) ? name : nullptr)
+			{
+				if (_name) {
+					TraceRecordBegin(_name);
+				}
+			}
+
+			~TraceScope()
+			{
+				if (_name) {
+					TraceRecordEnd(_name);
+				}
+			}
+
+		private:
+			TraceScope(const TraceScope &) = delete;
+			TraceScope & operator=(const TraceScope &) = delete;
+
+			const char * _name;
+		};
+
+		inline void TraceCounter(const char * name, int64_t value)
+		{
+			if (g_trace_active.load(std::memory_order_relaxed)) {
+				TraceRecordCounter(name, value);
+			}
+		}
+
+	} // cc7::debug::detail
+
+#endif // defined(ENABLE_CC7_TRACE)
+
+} // cc7::debug
+} // cc7
+
+
+#if defined(ENABLE_CC7_TRACE)
+	//
+	// CC7_TRACE_SCOPE & CC7_TRACE_COUNTER are enabled
+	//
+	#define __CC7_TRACE_CONCAT2(a, b)			a##b
+	#define __CC7_TRACE_CONCAT(a, b)			__CC7_TRACE_CONCAT2(a, b)
+
+	#define CC7_TRACE_SCOPE(name)				cc7::debug::detail::TraceScope __CC7_TRACE_CONCAT(__cc7_trace_scope_, __LINE__)(name)
+	#define CC7_TRACE_COUNTER(name, value)		cc7::debug::detail::TraceCounter(name, (int64_t)(value))
+
+#else
+	//
+	// Tracing is disabled
+	//
+	#define CC7_TRACE_SCOPE(name)
+	#define CC7_TRACE_COUNTER(name, value)
+
+#endif // defined(ENABLE_CC7_TRACE)
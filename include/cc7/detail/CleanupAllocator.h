@@ -17,6 +17,7 @@
 #pragma once
 
 #include <cc7/Platform.h>
+#include <cc7/DebugFeatures.h>
 
 namespace cc7
 {
@@ -25,6 +26,9 @@ namespace detail
 	/**
 	 The CleanupAllocator is a special std::allocator, which only purpose
 	 is to secure clean the allocated memory, before the deallocation.
+	 
+	 If the library is compiled with ENABLE_CC7_ALLOCATION_STATS, then the allocator
+	 also collects per-thread statistics, available in cc7::debug::GetAllocationStats().
 	 */
 	template <class T> class CleanupAllocator : public std::allocator<T>
 	{
@@ -47,9 +51,21 @@ namespace detail
 		{
 		}
 		
+#if defined(ENABLE_CC7_ALLOCATION_STATS)
+		T * allocate(size_t n, const void * /*hint*/ = 0)
+		{
+			T * p = std::allocator <T>::allocate(n);
+			debug::detail::AllocationStatsOnAllocate(p, n * sizeof(T));
+			return p;
+		}
+#endif
+		
 		void deallocate(T * p,  size_t n)
 		{
 			CC7_SecureClean(p, n * sizeof(T));
+#if defined(ENABLE_CC7_ALLOCATION_STATS)
+			debug::detail::AllocationStatsOnDeallocate(p, n * sizeof(T));
+#endif
 			std::allocator <T>::deallocate(p, n);
 		}
 	};
@@ -0,0 +1,71 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cc7/Platform.h>
+
+namespace cc7
+{
+namespace tests
+{
+	/**
+	 The AllocationCounters structure contains number of heap allocations, made
+	 by the calling thread. 
+	 */
+	struct AllocationCounters
+	{
+		/**
+		 Number of allocations.
+		 */
+		cc7::U64	allocations;
+		/**
+		 Number of deallocations.
+		 */
+		cc7::U64	deallocations;
+		/**
+		 Sum of all allocated bytes.
+		 */
+		cc7::U64	allocated_bytes;
+	};
+	
+	/**
+	 Returns true if allocations can be counted. There are two possible sources
+	 of the counters:
+	 
+	  - If the cc7tests library is compiled with ENABLE_CC7_ALLOCATION_COUNTER macro,
+	    then the library replaces global operator new & delete and counts all heap
+	    allocations made in C++ code.
+	  - If the cc7 library is compiled with ENABLE_CC7_ALLOCATION_STATS macro, then
+	    only allocations made by CleanupAllocator (e.g. in cc7::ByteArray) are counted.
+	 
+	 If none of these macros is defined, then the function returns false.
+	 */
+	bool AllocationCountersAvailable();
+	
+	/**
+	 Returns allocation counters for the calling thread.
+	 */
+	AllocationCounters GetAllocationCounters();
+	
+	/**
+	 Resets allocation counters for the calling thread.
+	 */
+	void ResetAllocationCounters();
+	
+} // cc7::tests
+} // cc7
@@ -0,0 +1,323 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cc7tests/UnitTest.h>
+#include <cc7tests/PerformanceTimer.h>
+#include <functional>
+
+namespace cc7
+{
+namespace tests
+{
+	/**
+	 The BenchmarkConfig structure contains configuration for the BenchmarkRunner.
+	 */
+	struct BenchmarkConfig
+	{
+		BenchmarkConfig() :
+			target_time(10.0),
+			warmup_runs(1),
+			repetitions(15),
+			max_iterations(1 << 30),
+			hardware_counters(true),
+			max_threads(0),
+			pin_threads(false)
+		{
+		}
+		
+		/**
+		 Desired time for one repetition, in milliseconds. The runner calibrates
+		 the number of iterations to reach this time.
+		 */
+		double target_time;
+		/**
+		 Number of repetitions executed before the measurement.
+		 */
+		size_t warmup_runs;
+		/**
+		 Number of measured repetitions.
+		 */
+		size_t repetitions;
+		/**
+		 Maximum number of iterations in one repetition.
+		 */
+		size_t max_iterations;
+		/**
+		 If true, then the hardware performance counters are measured, when
+		 available on the platform.
+		 */
+		bool hardware_counters;
+		/**
+		 Maximum number of threads used for the thread scaling benchmarks. If 0, then
+		 the number of hardware threads is used.
+		 */
+		size_t max_threads;
+		/**
+		 If true, then each thread in the thread scaling benchmark is pinned to
+		 one CPU core, if supported by the platform.
+		 */
+		bool pin_threads;
+	};
+	
+	/**
+	 The BenchmarkResult structure contains results of one benchmark method.
+	 All times are in nanoseconds per one iteration.
+	 */
+	struct BenchmarkResult
+	{
+		BenchmarkResult() :
+			iterations(0),
+			bytes_per_iteration(0),
+			min(0.0), median(0.0), mean(0.0), p99(0.0), stddev(0.0),
+			bytes_per_second(0.0),
+			counters_available(0)
+		{
+			for (size_t i = 0; i < PerformanceCounters::CountersCount; i++) {
+				counters[i] = 0.0;
+			}
+		}
+		
+		/**
+		 Name of benchmark, in "Class.method" format.
+		 */
+		std::string name;
+		/**
+		 Number of iterations in one repetition.
+		 */
+		size_t iterations;
+		/**
+		 Number of bytes processed in one iteration. If 0, then the throughput
+		 is not calculated.
+		 */
+		size_t bytes_per_iteration;
+		/**
+		 Time per iteration, measured in each repetition.
+		 */
+		std::vector<double> samples;
+		
+		double min;
+		double median;
+		double mean;
+		double p99;
+		double stddev;
+		/**
+		 Throughput calculated from the median time.
+		 */
+		double bytes_per_second;
+		/**
+		 Bit mask with hardware counters, available in all repetitions.
+		 */
+		cc7::U32 counters_available;
+		/**
+		 Average value of hardware counters per one iteration. Use hasCounter()
+		 to test whether the value is valid.
+		 */
+		double counters[PerformanceCounters::CountersCount];
+		
+		/**
+		 Returns true if |counter| was measured.
+		 */
+		bool hasCounter(PerformanceCounters::Counter counter) const
+		{
+			return (counters_available & (1 << counter)) != 0;
+		}
+		
+		/**
+		 Calculates all statistic values from the samples.
+		 */
+		void computeStatistics();
+		
+		/**
+		 Returns a human readable, one line summary of the result.
+		 */
+		std::string toString() const;
+	};
+	
+	/**
+	 The BenchmarkScalingResult structure contains result of one step of the thread
+	 scaling benchmark.
+	 */
+	struct BenchmarkScalingResult
+	{
+		BenchmarkScalingResult() :
+			threads(0),
+			operations_per_second(0.0),
+			bytes_per_second(0.0),
+			thread_variation(0.0),
+			efficiency(0.0),
+			pinned(false)
+		{
+		}
+		
+		/**
+		 Number of concurrently running threads.
+		 */
+		size_t threads;
+		/**
+		 Result with samples from all threads and repetitions. The result's name
+		 has "/threads:N" suffix.
+		 */
+		BenchmarkResult result;
+		/**
+		 Aggregate throughput of all threads.
+		 */
+		double operations_per_second;
+		/**
+		 Aggregate throughput of all threads, in bytes per second.
+		 */
+		double bytes_per_second;
+		/**
+		 Coefficient of variation of the mean time per iteration, between threads.
+		 */
+		double thread_variation;
+		/**
+		 Aggregate throughput divided by the single thread throughput multiplied
+		 by the number of threads. The ideal scaling has efficiency 1.0.
+		 */
+		double efficiency;
+		/**
+		 True if all threads were pinned to CPU cores.
+		 */
+		bool pinned;
+		
+		/**
+		 Returns a human readable, one line summary of the result.
+		 */
+		std::string toString() const;
+	};
+	
+	/**
+	 The BenchmarkFunction is a function with benchmarked code. The function must
+	 execute the measured operation |iterations| times.
+	 */
+	typedef std::function<void(size_t iterations)> BenchmarkFunction;
+	
+	/**
+	 The BenchmarkRunner class executes one benchmark function. At first, the number of
+	 iterations is calibrated to the target time, then the warmup runs are executed and
+	 finally, the configured number of repetitions is measured.
+	 */
+	class BenchmarkRunner
+	{
+	public:
+		
+		BenchmarkRunner(const BenchmarkConfig & config = BenchmarkConfig());
+		
+		/**
+		 Returns configuration of the runner.
+		 */
+		const BenchmarkConfig & config() const;
+		
+		/**
+		 Runs |function| and returns the result. The |name| and |bytes_per_iteration|
+		 are only stored to the result.
+		 */
+		BenchmarkResult run(const std::string & name, const BenchmarkFunction & function, size_t bytes_per_iteration) const;
+		
+		/**
+		 Returns number of iterations, which takes approximately config().target_time
+		 milliseconds.
+		 */
+		size_t calibrate(const BenchmarkFunction & function) const;
+		
+		/**
+		 Runs |function| concurrently on 1, 2, 4 ... config().max_threads threads and
+		 returns results for all steps. The |function| must be thread safe. All threads
+		 start each repetition at the same time.
+		 */
+		std::vector<BenchmarkScalingResult> runScaling(const std::string & name, const BenchmarkFunction & function, size_t bytes_per_iteration) const;
+		
+	private:
+		
+		BenchmarkConfig _config;
+	};
+	
+	/**
+	 The Benchmark is a base class for all benchmarks in cc7tests framework. Benchmark is
+	 a regular UnitTest, so it's executed by the TestManager, but its methods are registered
+	 with CC7_REGISTER_BENCHMARK_METHOD() and are executed by the BenchmarkRunner.
+	 The results are printed to the test log and collected in the TestManager.
+	 */
+	class Benchmark : public UnitTest
+	{
+	public:
+		
+		Benchmark();
+		
+		/**
+		 Sets configuration for all benchmark methods in this class.
+		 */
+		void setBenchmarkConfig(const BenchmarkConfig & config);
+		
+		/**
+		 Returns configuration for all benchmark methods in this class.
+		 */
+		const BenchmarkConfig & benchmarkConfig() const;
+		
+	protected:
+		
+		/**
+		 Registers a benchmark method. You should use CC7_REGISTER_BENCHMARK_METHOD()
+		 macro instead of the direct call.
+		 */
+		void registerBenchmarkMethod(BenchmarkFunction method, const char * name, size_t bytes_per_iteration);
+		
+		/**
+		 Registers a thread scaling benchmark method. You should use
+		 CC7_REGISTER_SCALING_BENCHMARK_METHOD() macro instead of the direct call.
+		 */
+		void registerScalingBenchmarkMethod(BenchmarkFunction method, const char * name, size_t bytes_per_iteration);
+		
+	private:
+		
+		void runBenchmarkMethod(const BenchmarkFunction & method, const std::string & name, size_t bytes_per_iteration);
+		void runScalingBenchmarkMethod(const BenchmarkFunction & method, const std::string & name, size_t bytes_per_iteration);
+		void reportBenchmarkResult(const BenchmarkResult & result);
+		
+		BenchmarkConfig _config;
+	};
+	
+	
+	namespace detail
+	{
+		extern const void * volatile g_benchmark_sink;
+		
+		/**
+		 Measures |block| for the performance assertions. The block is executed
+		 in short repetitions and the median time is used for the evaluation.
+		 */
+		BenchmarkResult MeasureAssertionBlock(const std::function<void()> & block, const char * name, size_t bytes_per_iteration);
+	}
+	
+	/**
+	 Prevents the compiler to optimize out the computation of |value|. You should
+	 pass results of the benchmarked operation to this function.
+	 */
+	template <typename T>
+	inline void BenchmarkKeepValue(const T & value)
+	{
+#if defined(_MSC_VER)
+		detail::g_benchmark_sink = &value;
+#else
+		__asm__ __volatile__("" : : "g"(&value) : "memory");
+#endif
+	}
+	
+} // cc7::tests
+} // cc7
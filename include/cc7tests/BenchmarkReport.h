@@ -0,0 +1,152 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cc7tests/Benchmark.h>
+#include <cc7tests/JSONValue.h>
+#include <map>
+
+namespace cc7
+{
+namespace tests
+{
+	/**
+	 The BenchmarkContext structure describes environment, where the benchmarks
+	 were executed.
+	 */
+	struct BenchmarkContext
+	{
+		/**
+		 CPU model, or empty string if it's not known.
+		 */
+		std::string cpu_model;
+		/**
+		 Compiler, architecture and relevant compile time flags.
+		 */
+		std::string build_flags;
+		
+		/**
+		 Returns context for the current process.
+		 */
+		static BenchmarkContext currentContext();
+	};
+	
+	/**
+	 Returns JSON document with all |results| and |context|. The document contains
+	 "context" object and "benchmarks" array. Each benchmark object contains "name",
+	 "iterations", "bytes_per_iteration", "stats" object and "samples" array with
+	 nanoseconds per iteration. The same document can be later used as a baseline.
+	 */
+	std::string BenchmarkResultsToJSON(const std::vector<BenchmarkResult> & results, const BenchmarkContext & context);
+	
+	/**
+	 The BenchmarkComparison structure contains result of comparison of one benchmark
+	 with its baseline.
+	 */
+	struct BenchmarkComparison
+	{
+		BenchmarkComparison() :
+			baseline_median(0.0),
+			current_median(0.0),
+			ratio(0.0),
+			p_value(1.0),
+			regression(false)
+		{
+		}
+		
+		std::string name;
+		double baseline_median;
+		double current_median;
+		/**
+		 current_median / baseline_median
+		 */
+		double ratio;
+		/**
+		 One-sided p-value of the Mann–Whitney U test, for hypothesis that
+		 the current samples are slower than the baseline samples.
+		 */
+		double p_value;
+		/**
+		 True if the benchmark is slower than the threshold, with the statistical
+		 significance.
+		 */
+		bool regression;
+		
+		/**
+		 Returns a human readable, one line summary of the comparison.
+		 */
+		std::string toString() const;
+	};
+	
+	/**
+	 The BenchmarkBaseline class keeps results loaded from the baseline JSON document
+	 and compares the new results with them.
+	 */
+	class BenchmarkBaseline
+	{
+	public:
+		
+		BenchmarkBaseline();
+		
+		/**
+		 Loads baseline from JSON document, produced by BenchmarkResultsToJSON().
+		 Returns false if the document is not valid.
+		 */
+		bool load(const cc7::ByteRange & json_data, std::string * out_error = nullptr);
+		
+		/**
+		 Returns true if the baseline contains results.
+		 */
+		bool isEmpty() const;
+		
+		/**
+		 Sets threshold for the regression. For example, 0.05 means that the benchmark
+		 is flagged when its median is more than 5% slower than the baseline.
+		 The default value is 0.05.
+		 */
+		void setThreshold(double threshold);
+		double threshold() const;
+		
+		/**
+		 Sets significance level for the statistical test. The default value is 0.01.
+		 */
+		void setSignificanceLevel(double alpha);
+		double significanceLevel() const;
+		
+		/**
+		 Compares |result| with the baseline. Returns false if the baseline doesn't
+		 contain the benchmark with the same name.
+		 */
+		bool compare(const BenchmarkResult & result, BenchmarkComparison & out_comparison) const;
+		
+	private:
+		
+		std::map<std::string, std::vector<double>> _samples;
+		double _threshold;
+		double _alpha;
+	};
+	
+	/**
+	 Returns one-sided p-value of the Mann–Whitney U test, for alternative
+	 hypothesis that values in |a| are greater than values in |b|. The normal
+	 approximation with the tie correction is used.
+	 */
+	double MannWhitneyGreaterPValue(const std::vector<double> & a, const std::vector<double> & b);
+	
+} // cc7::tests
+} // cc7
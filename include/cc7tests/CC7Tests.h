@@ -17,8 +17,15 @@
 #pragma once
 
 #include <cc7tests/TestManager.h>
+#include <cc7tests/Benchmark.h>
+#include <cc7tests/AllocationCounter.h>
 #include <cc7tests/TestAssertions.h>
 #include <cc7tests/TestRegistrationMacros.h>
 #include <cc7tests/TestDirectory.h>
 #include <cc7tests/TestUtils.h>
-#include <cc7tests/JSONReader.h>
\ No newline at end of file
+#include <cc7tests/JSONReader.h>
+#include <cc7tests/JSONPath.h>
+#include <cc7tests/JSONDocument.h>
+#include <cc7tests/JSONLazyDocument.h>
+#include <cc7tests/JSONStreamParser.h>
+#include <cc7tests/JSONWriter.h>
\ No newline at end of file
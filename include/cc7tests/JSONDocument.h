@@ -0,0 +1,252 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cc7tests/JSONPath.h>
+
+namespace cc7
+{
+namespace tests
+{
+	namespace detail
+	{
+		class JSONDocumentBuilder;
+	}
+	
+	/**
+	 The JSONNode class represents one value in the JSONDocument. The node is
+	 allocated in the document's arena and is valid until the document is destroyed
+	 or parsed again. The children of arrays and objects are stored in a contiguous
+	 block of nodes. The object's children are stored as key-value pairs, so the
+	 object with N members has 2*N children.
+	 */
+	class JSONNode
+	{
+	public:
+		
+		typedef JSONValue::Type Type;
+		
+		JSONNode() : _t(JSONValue::NaT), _size(0), _integer(0) {}
+		
+		// Type
+		
+		Type type() const
+		{
+			return _t;
+		}
+		
+		bool isType(Type t) const
+		{
+			return _t == t;
+		}
+		
+		bool isNull() const
+		{
+			return _t == JSONValue::Null;
+		}
+		
+		bool isValid() const
+		{
+			return _t != JSONValue::NaT;
+		}
+		
+		/**
+		 Returns number of elements in array, number of members in object, or
+		 length of string. Returns 0 for all other types.
+		 */
+		size_t size() const
+		{
+			return _t & (JSONValue::Object | JSONValue::Array | JSONValue::String) ? _size : 0;
+		}
+		
+		// Array & Object
+		
+		/**
+		 Returns element of array at |index|.
+		 */
+		const JSONNode & at(size_t index) const;
+		
+		/**
+		 Returns key of object's member at |index|. The key is always a String node.
+		 */
+		const JSONNode & keyAt(size_t index) const;
+		
+		/**
+		 Returns value of object's member at |index|.
+		 */
+		const JSONNode & valueAt(size_t index) const;
+		
+		/**
+		 Returns value of object's member with |key|, or nullptr if there's no such member.
+		 If the key is duplicated in the object, then the last member is returned.
+		 */
+		const JSONNode * find(const cc7::ByteRange & key) const;
+		const JSONNode * find(const std::string & key) const
+		{
+			return find(cc7::ByteRange(key));
+		}
+		
+		/**
+		 Returns node at |path|. See JSONPath for the syntax. The method throws
+		 std::invalid_argument if the path doesn't exist or if the selected node
+		 has unexpected type.
+		 */
+		const JSONNode & valueAtPath(const std::string & path, Type expected_type = JSONValue::NaT) const;
+		const JSONNode & valueAtPath(const JSONPath & path, Type expected_type = JSONValue::NaT) const;
+		
+		// Casting
+		
+		/**
+		 Returns content of the string node. The returned range points to the original
+		 document data if the string has no escaped characters, or to the document's arena.
+		 */
+		cc7::ByteRange asRange() const
+		{
+			castToType(JSONValue::String);
+			return cc7::ByteRange(_string, _size);
+		}
+		
+		std::string asString() const
+		{
+			castToType(JSONValue::String);
+			return std::string(_string, _size);
+		}
+		
+		double asDouble() const
+		{
+			castToType(JSONValue::Double);
+			return _double;
+		}
+		
+		int64_t asInteger() const
+		{
+			castToType(JSONValue::Integer);
+			return _integer;
+		}
+		
+		bool asBoolean() const
+		{
+			castToType(JSONValue::Boolean);
+			return _boolean;
+		}
+		
+		/**
+		 Converts node, including all its children, into JSONValue.
+		 */
+		JSONValue toValue() const;
+		
+	private:
+		
+		friend class detail::JSONDocumentBuilder;
+		
+		// Private members
+		
+		Type _t;
+		cc7::U32 _size;
+		union
+		{
+			bool				_boolean;
+			int64_t				_integer;
+			double				_double;
+			const char *		_string;
+			const JSONNode *	_children;
+		};
+		
+		// Private methods
+		
+		inline void castToType(int t) const
+		{
+			if ((_t & t) == 0) {
+				throw std::logic_error("Unable to cast to type");
+			}
+		}
+	};
+	
+	
+	/**
+	 The JSONDocument class is an alternative to JSONValue DOM, optimized for
+	 parsing of large documents. All nodes are allocated in one arena, owned by
+	 the document, so the whole tree is released at once, when the document is
+	 destroyed. The strings without escaped characters are not copied and points
+	 directly to the parsed data, so the data must outlive the document.
+	 */
+	class JSONDocument
+	{
+	public:
+		
+		JSONDocument();
+		~JSONDocument();
+		
+		JSONDocument(const JSONDocument &) = delete;
+		JSONDocument & operator=(const JSONDocument &) = delete;
+		
+		/**
+		 Parses JSON document from |range|. The previous content of the document
+		 is released. Returns false and sets |out_error| if the document is not valid.
+		 The |range| must be valid for the whole lifetime of parsed content.
+		 */
+		bool parse(const cc7::ByteRange & range, std::string * out_error = nullptr);
+		
+		/**
+		 Returns root node of the document. If the document is not parsed yet,
+		 then returns invalid node.
+		 */
+		const JSONNode & root() const
+		{
+			return _root;
+		}
+		
+		/**
+		 Releases all nodes allocated in the document.
+		 */
+		void clear();
+		
+		/**
+		 Returns number of bytes allocated in the arena.
+		 */
+		size_t allocatedBytes() const
+		{
+			return _allocated_bytes;
+		}
+		
+	private:
+		
+		friend class detail::JSONDocumentBuilder;
+		
+		/**
+		 Block of memory in the arena. The data follows the structure.
+		 */
+		struct Block
+		{
+			Block * next;
+			size_t size;
+			size_t used;
+		};
+		
+		/**
+		 Allocates |size| bytes in the arena. The returned memory is aligned to 8 bytes.
+		 */
+		void * allocate(size_t size);
+		
+		Block * _blocks;
+		size_t _allocated_bytes;
+		size_t _next_block_size;
+		JSONNode _root;
+	};
+	
+} // cc7::tests
+} // cc7
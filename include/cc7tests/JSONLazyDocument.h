@@ -0,0 +1,167 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cc7tests/JSONPath.h>
+#include <map>
+
+namespace cc7
+{
+namespace tests
+{
+	/**
+	 The JSONLazyDocument class provides on-demand access to JSON document. Unlike
+	 JSON_ParseData(), the document is not parsed at once. Only the objects and arrays
+	 on the queried paths are scanned, and the boundaries of their members are recorded.
+	 The nested values are skipped with a fast scanner, which only matches the brackets
+	 and doesn't allocate memory. The selected value is then parsed into JSONValue
+	 and kept in the document, so the next query for the same value is cheap.
+	
+	 Because the skipped values are not validated, the syntax error in the document
+	 is reported only when the parser or the scanner touches it. The errors are reported
+	 with std::invalid_argument exception, like the other path related errors.
+	
+	 The document doesn't copy the data, so the data must be valid for the whole
+	 lifetime of the document. The class is not thread safe.
+	 */
+	class JSONLazyDocument
+	{
+	public:
+	
+		typedef JSONValue::Type Type;
+		
+		JSONLazyDocument();
+		
+		/**
+		 Constructs document with |data|. See load() method.
+		 */
+		explicit JSONLazyDocument(const cc7::ByteRange & data);
+		
+		/**
+		 Sets data of the document and clears all cached values. The data is not
+		 parsed, nor validated. The empty document has null value at root.
+		 */
+		void load(const cc7::ByteRange & data);
+		
+		/**
+		 Clears all data and cached values.
+		 */
+		void clear();
+		
+		/**
+		 Returns the whole document, parsed into JSONValue.
+		 */
+		const JSONValue & root() const;
+		
+		/**
+		 Returns value at |path|. See JSONPath for the syntax. The method throws
+		 std::invalid_argument if the path doesn't exist, if the selected value
+		 has unexpected type, or if the touched part of document is not valid.
+		 */
+		const JSONValue & valueAtPath(const std::string & path, Type expected_type = JSONValue::NaT) const;
+		const JSONValue & valueAtPath(const JSONPath & path, Type expected_type = JSONValue::NaT) const;
+		
+		/**
+		 Returns value at |path|, or nullptr if there's no such value. The method
+		 throws std::invalid_argument if the touched part of document is not valid.
+		 */
+		const JSONValue * find(const JSONPath & path) const;
+		
+		const JSONValue::TObject & objectAtPath(const std::string & path) const
+		{
+			return valueAtPath(path, JSONValue::Object).asObject();
+		}
+		
+		const JSONValue::TArray & arrayAtPath(const std::string & path) const
+		{
+			return valueAtPath(path, JSONValue::Array).asArray();
+		}
+		
+		JSONString stringAtPath(const std::string & path) const
+		{
+			return valueAtPath(path, JSONValue::String).asString();
+		}
+		
+		bool booleanAtPath(const std::string & path) const
+		{
+			return valueAtPath(path, JSONValue::Boolean).asBoolean();
+		}
+		
+		int64_t integerAtPath(const std::string & path) const
+		{
+			return valueAtPath(path, JSONValue::Integer).asInteger();
+		}
+		
+		double doubleAtPath(const std::string & path) const
+		{
+			return valueAtPath(path, JSONValue::Double).asDouble();
+		}
+		
+		/**
+		 Returns number of values parsed into JSONValue so far.
+		 */
+		size_t parsedValuesCount() const
+		{
+			return _values.size();
+		}
+		
+		/**
+		 Returns number of objects and arrays scanned so far.
+		 */
+		size_t scannedContainersCount() const
+		{
+			return _containers.size();
+		}
+	
+	private:
+	
+		// Boundaries of one value, or key, as offsets into the data.
+		struct Span
+		{
+			size_t	begin;
+			size_t	end;
+		};
+		
+		struct Member
+		{
+			Span	key;		// Key without quotes, empty for array elements
+			bool	escaped;	// Key contains escaped characters
+			Span	value;
+		};
+		
+		struct Container
+		{
+			std::vector<Member> members;
+		};
+		
+		cc7::ByteRange								_data;
+		mutable std::map<size_t, Container>			_containers;
+		mutable std::map<size_t, JSONValue>			_values;
+		
+		const JSONValue * select(const JSONPath & path, bool throw_error) const;
+		const Container & container(size_t begin) const;
+		const JSONValue & parsedValue(const Span & span) const;
+		bool isEqualKey(const Member & member, const std::string & key) const;
+		
+		size_t skipWhitespace(size_t offset) const;
+		size_t skipString(size_t offset) const;
+		size_t skipValue(size_t offset) const;
+		void throwError(size_t offset, const char * message) const;
+	};
+
+} // cc7::tests
+} // cc7
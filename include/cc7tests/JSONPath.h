@@ -0,0 +1,108 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cc7tests/JSONValue.h>
+
+namespace cc7
+{
+namespace tests
+{
+	class JSONNode;
+	
+	/**
+	 The JSONPath class is a compiled path to a value in JSON document. The path
+	 components are separated by dot and the array elements are selected with index
+	 in square brackets, for example "a.b[3].c", or "[0].name". The path is parsed
+	 only once, in the constructor, and the evaluation doesn't allocate memory.
+	 
+	 The valueAtPath() methods and all *AtPath() helpers in JSONValue and JSONNode
+	 classes compile the path only once and keep it in a small per-thread cache,
+	 so the repeated queries with the same path are cheap too.
+	 */
+	class JSONPath
+	{
+	public:
+		
+		/**
+		 Constructs an empty path, which selects the root value.
+		 */
+		JSONPath();
+		
+		/**
+		 Compiles the |path|. The constructor throws std::invalid_argument if the path
+		 is empty, or if it's not valid. The empty components are ignored, so "a..b"
+		 is the same path as "a.b".
+		 */
+		explicit JSONPath(const std::string & path);
+		
+		/**
+		 Returns the original path string.
+		 */
+		const std::string & path() const
+		{
+			return _path;
+		}
+		
+		/**
+		 Returns number of keys and indices in the path.
+		 */
+		size_t size() const
+		{
+			return _components.size();
+		}
+		
+		/**
+		 Returns value selected by the path in |root|. The method throws std::invalid_argument
+		 if there's no such value.
+		 */
+		const JSONValue & evaluate(const JSONValue & root) const;
+		const JSONNode & evaluate(const JSONNode & root) const;
+		
+		/**
+		 Returns value selected by the path in |root|, or nullptr if there's no such value.
+		 */
+		const JSONValue * find(const JSONValue & root) const;
+		const JSONNode * find(const JSONNode & root) const;
+		
+		/**
+		 Returns compiled |path| from the current thread's cache. The path is compiled
+		 and added to the cache, if it's not there yet. The returned reference is valid
+		 only until the next call to this method on the same thread.
+		 */
+		static const JSONPath & cachedPath(const std::string & path);
+		
+	private:
+		
+		struct Component
+		{
+			std::string	key;
+			size_t		index;
+			bool		is_index;
+		};
+		
+		std::string				_path;
+		std::vector<Component>	_components;
+		
+		template <typename T>
+		const T * select(const T & root, bool throw_error) const;
+		
+		friend class JSONLazyDocument;
+	};
+	
+} // cc7::tests
+} // cc7
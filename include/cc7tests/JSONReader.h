@@ -30,10 +30,46 @@ namespace tests
 	class TestFile;
 	class TestDirectory;
 	
+	/**
+	 The JSONHandler is an interface for streaming (SAX-style) parsing. The parser
+	 reports all parsed values to the handler, in the order of appearance in the document,
+	 so no DOM is created. The default implementation of all methods just returns true,
+	 so you can override only methods you're interested in. If the method returns false,
+	 then the parsing is stopped and the parser reports an error.
+	 
+	 The ranges passed to key() and stringValue() points directly to the parsed data,
+	 if the string contains no escaped characters. Otherwise the range points to a temporary
+	 buffer with the unescaped string. In both cases, the range is guaranteed to be valid
+	 only during the call.
+	 */
+	class JSONHandler
+	{
+	public:
+		virtual ~JSONHandler() {}
+		
+		virtual bool startObject()									{ return true; }
+		virtual bool key(const cc7::ByteRange & /*key*/)			{ return true; }
+		virtual bool endObject(size_t /*members_count*/)			{ return true; }
+		virtual bool startArray()									{ return true; }
+		virtual bool endArray(size_t /*elements_count*/)			{ return true; }
+		virtual bool stringValue(const cc7::ByteRange & /*value*/)	{ return true; }
+		virtual bool integerValue(int64_t /*value*/)				{ return true; }
+		virtual bool doubleValue(double /*value*/)					{ return true; }
+		virtual bool booleanValue(bool /*value*/)					{ return true; }
+		virtual bool nullValue()									{ return true; }
+	};
+	
 	bool JSON_ParseString(const std::string & str, JSONValue & out_value, std::string * out_error = nullptr);
 	
 	bool JSON_ParseData(const cc7::ByteRange & range, JSONValue & out_value, std::string * out_error = nullptr);
 	
+	/**
+	 Parses JSON document from |range| and reports all parsed values to the |handler|.
+	 The empty document produces no events. Returns false and sets |out_error| if
+	 the document is not valid, or if the handler stopped the parsing.
+	 */
+	bool JSON_ParseData(const cc7::ByteRange & range, JSONHandler & handler, std::string * out_error = nullptr);
+	
 	JSONValue JSON_ParseFile(const TestDirectory & dir, const std::string & file_name);
 	
 } // cc7::tests
@@ -0,0 +1,167 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cc7tests/JSONReader.h>
+#include <functional>
+#include <memory>
+
+namespace cc7
+{
+namespace tests
+{
+	/**
+	 The JSONStreamParser is a resumable JSON parser, which accepts the document in chunks,
+	 for example, as it's read from the pipe or from the large file. Unlike JSON_ParseData(),
+	 the parser doesn't use the recursion. The whole parser's state is kept in the object,
+	 so the parsing can be paused at any byte, even in the middle of string or number.
+	
+	 The stream may contain a sequence of top-level values, separated by whitespaces.
+	 The parser reports the values in two ways:
+	
+	  - All values are reported as SAX events to JSONHandler, as soon as they're parsed.
+	  - Each complete top-level value is built into JSONValue and passed to the callback.
+	
+	 The parser keeps only the stack of open objects and arrays and the currently parsed
+	 token, if the token is split between the chunks, or if it contains escaped characters.
+	 So, in the handler mode, the memory is bounded by the nesting depth and the longest
+	 string or number in the stream.
+	 */
+	class JSONStreamParser
+	{
+	public:
+	
+		/**
+		 The callback receives complete top-level values. If the callback returns false,
+		 then the parsing is stopped and the parser reports an error.
+		 */
+		typedef std::function<bool(JSONValue && value)> ValueCallback;
+		
+		/**
+		 Constructs parser which reports all parsed values to |handler|. The handler
+		 must be valid for the whole lifetime of the parser.
+		 */
+		explicit JSONStreamParser(JSONHandler & handler);
+		
+		/**
+		 Constructs parser which passes complete top-level values to |callback|.
+		 */
+		explicit JSONStreamParser(const ValueCallback & callback);
+		
+		~JSONStreamParser();
+		
+		/**
+		 Parses next chunk of the stream. The chunk may end anywhere. The chunk's data
+		 doesn't need to be valid after the call. Returns false if the stream is not valid,
+		 or if the handler stopped the parsing. Once the error is reported, the parser
+		 ignores all following data, until reset() is called.
+		 */
+		bool feed(const cc7::ByteRange & chunk);
+		
+		/**
+		 Signals the end of the stream. Completes the number at the end of the stream
+		 and returns false if the last value is not complete.
+		 */
+		bool finish();
+		
+		/**
+		 Resets the parser, so it can parse a new stream.
+		 */
+		void reset();
+		
+		/**
+		 Returns error description, or empty string if there's no error.
+		 */
+		const std::string & error() const
+		{
+			return _error;
+		}
+		
+		/**
+		 Returns number of complete top-level values.
+		 */
+		size_t valuesCount() const
+		{
+			return _values_count;
+		}
+		
+		/**
+		 Returns number of currently open objects and arrays.
+		 */
+		size_t depth() const
+		{
+			return _stack.size();
+		}
+	
+	private:
+	
+		enum State
+		{
+			Value,			// Value is expected
+			FirstElement,	// Value or ']' is expected
+			FirstKey,		// Key or '}' is expected
+			Key,			// Key is expected
+			Colon,			// ':' is expected
+			AfterValue,		// ',' or end of object or array is expected
+			String,			// Inside the string, or key
+			StringEscape,	// After backslash in the string
+			StringUnicode,	// Inside \uXXXX sequence
+			Number,			// Inside the number
+			Literal,		// Inside true, false, or null
+			Failed			// Error occured
+		};
+		
+		struct Level
+		{
+			bool	is_object;
+			size_t	count;
+		};
+		
+		class ValueBuilder;
+		
+		JSONHandler *					_handler;
+		ValueCallback					_callback;
+		std::unique_ptr<ValueBuilder>	_builder;
+		
+		State				_state;
+		std::vector<Level>	_stack;
+		std::string			_token;			// Split, or unescaped token
+		bool				_buffered;		// Token is collected in _token
+		bool				_is_key;		// The string is key
+		const char *		_literal;
+		size_t				_literal_offset;
+		cc7::U32			_codepoint;
+		size_t				_codepoint_digits;
+		
+		size_t				_values_count;
+		size_t				_offset;		// Offset of the current chunk in the stream
+		size_t				_line;
+		size_t				_line_begin;
+		std::string			_error;
+		
+		bool startValue(cc7::byte c, size_t offset);
+		bool endContainer(bool is_object, size_t offset);
+		bool endValue(size_t offset);
+		bool endString(const cc7::ByteRange & string, size_t offset);
+		bool endNumber(const cc7::ByteRange & number, size_t offset);
+		bool appendEscaped(cc7::byte c, size_t offset);
+		bool checkHandler(bool result, size_t offset);
+		bool setError(const char * reason, size_t offset);
+	};
+
+} // cc7::tests
+} // cc7
@@ -17,14 +17,114 @@
 #pragma once
 
 #include <cc7/ByteArray.h>
-#include <map>
+#include <cc7tests/detail/JSONFlatMap.h>
 #include <vector>
 #include <stdexcept>
+#include <utility>
+#include <new>
+#include <string.h>
 
 namespace cc7
 {
 namespace tests
 {	
+	class JSONPath;
+	
+	/**
+	 The JSONString is a read only reference to the string stored in JSONValue.
+	 The referenced characters are always terminated with zero. The reference
+	 is valid until the value is changed or destroyed.
+	 */
+	class JSONString
+	{
+	public:
+		
+		static const size_t npos = std::string::npos;
+		
+		JSONString() : _data(""), _size(0) {}
+		JSONString(const char * data, size_t size) : _data(data), _size(size) {}
+		
+		const char * data() const		{ return _data; }
+		const char * c_str() const		{ return _data; }
+		size_t size() const				{ return _size; }
+		size_t length() const			{ return _size; }
+		bool empty() const				{ return _size == 0; }
+		const char * begin() const		{ return _data; }
+		const char * end() const		{ return _data + _size; }
+		
+		char operator[](size_t index) const
+		{
+			return _data[index];
+		}
+		
+		/**
+		 Returns position of the first occurence of |str| at or after |pos|,
+		 or npos if there's no such occurence.
+		 */
+		size_t find(const char * str, size_t pos = 0) const
+		{
+			const size_t str_size = strlen(str);
+			if (pos > _size || str_size > _size - pos) {
+				return npos;
+			}
+			for (size_t i = pos; i <= _size - str_size; i++) {
+				if (memcmp(_data + i, str, str_size) == 0) {
+					return i;
+				}
+			}
+			return npos;
+		}
+		
+		bool equals(const char * data, size_t size) const
+		{
+			return _size == size && memcmp(_data, data, size) == 0;
+		}
+		
+		/**
+		 Returns the referenced characters as a byte range, without the terminating zero.
+		 */
+		cc7::ByteRange range() const
+		{
+			return cc7::ByteRange(_data, _size);
+		}
+		
+		/**
+		 Returns copy of the referenced string.
+		 */
+		std::string str() const
+		{
+			return std::string(_data, _size);
+		}
+		
+		operator std::string() const
+		{
+			return str();
+		}
+	
+	private:
+		
+		const char *	_data;
+		size_t			_size;
+	};
+	
+	inline bool operator==(const JSONString & a, const JSONString & b)	{ return a.equals(b.data(), b.size()); }
+	inline bool operator==(const JSONString & a, const std::string & b)	{ return a.equals(b.data(), b.size()); }
+	inline bool operator==(const std::string & a, const JSONString & b)	{ return b.equals(a.data(), a.size()); }
+	inline bool operator==(const JSONString & a, const char * b)		{ return a.equals(b, strlen(b)); }
+	inline bool operator==(const char * a, const JSONString & b)		{ return b.equals(a, strlen(a)); }
+	
+	inline bool operator!=(const JSONString & a, const JSONString & b)	{ return !(a == b); }
+	inline bool operator!=(const JSONString & a, const std::string & b)	{ return !(a == b); }
+	inline bool operator!=(const std::string & a, const JSONString & b)	{ return !(a == b); }
+	inline bool operator!=(const JSONString & a, const char * b)		{ return !(a == b); }
+	inline bool operator!=(const char * a, const JSONString & b)		{ return !(a == b); }
+	
+	inline std::string operator+(const JSONString & a, const std::string & b)	{ return a.str().append(b); }
+	inline std::string operator+(const std::string & a, const JSONString & b)	{ return std::string(a).append(b.data(), b.size()); }
+	inline std::string operator+(const JSONString & a, const char * b)			{ return a.str().append(b); }
+	inline std::string operator+(const char * a, const JSONString & b)			{ return std::string(a).append(b.data(), b.size()); }
+	
+	
 	class JSONValue
 	{
 	public:
@@ -43,38 +143,55 @@ namespace tests
 			Null    = 1 << 6
 		};
 		
-		typedef std::map<std::string, JSONValue> TObject;
+		/**
+		 The object is a vector of members sorted by key, with std::map compatible
+		 interface for lookups and iteration. See detail::JSONFlatMap.
+		 */
+		typedef detail::JSONFlatMap<JSONValue> TObject;
 		typedef std::vector<JSONValue> TArray;
 		typedef std::string TString;
 		
 		
-		JSONValue()						: _t(NaT), _integer(0) {}
+		JSONValue()
+		{
+			initialize(NaT);
+		}
 		
-		JSONValue(Type t)				: _t(t), _integer(0)
+		JSONValue(Type t)
 		{
-			switch (_t) {
-				case String: _string = new TString(); break;
-				case Object: _object = new TObject(); break;
-				case Array:  _array  = new TArray();  break;
-				default:
-					break;
-			}
+			initialize(NaT);
+			construct(t);
 		}
 		
-		explicit JSONValue(bool v)		: _t(Boolean), _boolean(v) {}
-		explicit JSONValue(int64_t v)	: _t(Integer), _integer(v) {}
-		explicit JSONValue(double v)	: _t(Double),  _double(v) {}
+		explicit JSONValue(bool v)
+		{
+			initialize(Boolean);
+			_v.boolean = v;
+		}
+		
+		explicit JSONValue(int64_t v)
+		{
+			initialize(Integer);
+			_v.integer = v;
+		}
+		
+		explicit JSONValue(double v)
+		{
+			initialize(Double);
+			_v.real = v;
+		}
 		
 		// Copy / Move
 		
 		JSONValue(const JSONValue & o)
 		{
+			initialize(NaT);
 			copyFrom(o);
 		}
 		
-		JSONValue(JSONValue && o) : _t(o._t), _integer(o._integer)
+		JSONValue(JSONValue && o) noexcept
 		{
-			o._t = NaT;
+			moveFrom(o);
 		}
 		
 		JSONValue & operator=(const JSONValue & o)
@@ -86,11 +203,12 @@ namespace tests
 			return *this;
 		}
 		
-		JSONValue & operator=(JSONValue && o)
+		JSONValue & operator=(JSONValue && o) noexcept
 		{
-			_t = o._t;
-			_integer = o._integer;
-			o._t = NaT;
+			if (&o != this) {
+				destroy();
+				moveFrom(o);
+			}
 			return *this;
 		}
 
@@ -106,123 +224,152 @@ namespace tests
 		void assign(bool value)
 		{
 			destroy();
-			_t = Boolean;
-			_boolean = value;
+			_v.type = Boolean;
+			_v.boolean = value;
 		}
 		
 		void assign(int64_t value)
 		{
 			destroy();
-			_t = Integer;
-			_integer = value;
+			_v.type = Integer;
+			_v.integer = value;
 		}
 
 		void assign(double value)
 		{
 			destroy();
-			_t = Double;
-			_double = value;
+			_v.type = Double;
+			_v.real = value;
+		}
+		
+		/**
+		 Changes value to string with |length| characters from |value|. The characters
+		 may point to this value's own string.
+		 */
+		void assign(const char * value, size_t length);
+		
+		void assign(const char * value)
+		{
+			assign(value, strlen(value));
 		}
 		
 		void assign(const TString & value)
 		{
-			destroy();
-			_t = String;
-			_string = new TString(value);
+			assign(value.data(), value.size());
+		}
+		
+		void assign(const JSONString & value)
+		{
+			assign(value.data(), value.size());
 		}
 
 		void assign(const TObject & value)
 		{
-			destroy();
-			_t = Object;
-			_object = new TObject(value);
+			objectStorage() = value;
+		}
+		
+		void assign(TObject && value)
+		{
+			objectStorage() = std::move(value);
 		}
 
 		void assign(const TArray & value)
 		{
-			destroy();
-			_t = Array;
-			_array = new TArray(value);
+			arrayStorage() = value;
+		}
+		
+		void assign(TArray && value)
+		{
+			arrayStorage() = std::move(value);
 		}
 		
 		void assignNull()
 		{
 			destroy();
-			_t = Null;
+			_v.type = Null;
 		}
 		
 		// casting
 		
 		const TObject & asObject() const
 		{
-			castToPtrType(Object);
-			return *_object;
+			castToType(Object);
+			return _v.object ? *_v.object : emptyObject();
 		}
 		
 		TObject & asMutableObject()
 		{
-			castToPtrType(Object);
-			return *_object;
+			castToType(Object);
+			return objectStorage();
 		}
 		
 		const TArray & asArray() const
 		{
-			castToPtrType(Array);
-			return *_array;
+			castToType(Array);
+			return _v.array ? *_v.array : emptyArray();
 		}
 		
 		TArray & asMutableArray()
 		{
-			castToPtrType(Array);
-			return *_array;
-		}
-
-		const TString & asString() const
-		{
-			castToPtrType(String);
-			return *_string;
+			castToType(Array);
+			return arrayStorage();
 		}
 		
-		TString & asMutableString()
+		JSONString asString() const
 		{
-			castToPtrType(String);
-			return *_string;
+			castToType(String);
+			if (_v.inline_length == kHeapString) {
+				return JSONString(_v.string->chars, _v.string->length);
+			}
+			return JSONString(_s.chars, _s.inline_length);
 		}
 
 		double asDouble() const
 		{
 			castToType(Double);
-			return _double;
+			return _v.real;
 		}
 		
 		int64_t asInteger() const
 		{
 			castToType(Integer);
-			return _integer;
+			return _v.integer;
 		}
 		
 		bool asBoolean() const
 		{
 			castToType(Boolean);
-			return _boolean;
+			return _v.boolean;
+		}
+		
+		Type type() const
+		{
+			return static_cast<Type>(_v.type);
 		}
 		
 		bool isNull() const
 		{
-			return _t == Null;
+			return _v.type == Null;
 		}
 		
 		bool isValid() const
 		{
-			return _t != NaT;
+			return _v.type != NaT;
 		}
 		
 		bool isType(Type t) const
 		{
-			return _t == t;
+			return _v.type == t;
 		}
 		
+		/**
+		 Returns value at |path|. The path is compiled only once and then it's kept
+		 in a small per-thread cache. See JSONPath for the syntax. The method throws
+		 std::invalid_argument if the path doesn't exist or if the selected value
+		 has unexpected type.
+		 */
 		const JSONValue & valueAtPath(const std::string & path, Type expected_type = NaT) const;
+		const JSONValue & valueAtPath(const JSONPath & path, Type expected_type = NaT) const;
 		
 		const JSONValue::TObject & objectAtPath(const std::string & path) const
 		{
@@ -234,7 +381,7 @@ namespace tests
 			return valueAtPath(path, Array).asArray();
 		}
 		
-		const JSONValue::TString & stringAtPath(const std::string & path) const
+		JSONString stringAtPath(const std::string & path) const
 		{
 			return valueAtPath(path, String).asString();
 		}
@@ -260,60 +407,161 @@ namespace tests
 		
 	private:
 		
+		// Private types
+		
+		/*
+		 The value has 16 bytes. Both layouts begin with the type and the string's
+		 length, so these can be read regardless of which layout is used. The strings
+		 up to kInlineCapacity characters are stored in the value, the longer strings
+		 in a separate heap block. The arrays and objects are behind the pointer,
+		 which is null while the container is empty.
+		 */
+		struct HeapString
+		{
+			size_t		length;
+			size_t		capacity;
+			char		chars[1];
+		};
+		
+		static const size_t kInlineCapacity = 13;
+		static const cc7::byte kHeapString = 0xFF;
+		
+		struct ScalarLayout
+		{
+			cc7::byte	type;
+			cc7::byte	inline_length;
+			union
+			{
+				bool			boolean;
+				int64_t			integer;
+				double			real;
+				HeapString *	string;
+				TObject *		object;
+				TArray *		array;
+			};
+		};
+		
+		struct InlineLayout
+		{
+			cc7::byte	type;
+			cc7::byte	inline_length;
+			char		chars[kInlineCapacity + 1];
+		};
+		
 		// Private members
 		
-		Type _t;
 		union
 		{
-			bool		_boolean;
-			int64_t		_integer;
-			double		_double;
-			TObject *	_object;
-			TArray *	_array;
-			TString *	_string;
+			ScalarLayout	_v;
+			InlineLayout	_s;
 		};
 		
 		// Private methods
 		
-		void destroy()
+		void initialize(Type t) noexcept
 		{
-			switch (_t) {
-				case Object: delete _object; break;
-				case Array:  delete _array; break;
-				case String: delete _string; break;
+			_v.type = t;
+			_v.inline_length = 0;
+			_v.integer = 0;
+		}
+		
+		/**
+		 Changes type of the value to |t|. If the value already has such type,
+		 then the content is kept, so the container's capacity can be reused.
+		 */
+		void construct(Type t)
+		{
+			if (_v.type == t) {
+				return;
+			}
+			destroy();
+			if (t == String) {
+				_s.chars[0] = 0;
+			}
+			_v.type = t;
+		}
+		
+		/**
+		 Changes type of the value to object, or array, and returns its container.
+		 The container is allocated on the first access.
+		 */
+		TObject & objectStorage()
+		{
+			construct(Object);
+			if (!_v.object) {
+				_v.object = new TObject();
+			}
+			return *_v.object;
+		}
+		
+		TArray & arrayStorage()
+		{
+			construct(Array);
+			if (!_v.array) {
+				_v.array = new TArray();
+			}
+			return *_v.array;
+		}
+		
+		void destroy() noexcept
+		{
+			switch (_v.type) {
+				case Object: delete _v.object; break;
+				case Array:  delete _v.array; break;
+				case String:
+					if (_v.inline_length == kHeapString) {
+						::operator delete(_v.string);
+					}
+					break;
 				default:
 					break;
 			}
-			_integer = 0;
+			initialize(NaT);
 		}
 		
 		void copyFrom(const JSONValue & o)
 		{
-			_t = o._t;
-			switch (o._t) {
-				case String: _string = new TString(*o._string);	break;
-				case Object: _object = new TObject(*o._object); break;
-				case Array:  _array  = new TArray(*o._array);   break;
+			switch (o._v.type) {
+				case String:
+					if (o._v.inline_length == kHeapString) {
+						assign(o._v.string->chars, o._v.string->length);
+						return;
+					}
+					break;
+				case Object:
+					if (o._v.object) {
+						objectStorage() = *o._v.object;
+						return;
+					}
+					break;
+				case Array:
+					if (o._v.array) {
+						arrayStorage() = *o._v.array;
+						return;
+					}
+					break;
 				default:
-					_integer = o._integer;
 					break;
 			}
+			memcpy(&_s, &o._s, sizeof(_s));
 		}
 		
-		inline void castToType(int t) const
+		void moveFrom(JSONValue & o) noexcept
 		{
-			if ((_t & t) == 0) {
-				throw std::logic_error("Unable to cast to type");
-			}
+			// The heap blocks are owned by the target now.
+			memcpy(&_s, &o._s, sizeof(_s));
+			o.initialize(NaT);
 		}
 		
-		inline void castToPtrType(int t) const
+		inline void castToType(int t) const
 		{
-			castToType(t);
-			if (_object == nullptr) {
-				throw std::logic_error("Internal pointer is null");
+			if ((_v.type & t) == 0) {
+				throw std::logic_error("Unable to cast to type");
 			}
 		}
+		
+		static const TObject & emptyObject();
+		static const TArray & emptyArray();
 	};
 	
 } // cc7::tests
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cc7tests/JSONReader.h>
+#include <functional>
+
+namespace cc7
+{
+namespace tests
+{
+	/**
+	 The JSONWriter class serializes JSON document. The writer implements JSONHandler
+	 interface, so you can produce the document with calls to the handler methods,
+	 or you can pass the writer directly to the JSON_ParseData() to reformat the document
+	 without building DOM. The complete JSONValue can be written with value() method.
+	
+	 The writer keeps the output in an internal buffer, which is reused after reset().
+	 If the sink is provided, then the buffer is passed to the sink each time it reaches
+	 the configured size, so the memory usage doesn't depend on the size of the document.
+	
+	 The doubles are written in round-trip exact form, so they're parsed back to the same
+	 value. The form is typically, but not always, the shortest one. NaN and infinity cannot
+	 be represented in JSON, so they're written as null. The writer produces exactly one
+	 top-level value. All methods return false if the call is not valid in the current
+	 state, for example when key() is called in an array, or when the top-level value is
+	 already complete.
+	 */
+	class JSONWriter : public JSONHandler
+	{
+	public:
+	
+		enum Mode
+		{
+			/**
+			 No whitespaces between the tokens.
+			 */
+			Compact,
+			/**
+			 Each value on its own line, indented with two spaces per level.
+			 */
+			Pretty
+		};
+		
+		typedef std::function<void(const char * data, size_t size)> Sink;
+		
+		/**
+		 Constructs writer which keeps the whole output in its internal buffer.
+		 */
+		JSONWriter(Mode mode = Compact);
+		
+		/**
+		 Constructs writer which passes the output to the |sink|, in chunks
+		 of approximately |buffer_size| bytes. Don't forget to call flush() after
+		 the document is written.
+		 */
+		JSONWriter(const Sink & sink, Mode mode = Compact, size_t buffer_size = 16 * 1024);
+		
+		// JSONHandler
+		
+		bool startObject() override;
+		bool key(const cc7::ByteRange & key) override;
+		bool endObject(size_t members_count) override;
+		bool startArray() override;
+		bool endArray(size_t elements_count) override;
+		bool stringValue(const cc7::ByteRange & value) override;
+		bool integerValue(int64_t value) override;
+		bool doubleValue(double value) override;
+		bool booleanValue(bool value) override;
+		bool nullValue() override;
+		
+		// Convenience methods
+		
+		bool key(const std::string & key)			{ return this->key(cc7::MakeRange(key)); }
+		bool key(const char * key)					{ return this->key(cc7::MakeRange(key)); }
+		bool endObject()							{ return endObject(0); }
+		bool endArray()								{ return endArray(0); }
+		bool stringValue(const std::string & value)	{ return stringValue(cc7::MakeRange(value)); }
+		bool stringValue(const char * value)		{ return stringValue(cc7::MakeRange(value)); }
+		
+		/**
+		 Writes the whole |value|, including all nested values. The NaT
+		 value is written as null.
+		 */
+		bool value(const JSONValue & value);
+		
+		// Output
+		
+		/**
+		 Passes all buffered output to the sink. The method does nothing
+		 if the writer has no sink.
+		 */
+		void flush();
+		
+		/**
+		 Returns the output produced since the last reset(). If the writer has
+		 a sink, then returns only the output which was not passed to the sink yet.
+		 */
+		const std::string & output() const
+		{
+			return _buffer;
+		}
+		
+		/**
+		 Clears the output and the writer's state, so the writer can be used
+		 for another document. The allocated buffer is kept for the next use.
+		 */
+		void reset();
+	
+	private:
+	
+		struct Level
+		{
+			bool	is_object;
+			size_t	count;
+		};
+		
+		Mode				_mode;
+		Sink				_sink;
+		size_t				_buffer_size;
+		std::string			_buffer;
+		std::vector<Level>	_stack;
+		bool				_after_key;
+		bool				_root_done;		// The top-level value is complete
+		
+		bool beginValue();
+		bool endValue();
+		bool startContainer(bool is_object, char bracket);
+		bool endContainer(bool is_object, char bracket);
+		void writeNewLine(size_t depth);
+		void writeString(const cc7::byte * p, size_t length);
+	};
+	
+	/**
+	 Returns serialized |value|.
+	 */
+	std::string JSON_Serialize(const JSONValue & value, JSONWriter::Mode mode = JSONWriter::Compact);
+
+} // cc7::tests
+} // cc7
@@ -23,28 +23,156 @@ namespace cc7
 {
 namespace tests
 {
+	/**
+	 The PerformanceCounters structure contains values of hardware performance
+	 counters, measured for a block of code. Not all platforms and environments
+	 provide the counters, so you should always check whether the particular
+	 counter is available.
+	 */
+	struct PerformanceCounters
+	{
+		enum Counter
+		{
+			Cycles = 0,
+			Instructions,
+			BranchMisses,
+			L1DMisses,
+			LLCMisses,
+	
+			CountersCount
+		};
+		
+		PerformanceCounters() :
+			available(0)
+		{
+			for (size_t i = 0; i < CountersCount; i++) {
+				values[i] = 0;
+			}
+		}
+		
+		/**
+		 Returns true if the |counter| has a valid value.
+		 */
+		bool isAvailable(Counter counter) const
+		{
+			return (available & (1 << counter)) != 0;
+		}
+		
+		/**
+		 Returns true if at least one counter is available.
+		 */
+		bool isAnyAvailable() const
+		{
+			return available != 0;
+		}
+		
+		/**
+		 Returns short name of the |counter|.
+		 */
+		static const char * counterName(Counter counter);
+		
+		/**
+		 Bit mask with available counters.
+		 */
+		cc7::U32 available;
+		/**
+		 Values of all counters.
+		 */
+		cc7::U64 values[CountersCount];
+	};
 	
+	
+	/**
+	 The PerformanceTimer measures elapsed time. If the CPU provides a constant rate
+	 cycle counter (invariant TSC on x86, CNTVCT on ARM64), then the timer reads
+	 the counter directly, instead of calling OS clock functions. The counter's frequency
+	 is calibrated against the OS clock, when the first timer is created.
+	 */
 	class PerformanceTimer
 	{
 	public:
 		PerformanceTimer();
 		
 		void	start();
+		/**
+		 Returns time elapsed since start, in milliseconds.
+		 */
 		double	elapsedTime();
-		double	measureBlock(std::function<void()> block);
+		/**
+		 Returns number of timer ticks elapsed since start. If the cycle counter is
+		 available, then the ticks are CPU counter cycles.
+		 */
+		cc7::U64 elapsedTicks();
+		/**
+		 Returns time elapsed since start, in nanoseconds. The overhead of the timer
+		 itself is subtracted from the result.
+		 */
+		double	elapsedNanoseconds();
+		/**
+		 Measures execution time of |block|. If |out_counters| is provided, then also
+		 the hardware performance counters are measured for the block. If the counters
+		 are not available, then the |out_counters| has no counter available and
+		 only the time is measured.
+		 */
+		double	measureBlock(std::function<void()> block, PerformanceCounters * out_counters = nullptr);
 		
 		static std::string humanReadableTime(double time);
 		
+		/**
+		 Returns true if timer uses the CPU cycle counter.
+		 */
+		static bool			hasCycleCounter();
+		/**
+		 Returns name of timer's backend. The name is "tsc", "cntvct", or "os".
+		 */
+		static const char *	backendName();
+		/**
+		 Converts number of ticks to nanoseconds.
+		 */
+		static double		ticksToNanoseconds(cc7::U64 ticks);
+		/**
+		 Returns overhead of start & stop timer sequence, in ticks.
+		 */
+		static cc7::U64		overheadTicks();
+		
 	private:
 		
 		cc7::U64 _base;
 	};
 	
 	
-	// Following two functions must have platform specific implementation.
+	// Following functions must have platform specific implementation.
 	
 	cc7::U64	Platform_GetCurrentTime();
 	double		Platform_GetTimeDiff(cc7::U64 start, cc7::U64 future);
 	
+	/**
+	 Returns CPU time consumed by the calling thread, in milliseconds.
+	 */
+	double		Platform_GetThreadCPUTime();
+	
+	/**
+	 Returns human readable CPU model, or empty string if the model cannot be determined.
+	 */
+	std::string	Platform_GetCPUModel();
+	
+	/**
+	 Pins the calling thread to CPU core with |cpu_index|. Returns false if the
+	 operation is not supported on the platform, or if it failed.
+	 */
+	bool		Platform_PinCurrentThread(size_t cpu_index);
+	
+	/**
+	 Starts hardware performance counters for the calling thread. Returns an opaque
+	 handle, or nullptr if the counters are not available on the platform.
+	 */
+	void *		Platform_StartPerformanceCounters();
+	
+	/**
+	 Stops counters, previously started with Platform_StartPerformanceCounters(), stores
+	 values to |out_counters| and releases the |handle|.
+	 */
+	void		Platform_StopPerformanceCounters(void * handle, PerformanceCounters & out_counters);
+	
 } // cc7::tests
 } // cc7
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cc7/Platform.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+namespace cc7
+{
+namespace tests
+{
+	namespace detail
+	{
+		class SamplingProfilerBackend;
+	}
+	
+	/**
+	 The SamplingProfiler class implements a simple statistical profiler. When the profiler
+	 is running, the process is periodically interrupted by SIGPROF signal and the call stack
+	 of the interrupted thread is captured into a preallocated buffer. After the profiling,
+	 you can export all captured stacks in the "folded" format, which is accepted by
+	 flamegraph.pl, speedscope and similar tools.
+	 
+	 Only one profiler can be running at the same time. The profiler is currently supported
+	 only on Linux and Android platforms. For a better symbolication, you should link
+	 the executable with "-rdynamic" flag, so the function names are available to dladdr().
+	 
+	 The stacks are captured by walking the chain of frame pointers, because the regular
+	 unwinder is not async-signal-safe. So, the code should be compiled with
+	 "-fno-omit-frame-pointer" flag, otherwise the stacks are incomplete. The full stack
+	 is captured only for the thread which started the profiler. For all other threads,
+	 only the interrupted function is reported. On 32-bit ARM, only the interrupted
+	 function is reported for all threads.
+	 */
+	class SamplingProfiler
+	{
+	public:
+		
+		/**
+		 Constructs a new profiler. The |max_samples| and |max_depth| parameters are
+		 used for the preallocation of the buffer, when the profiler starts.
+		 */
+		SamplingProfiler(size_t max_samples = 16384, size_t max_depth = 64);
+		~SamplingProfiler();
+		
+		/**
+		 Returns true if profiler is supported on the platform.
+		 */
+		static bool isSupported();
+		
+		/**
+		 Starts profiling with |frequency| samples per second of the consumed CPU time.
+		 Returns false if profiler is not supported, or other profiler is already running.
+		 The previously captured samples are kept in the buffer.
+		 */
+		bool start(unsigned int frequency = 997);
+		
+		/**
+		 Stops the profiling.
+		 */
+		void stop();
+		
+		/**
+		 Returns true if profiler is running.
+		 */
+		bool isRunning() const;
+		
+		/**
+		 Sets label for the following samples. The label is reported as the root frame
+		 in the folded stacks. The |label| must be a string with static lifetime, or
+		 at least must be valid until the samples are exported. Use nullptr to clear
+		 the label.
+		 */
+		void setLabel(const char * label);
+		
+		/**
+		 Removes all captured samples.
+		 */
+		void clear();
+		
+		/**
+		 Returns number of captured samples.
+		 */
+		size_t samplesCount() const;
+		
+		/**
+		 Returns number of samples dropped due to full buffer.
+		 */
+		size_t droppedSamplesCount() const;
+		
+		/**
+		 Returns captured samples in the folded stacks format. Each line contains
+		 semicolon separated frames, from the root to the leaf, followed by a space
+		 and number of samples with the same stack.
+		 */
+		std::string foldedStacks() const;
+		
+	private:
+		
+		// Not copyable
+		SamplingProfiler(const SamplingProfiler &) = delete;
+		SamplingProfiler & operator=(const SamplingProfiler &) = delete;
+		
+		friend class detail::SamplingProfilerBackend;
+		
+		/**
+		 Captures one sample. The method is called from the signal handler.
+		 */
+		void captureSample(void * signal_context);
+		
+		size_t _max_samples;
+		size_t _max_depth;
+		bool _running;
+		
+		std::vector<uintptr_t> _frames;
+		std::vector<cc7::U32> _depths;
+		std::vector<const char*> _labels;
+		std::atomic<size_t> _next_sample;
+		std::atomic<size_t> _dropped_samples;
+		std::atomic<const char*> _label;
+	};
+	
+} // cc7::tests
+} // cc7
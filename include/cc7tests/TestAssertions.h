@@ -115,6 +115,101 @@
 	}
 
 
+/**
+ Triggers failure when evaluation of the block causes more reallocations in
+ the CleanupAllocator than |max_count|. The block is typically a function call,
+ for example: ccstAssertMaxReallocations(Base64_Decode(str, 0, data), 0).
+ The macro compares the statistics before and after the block, so the statistics
+ of the current thread are not reset.
+ 
+ If the library is not compiled with ENABLE_CC7_ALLOCATION_STATS, then the block
+ is only evaluated.
+ */
+#if defined(ENABLE_CC7_ALLOCATION_STATS)
+#define ccstAssertMaxReallocations(block, max_count, ...)												\
+	{																									\
+		cc7::U64 ccst_reallocs_before_ = cc7::debug::GetAllocationStats().reallocations;				\
+		block;																							\
+		cc7::U64 ccst_reallocs_ = cc7::debug::GetAllocationStats().reallocations - ccst_reallocs_before_;\
+		if (ccst_reallocs_ > (cc7::U64)(max_count)) {													\
+			this->tl().logFormattedMessage("Reallocations: %llu", (unsigned long long)ccst_reallocs_);	\
+			this->tl().logIncident(__FILE__, __LINE__, "reallocations(" #block ") <= " #max_count, "" __VA_ARGS__);\
+		}																								\
+	}
+#else
+#define ccstAssertMaxReallocations(block, max_count, ...)												\
+	{																									\
+		block;																							\
+	}
+#endif
+
+
+/**
+ Triggers failure when evaluation of the block causes more heap allocations than
+ |max_count|. The block is typically a function call, for example:
+ ccstAssertMaxAllocations(Base64_Decode(str, 0, data), 1). The macro compares
+ the counters before and after the block, so the per-method allocation report
+ still contains all allocations made by the test.
+ 
+ If the allocation counters are not available (see cc7::tests::AllocationCountersAvailable()),
+ then the block is only evaluated.
+ */
+#define ccstAssertMaxAllocations(block, max_count, ...)													\
+	{																									\
+		cc7::U64 ccst_allocs_before_ = cc7::tests::GetAllocationCounters().allocations;					\
+		block;																							\
+		cc7::U64 ccst_allocs_ = cc7::tests::GetAllocationCounters().allocations - ccst_allocs_before_;	\
+		if (cc7::tests::AllocationCountersAvailable() && ccst_allocs_ > (cc7::U64)(max_count)) {		\
+			this->tl().logFormattedMessage("Allocations: %llu", (unsigned long long)ccst_allocs_);		\
+			this->tl().logIncident(__FILE__, __LINE__, "allocations(" #block ") <= " #max_count, "" __VA_ARGS__);\
+		}																								\
+	}
+
+/**
+ Triggers failure when evaluation of the block causes any heap allocation.
+ */
+#define ccstAssertNoAllocations(block, ...)																\
+	ccstAssertMaxAllocations(block, 0, __VA_ARGS__)
+
+
+/**
+ Triggers failure when the throughput of the block is lower than |mbps| megabytes
+ per second. The |bytes| parameter is number of bytes processed in one evaluation
+ of the block. The block is evaluated many times and the median time is used for
+ the throughput calculation.
+ */
+#define ccstAssertThroughputAtLeast(bytes, mbps, block, ...)											\
+	{																									\
+		cc7::tests::BenchmarkResult ccst_r_ = cc7::tests::detail::MeasureAssertionBlock([&]() { block; }, #block, (bytes));\
+		double ccst_mbps_ = ccst_r_.bytes_per_second / (1024.0 * 1024.0);								\
+		if (ccst_mbps_ < (double)(mbps)) {																\
+			char ccst_condition_[512];																	\
+			snprintf(ccst_condition_, sizeof(ccst_condition_),											\
+					 "throughput(%s) >= %.2f MB/s, measured %.2f MB/s (median %.3f ns/op)", #block,		\
+					 (double)(mbps), ccst_mbps_, ccst_r_.median);										\
+			this->tl().logIncident(__FILE__, __LINE__, ccst_condition_, "" __VA_ARGS__);				\
+		}																								\
+	}
+
+/**
+ Triggers failure when the block_a is not at least |ratio| times faster than
+ the block_b. Both blocks are evaluated many times and the median times are compared.
+ */
+#define ccstAssertFasterThan(block_a, block_b, ratio, ...)												\
+	{																									\
+		cc7::tests::BenchmarkResult ccst_a_ = cc7::tests::detail::MeasureAssertionBlock([&]() { block_a; }, #block_a, 0);\
+		cc7::tests::BenchmarkResult ccst_b_ = cc7::tests::detail::MeasureAssertionBlock([&]() { block_b; }, #block_b, 0);\
+		double ccst_ratio_ = ccst_a_.median > 0.0 ? ccst_b_.median / ccst_a_.median : 0.0;				\
+		if (ccst_a_.median > 0.0 && ccst_ratio_ < (double)(ratio)) {									\
+			char ccst_condition_[512];																	\
+			snprintf(ccst_condition_, sizeof(ccst_condition_),											\
+					 "(%s) faster than (%s) by %.2fx, measured %.2fx (%.3f ns/op vs %.3f ns/op)", #block_a, #block_b,\
+					 (double)(ratio), ccst_ratio_, ccst_a_.median, ccst_b_.median);						\
+			this->tl().logIncident(__FILE__, __LINE__, ccst_condition_, "" __VA_ARGS__);				\
+		}																								\
+	}
+
+
 /**
  Always triggers failure
  */
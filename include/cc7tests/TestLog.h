@@ -17,8 +17,13 @@
 #pragma once
 
 #include <cc7/Platform.h>
+#include <cc7tests/TestLogSink.h>
 #include <mutex>
-#include <set>
+#include <atomic>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+#include <string.h>
 
 namespace cc7
 {
@@ -39,7 +44,8 @@ namespace tests
 				passed_tests(0),
 				failed_tests(0),
 				skipped_tests(0),
-				elapsed_time(0.0)
+				elapsed_time(0.0),
+				cpu_time(0.0)
 			{
 			}
 			
@@ -52,6 +58,7 @@ namespace tests
 				failed_tests = 0;
 				skipped_tests = 0;
 				elapsed_time = 0.f;
+				cpu_time = 0.f;
 			}
 
 			/**
@@ -83,6 +90,11 @@ namespace tests
 			 Time spent for tests.
 			 */
 			double elapsed_time;
+			/**
+			 Summed CPU time of all executed tests. In the parallel mode, the value
+			 is typically greater than elapsed_time.
+			 */
+			double cpu_time;
 		};
 		
 		TestLogData()
@@ -115,7 +127,9 @@ namespace tests
 	 Typically, this class collects all logs and incidents which occured 
 	 during the tests.
 	 
-	 The TestLog implementation is thread-safe.
+	 The TestLog implementation is thread-safe. Each thread appends messages to its
+	 own buffer, so the logging from multiple threads doesn't serialize on one lock.
+	 The buffers are merged in the original order of messages, when logData() is called.
 	 */
 	class TestLog
 	{
@@ -156,6 +170,13 @@ namespace tests
 		 incidents log.
 		 */
 		void logIncident(const char * file, int line, const char * condition, const char * format, ...);
+		
+		/**
+		 Adds incident which is not bound to the source code location, for example, a failure
+		 detected in the collected results. Unlike logIncident(), each call adds the formatted
+		 message to both test and incidents log.
+		 */
+		void logUnboundIncident(const char * format, ...);
 
 		
 		// Indentation
@@ -215,14 +236,41 @@ namespace tests
 		 */
 		bool incidentBreakpointEnabled() const;
 		
+		/**
+		 Sets sink for the log messages. If the sink is set, then the messages are
+		 streamed to the sink and only incidents and counters are kept in the memory.
+		 The messages collected before are still available in logData().
+		 Use nullptr to remove the sink.
+		 */
+		void setSink(std::shared_ptr<TestLogSink> sink);
+		
+		/**
+		 Returns current sink, or nullptr if no sink is set.
+		 */
+		std::shared_ptr<TestLogSink> sink() const;
+		
+		/**
+		 Writes all pending messages to the sink and flushes the sink.
+		 */
+		void flush();
+		
 		
 		// MARK: Log results and control
 		
 		/**
-		 Returns copy of internal TestLogData structure with actual and full 
-		 content of the testing log.
+		 Returns internal TestLogData structure with actual and full content of
+		 the testing log. If the sink is set, then the log contains only messages
+		 collected before the sink was set. No copy of the log is created, so the
+		 returned reference is valid only until the next change of the log. Copy
+		 the structure, if the log is still used by other threads.
 		 */
-		TestLogData logData() const;
+		const TestLogData & logData() const;
+		
+		/**
+		 Moves collected log and incidents to the returned structure, so no copy
+		 of the log is created. The counters are returned, but not reset.
+		 */
+		TestLogData takeLogData();
 		
 		/**
 		 Returns copy of internal TestLogData::Counters structure with actual counters.
@@ -240,6 +288,13 @@ namespace tests
 		 */
 		void clearCurrentTestIncidentsCount();
 		
+		/**
+		 Appends log, incidents and incident counters from |data| to this log. The text
+		 is appended as it is, without the current indentation. The method is used for
+		 merging logs from the tests executed in parallel.
+		 */
+		void appendLogData(const TestLogData & data);
+		
 		
 		
 		// MARK: Passed / Failed counters
@@ -248,33 +303,150 @@ namespace tests
 		void addFailedTest();
 		void addSkippedTest();
 		void setElapsedTime(double time);
+		void addCpuTime(double time);
 		
 	private:
 		
+		// Not copyable
+		TestLog(const TestLog &) = delete;
+		TestLog & operator=(const TestLog &) = delete;
+		
 		// Private methods & members
 		
+		struct ThreadBuffer;
+		
 		/**
 		 Updates internal _indentation string, based on desired level of indentation.
 		 The final string is constructed as |prefix| + |' ' x indentation_level| + |suffix|
+		 The _lock must be acquired.
 		 */
 		void updateIndentationToLevel(size_t level);
 		
-		void appendMultilineString(const std::string & string);
+		/**
+		 Appends |string| with the current indentation to the calling thread's buffer.
+		 If |incident| is true, then the string is also added to the incidents.
+		 */
+		void appendMultilineString(const std::string & string, bool incident = false);
+		
+		/**
+		 Updates counters for a new incident and adds |message| to the logs, if |new_incident|
+		 is true. Then dumps the message to the system log, or breaks the execution.
+		 */
+		void reportIncident(const char * message, bool new_incident);
+		
+		/**
+		 Returns buffer for the calling thread.
+		 */
+		ThreadBuffer * threadBuffer();
+		
+		/**
+		 Moves content of all thread buffers to _log_data, or to the sink.
+		 The _lock must be acquired.
+		 */
+		void mergeThreadBuffers() const;
+		
+		/**
+		 Moves content of thread buffers to the sink, if the |buffer| is too big.
+		 */
+		void streamToSinkIfNeeded(ThreadBuffer * buffer);
 		
-		size_t indentationLevelImpl() const;
+		/**
+		 Unique identifier of this log, used for the thread local lookup.
+		 */
+		const cc7::U64	_log_id;
 		
+		/**
+		 Lock for merged data & indentation changes
+		 */
 		std::mutex *	_lock;
 		
-		std::string		_indentation;
+		/**
+		 Current indentation. The indentation string is immutable and replaced
+		 on each change. The previous strings are kept for the whole lifetime of
+		 the log, because other threads may still use them.
+		 */
+		std::atomic<const std::string*> _indentation;
+		std::vector<std::unique_ptr<std::string>> _indentations;
 		std::string		_indentation_prefix;
 		std::string		_indentation_suffix;
-		TestLogData		_log_data;
+		size_t			_indentation_level;
+		
+		/**
+		 Merged content of thread buffers
+		 */
+		mutable TestLogData	_log_data;
+		
+		/**
+		 List of thread buffers, guarded by _lock. Buffers of exited threads
+		 are released during the merge.
+		 */
+		mutable std::vector<ThreadBuffer*> _buffers;
+		
+		/**
+		 Scratch space for the merge, guarded by _lock. The capacity is kept,
+		 so the repeated merges don't allocate.
+		 */
+		struct MergeEntry
+		{
+			cc7::U64				sequence;
+			const ThreadBuffer *	buffer;
+			size_t					index;
+		};
+		mutable std::vector<MergeEntry> _merge_entries;
+		mutable std::vector<std::pair<ThreadBuffer*, size_t>> _merge_counts;
 		
-		std::set<std::string> _incident_locations_set;
+		/**
+		 Sink for messages, guarded by _lock.
+		 */
+		std::shared_ptr<TestLogSink> _sink;
+		std::atomic<bool>	_has_sink;
+		
+		/**
+		 Counters
+		 */
+		std::atomic<int>	_incidents_count;
+		std::atomic<int>	_current_test_incidents_count;
+		std::atomic<int>	_executed_tests;
+		std::atomic<int>	_passed_tests;
+		std::atomic<int>	_failed_tests;
+		std::atomic<int>	_skipped_tests;
+		std::atomic<double>	_elapsed_time;
+		std::atomic<double>	_cpu_time;
+		
+		/**
+		 Locations of already reported incidents. The location is identified by
+		 the file name and line, so no string is constructed for the lookup. The same
+		 header compiled into different units may have different file pointers, so
+		 the name's content is compared.
+		 */
+		struct IncidentLocation
+		{
+			const char * file;
+			int line;
+			
+			bool operator==(const IncidentLocation & other) const
+			{
+				return line == other.line && (file == other.file || strcmp(file, other.file) == 0);
+			}
+		};
+		struct IncidentLocationHash
+		{
+			size_t operator()(const IncidentLocation & location) const
+			{
+				// FNV-1a hash of the file name
+				size_t hash = 2166136261U;
+				for (const char * c = location.file; *c; c++) {
+					hash = (hash ^ (cc7::byte)*c) * 16777619U;
+				}
+				return hash ^ ((size_t)location.line * 0x9E3779B9U);
+			}
+		};
+		std::mutex			_incident_locations_lock;
+		std::unordered_set<IncidentLocation, IncidentLocationHash> _incident_locations_set;
 		
 		// flags
-		bool			_dump_to_system_log;
-		bool			_incident_breakpoint;
+		std::atomic<bool>	_dump_to_system_log;
+		std::atomic<bool>	_incident_breakpoint;
 	};
 	
 	
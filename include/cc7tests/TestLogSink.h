@@ -0,0 +1,65 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <cc7/Platform.h>
+#include <functional>
+#include <memory>
+
+namespace cc7
+{
+namespace tests
+{
+	/**
+	 The TestLogSink is an abstract destination for the test log. If the sink is set
+	 to the TestLog, then all formatted lines are streamed to the sink, instead of
+	 keeping them in the memory. The TestLog serializes all calls to the sink, so
+	 the implementation doesn't need to be thread-safe.
+	 */
+	class TestLogSink
+	{
+	public:
+		
+		virtual ~TestLogSink();
+		
+		/**
+		 Writes |size| bytes from |data| to the sink.
+		 */
+		virtual void write(const char * data, size_t size) = 0;
+		
+		/**
+		 Flushes all buffered data to the final destination.
+		 */
+		virtual void flush();
+		
+		/**
+		 Creates a new sink, which writes the log to the file descriptor |fd|.
+		 The writes are buffered in |buffer_size| bytes long buffer. The sink
+		 doesn't close the descriptor.
+		 */
+		static std::shared_ptr<TestLogSink> createFileDescriptorSink(int fd, size_t buffer_size = 64 * 1024);
+		
+		/**
+		 Creates a new sink, which passes the log to the |callback| function.
+		 The writes are buffered in |buffer_size| bytes long buffer.
+		 */
+		static std::shared_ptr<TestLogSink> createCallbackSink(std::function<void(const char * data, size_t size)> callback, size_t buffer_size = 64 * 1024);
+	};
+	
+} // cc7::tests
+} // cc7
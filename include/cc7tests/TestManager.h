@@ -17,10 +17,14 @@
 #pragma once
 
 #include <cc7tests/UnitTest.h>
+#include <cc7tests/Benchmark.h>
+#include <cc7tests/BenchmarkReport.h>
 #include <cc7tests/TestLog.h>
+#include <cc7tests/SamplingProfiler.h>
 #include <cc7tests/detail/TestTypes.h>
 
 #include <cc7/DebugFeatures.h>
+#include <cc7/Trace.h>
 
 namespace cc7
 {
@@ -54,6 +58,13 @@ namespace tests
 		 */
 		static TestManager * createDefaultManager();
 		
+		/**
+		 Creates a new TestManager instance with default list of benchmarks.
+		 The benchmarks are not part of the default manager, because they typically
+		 take much more time than the regular tests.
+		 */
+		static TestManager * createDefaultBenchmarkManager();
+		
 		/**
 		 Creates a new empty TestManager instance with no tests added.
 		 */
@@ -107,6 +118,77 @@ namespace tests
 		 */
 		bool logCapturingEnabled() const;
 		
+		/**
+		 If enabled, then each test run records events produced by CC7_TRACE_SCOPE()
+		 and CC7_TRACE_COUNTER() macros. The trace clock is switched to Platform_GetCurrentTime()
+		 for the run. You can export the recorded events with cc7::debug::ExportTraceEvents()
+		 after the run. The feature is available only when the library is compiled with
+		 ENABLE_CC7_TRACE macro. By default is disabled.
+		 */
+		void setTracingEnabled(bool enabled);
+		
+		/**
+		 Returns whether the tracing is enabled or not.
+		 */
+		bool tracingEnabled() const;
+		
+		/**
+		 If enabled, then the tests are executed in parallel, on a pool of worker threads.
+		 Each test collects its messages to its own log and all these logs are merged
+		 into the tl() in the order of registration, so the final log is still deterministic.
+		 The tests with "serial" tag are executed on the calling thread, after all
+		 parallel tests are finished. By default is disabled.
+		 */
+		void setParallelExecutionEnabled(bool enabled);
+		
+		/**
+		 Returns whether the parallel execution is enabled or not.
+		 */
+		bool parallelExecutionEnabled() const;
+		
+		/**
+		 Sets number of worker threads used in the parallel mode. If |count| is 0,
+		 then the number of hardware threads is used. The default value is 0.
+		 */
+		void setParallelWorkersCount(size_t count);
+		
+		/**
+		 Returns number of worker threads used in the parallel mode.
+		 */
+		size_t parallelWorkersCount() const;
+		
+		/**
+		 If enabled, then the sampling profiler is running during the test run. In the serial
+		 mode, samples are labeled with the name of the test. At the end of the run, the captured
+		 stacks are written in the folded format to the profiling sink, or to the test log, if
+		 no sink is set. The profiler is currently supported only on Linux and Android. By default
+		 is disabled.
+		 */
+		void setProfilingEnabled(bool enabled);
+		
+		/**
+		 Returns whether the profiling is enabled or not.
+		 */
+		bool profilingEnabled() const;
+		
+		/**
+		 Sets sink for the folded stacks captured during the test run. You can use
+		 TestLogSink::createFileDescriptorSink() to write the stacks to the file, which
+		 can be later passed to flamegraph.pl, or similar tool.
+		 */
+		void setProfilingSink(std::shared_ptr<TestLogSink> sink);
+		
+		/**
+		 Returns sink for the folded stacks, or nullptr if stacks are written to the test log.
+		 */
+		std::shared_ptr<TestLogSink> profilingSink() const;
+		
+		/**
+		 Returns sampling profiler used during the test run.
+		 */
+		SamplingProfiler & profiler();
+		const SamplingProfiler & profiler() const;
+		
 		// Tests registration
 		
 		/**
@@ -182,6 +264,41 @@ namespace tests
 		 */
 		void logSeparator();
 		
+		
+		// Benchmarks
+		
+		/**
+		 Adds benchmark result to the manager. The method is called from the Benchmark
+		 class, after the benchmark method is measured.
+		 */
+		void addBenchmarkResult(const BenchmarkResult & result);
+		
+		/**
+		 Returns results of all benchmarks executed in the last run.
+		 */
+		std::vector<BenchmarkResult> benchmarkResults() const;
+		
+		/**
+		 Returns results of all benchmarks executed in the last run, as a JSON document.
+		 The document can be stored and used later as a baseline.
+		 */
+		std::string benchmarkResultsJSON() const;
+		
+		/**
+		 Loads baseline for the benchmarks from JSON document, previously produced by
+		 benchmarkResultsJSON(). If the baseline is loaded, then each benchmark is compared
+		 with its baseline results. The significantly slower benchmark is reported as
+		 an incident, so the test run fails. Returns false if the document is not valid.
+		 */
+		bool loadBenchmarkBaseline(const cc7::ByteRange & json_data, std::string * out_error = nullptr);
+		
+		/**
+		 Returns object with the baseline results. You can use this object to change
+		 the regression threshold.
+		 */
+		BenchmarkBaseline & benchmarkBaseline();
+		const BenchmarkBaseline & benchmarkBaseline() const;
+		
 	private:
 
 		// Construction / Destruction
@@ -197,6 +314,18 @@ namespace tests
 		 Private execution of one particular unit test.
 		 */
 		bool executeTest(UnitTestCreationInfo ti, const std::string & full_test_desc);
+		/**
+		 Private execution of tests in parallel mode. The |runs| vector contains
+		 information about all registered tests.
+		 */
+		struct TestRun;
+		void executeParallelTests(std::vector<TestRun> & runs);
+		
+		/**
+		 Returns log for the current thread. In the parallel mode, each worker
+		 thread has its own log. Otherwise returns tl().
+		 */
+		TestLog & currentLog();
 		
 		// Assert handler
 		
@@ -216,6 +345,18 @@ namespace tests
 		void restoreLogCapturingHandler();
 		
 		void systemLog(const char * message);
+		
+		/**
+		 Tracing
+		 */
+		void setupTracing();
+		void finishTracing();
+		
+		/**
+		 Profiling
+		 */
+		void setupProfiling();
+		void finishProfiling();
 
 		// Private members
 		
@@ -237,8 +378,27 @@ namespace tests
 		 */
 		bool _assertion_breakpoint_enabled;
 		bool _log_capturig_enabled;
+		bool _tracing_enabled;
+		bool _profiling_enabled;
+		bool _parallel_execution_enabled;
+		bool _parallel_execution_active;
+		size_t _parallel_workers_count;
 		debug::AssertionHandlerSetup _old_assertion_setup;
 		debug::LogHandlerSetup _old_log_setup;
+		debug::TraceClockSetup _old_trace_clock;
+		
+		/**
+		 Benchmark results
+		 */
+		mutable std::mutex _benchmark_results_lock;
+		std::vector<BenchmarkResult> _benchmark_results;
+		BenchmarkBaseline _benchmark_baseline;
+		
+		/**
+		 Profiler
+		 */
+		SamplingProfiler _profiler;
+		std::shared_ptr<TestLogSink> _profiling_sink;
 		
 	};
 	
@@ -96,3 +96,37 @@
  */
 #define CC7_REGISTER_TEST_METHOD(method_name)									\
 	this->registerTestMethod([this]() { this->method_name(); }, #method_name );
+
+
+/**
+ The CC7_CREATE_BENCHMARK() macro creates an internal registration structure for
+ the Benchmark derived class. The macro works like CC7_CREATE_UNIT_TEST(), but adds
+ "benchmark" and "serial" tags to the test, so the benchmarks never run in parallel
+ with other tests. You have to use CC7_ADD_UNIT_TEST() to add the benchmark
+ to the list of tests.
+ 
+ The |BenchmarkTags| parameter must be a string literal. Use "" if the benchmark
+ has no additional tags.
+ */
+#define CC7_CREATE_BENCHMARK(BenchmarkClassName, BenchmarkTags)				\
+	CC7_CREATE_UNIT_TEST(BenchmarkClassName, "benchmark serial " BenchmarkTags)
+
+/**
+ The CC7_REGISTER_BENCHMARK_METHOD macro registers a benchmark method in the context
+ of one particular benchmark. The method must have "void method(size_t iterations)"
+ signature and must execute the measured operation |iterations| times.
+ 
+ The |bytes_per_iteration| parameter is a number of bytes processed in one iteration,
+ which is used for the throughput calculation. Use 0 if the throughput has no meaning
+ for the benchmark.
+ */
+#define CC7_REGISTER_BENCHMARK_METHOD(method_name, bytes_per_iteration)		\
+	this->registerBenchmarkMethod([this](size_t iterations) { this->method_name(iterations); }, #method_name, bytes_per_iteration);
+
+/**
+ The CC7_REGISTER_SCALING_BENCHMARK_METHOD macro registers a thread scaling benchmark
+ method. The method has the same signature as for CC7_REGISTER_BENCHMARK_METHOD, but
+ is executed concurrently on multiple threads, so it must be thread safe.
+ */
+#define CC7_REGISTER_SCALING_BENCHMARK_METHOD(method_name, bytes_per_iteration)	\
+	this->registerScalingBenchmarkMethod([this](size_t iterations) { this->method_name(iterations); }, #method_name, bytes_per_iteration);
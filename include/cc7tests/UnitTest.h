@@ -83,6 +83,12 @@ namespace tests
 		TestManager & testManager();
 		TestManager & testManager() const;
 		
+		/**
+		 Returns name of the test, as it was registered in the TestManager.
+		 The name is available only during the test execution.
+		 */
+		const char * testName() const;
+		
 	protected:
 		
 		void registerTestMethod(std::function<void()> method, const char * description);
@@ -98,6 +104,7 @@ namespace tests
 		// Members
 		TestLog * _log;
 		TestManager * _manager;
+		const char * _test_name;
 		std::vector<std::tuple<std::function<void()>, std::string>>	_methods;
 	};
 	
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+namespace cc7
+{
+namespace tests
+{
+namespace detail
+{
+	/**
+	 The JSONFlatMap is a map from string to |Value|, implemented as a vector of
+	 key-value pairs, sorted by key. It's used as the object type in JSONValue.
+	 The typical JSON object has just a few members, so the contiguous storage is
+	 faster to build, lookup and iterate than the tree, and it needs only one
+	 allocation for all members.
+	
+	 The interface is compatible with std::map, for lookups, iteration and insertion.
+	 Unlike std::map, the insertion and erase invalidates all iterators and references
+	 to the members. The keys must not be modified through the iterators.
+	 */
+	template <typename Value>
+	class JSONFlatMap
+	{
+	public:
+	
+		typedef std::string							key_type;
+		typedef Value								mapped_type;
+		typedef std::pair<std::string, Value>		value_type;
+		typedef std::vector<value_type>				container_type;
+		typedef typename container_type::iterator		iterator;
+		typedef typename container_type::const_iterator	const_iterator;
+		typedef size_t								size_type;
+		
+		// Iteration
+		
+		iterator begin()				{ return _members.begin(); }
+		iterator end()					{ return _members.end(); }
+		const_iterator begin() const	{ return _members.begin(); }
+		const_iterator end() const		{ return _members.end(); }
+		const_iterator cbegin() const	{ return _members.begin(); }
+		const_iterator cend() const		{ return _members.end(); }
+		
+		// Capacity
+		
+		size_type size() const			{ return _members.size(); }
+		bool empty() const				{ return _members.empty(); }
+		void reserve(size_type count)	{ _members.reserve(count); }
+		void clear()					{ _members.clear(); }
+		
+		// Lookup
+		
+		iterator find(const std::string & key)
+		{
+			iterator it = lowerBound(key);
+			return it != _members.end() && it->first == key ? it : _members.end();
+		}
+		
+		const_iterator find(const std::string & key) const
+		{
+			return const_cast<JSONFlatMap*>(this)->find(key);
+		}
+		
+		size_type count(const std::string & key) const
+		{
+			return find(key) != end() ? 1 : 0;
+		}
+		
+		Value & at(const std::string & key)
+		{
+			iterator it = find(key);
+			if (it == _members.end()) {
+				throw std::out_of_range("Key not found");
+			}
+			return it->second;
+		}
+		
+		const Value & at(const std::string & key) const
+		{
+			return const_cast<JSONFlatMap*>(this)->at(key);
+		}
+		
+		// Insertion
+		
+		Value & operator[](const std::string & key)
+		{
+			return emplace(key, Value()).first->second;
+		}
+		
+		Value & operator[](std::string && key)
+		{
+			return emplace(std::move(key), Value()).first->second;
+		}
+		
+		std::pair<iterator, bool> insert(const value_type & member)
+		{
+			return emplace(member.first, member.second);
+		}
+		
+		std::pair<iterator, bool> insert(value_type && member)
+		{
+			return emplace(std::move(member.first), std::move(member.second));
+		}
+		
+		template <typename K, typename V>
+		std::pair<iterator, bool> emplace(K && key, V && value)
+		{
+			iterator it = lowerBound(key);
+			if (it != _members.end() && it->first == key) {
+				return std::make_pair(it, false);
+			}
+			it = _members.emplace(it, std::forward<K>(key), std::forward<V>(value));
+			return std::make_pair(it, true);
+		}
+		
+		// Erase
+		
+		iterator erase(const_iterator position)
+		{
+			return _members.erase(position);
+		}
+		
+		size_type erase(const std::string & key)
+		{
+			iterator it = find(key);
+			if (it == _members.end()) {
+				return 0;
+			}
+			_members.erase(it);
+			return 1;
+		}
+		
+		// Bulk construction
+		
+		/**
+		 Appends member to the end, with no lookup. You have to call sortMembers()
+		 after all members are appended, before the map is used.
+		 */
+		template <typename K, typename V>
+		void appendUnsorted(K && key, V && value)
+		{
+			_members.emplace_back(std::forward<K>(key), std::forward<V>(value));
+		}
+		
+		/**
+		 Sorts members appended with appendUnsorted() and removes duplicate keys.
+		 If the key is duplicated, then the last appended member wins.
+		 */
+		void sortMembers()
+		{
+			if (!isSorted()) {
+				if (_members.size() <= 32) {
+					// Insertion sort is stable and doesn't allocate a temporary buffer.
+					for (size_t i = 1; i < _members.size(); i++) {
+						if (_members[i].first < _members[i - 1].first) {
+							value_type member(std::move(_members[i]));
+							size_t j = i;
+							do {
+								_members[j] = std::move(_members[j - 1]);
+								j--;
+							} while (j > 0 && member.first < _members[j - 1].first);
+							_members[j] = std::move(member);
+						}
+					}
+				} else {
+					std::stable_sort(_members.begin(), _members.end(), [](const value_type & a, const value_type & b) {
+						return a.first < b.first;
+					});
+				}
+				removeDuplicates();
+			}
+		}
+	
+	private:
+	
+		container_type _members;
+		
+		iterator lowerBound(const std::string & key)
+		{
+			return std::lower_bound(_members.begin(), _members.end(), key, [](const value_type & member, const std::string & key) {
+				return member.first < key;
+			});
+		}
+		
+		/**
+		 Returns true if members are strictly ordered, so there's no duplicate key.
+		 */
+		bool isSorted() const
+		{
+			for (size_t i = 1; i < _members.size(); i++) {
+				if (!(_members[i - 1].first < _members[i].first)) {
+					return false;
+				}
+			}
+			return true;
+		}
+		
+		/**
+		 Removes duplicates from sorted members. The last member from each
+		 sequence of equal keys is kept.
+		 */
+		void removeDuplicates()
+		{
+			size_t out = 0;
+			for (size_t i = 0; i < _members.size(); i++) {
+				if (i + 1 < _members.size() && _members[i].first == _members[i + 1].first) {
+					continue;
+				}
+				if (out != i) {
+					_members[out] = std::move(_members[i]);
+				}
+				out++;
+			}
+			_members.erase(_members.begin() + out, _members.end());
+		}
+	};
+
+
+} // cc7::tests::detail
+} // cc7::tests
+} // cc7
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cc7/Platform.h>
+
+namespace cc7
+{
+namespace tests
+{
+namespace detail
+{
+	/**
+	 The JSONNumber structure contains result of ParseJSONNumber() function.
+	 */
+	struct JSONNumber
+	{
+		bool	is_double;
+		int64_t	integer_value;
+		double	double_value;
+	};
+	
+	/**
+	 Parses JSON number from |length| bytes at |p|. The number without fraction and
+	 exponent is parsed as an integer. The double value is correctly rounded. The function
+	 doesn't allocate memory and doesn't depend on the current LC_NUMERIC locale.
+	 
+	 Returns number of consumed bytes, or 0 if the number is not valid, or if it doesn't
+	 fit into int64_t or double.
+	 */
+	size_t ParseJSONNumber(const cc7::byte * p, size_t length, JSONNumber & out_number);
+	
+	/**
+	 Writes decimal representation of |value| to the |buffer|, which must have
+	 at least 20 bytes. The buffer is not terminated with zero. Returns number of
+	 written characters.
+	 */
+	size_t FormatJSONInteger(int64_t value, char * buffer);
+	
+	/**
+	 Writes round-trip exact representation of |value|, which is parsed back to the same
+	 double, to the |buffer|, which must have at least 25 bytes. The Grisu2 algorithm
+	 produces the shortest representation for the most of values, but not for all of them.
+	 The value must be finite.
+	 The result always contains '.' or exponent, so it's parsed back as a double.
+	 The buffer is not terminated with zero. Returns number of written characters.
+	 */
+	size_t FormatJSONDouble(double value, char * buffer);
+	
+	
+} // cc7::tests::detail
+} // cc7::tests
+} // cc7
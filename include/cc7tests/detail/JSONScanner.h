@@ -0,0 +1,54 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cc7/Platform.h>
+
+namespace cc7
+{
+namespace tests
+{
+namespace detail
+{
+	/**
+	 Returns number of bytes before the first '"', '\\' or control character in |length|
+	 bytes at |p|. If there's no such character, then returns |length|. The function
+	 classifies 16 bytes at once, when SSE2 or NEON is available.
+	 
+	 The function is shared between the JSON parser and the JSON writer.
+	 */
+	size_t FindJSONStringSpecialCharacter(const cc7::byte * p, size_t length);
+	
+	/**
+	 Returns number of bytes before the first '"', '{', '}', '[' or ']' character
+	 in |length| bytes at |p|. If there's no such character, then returns |length|.
+	 The function is used for skipping the nested values, without parsing them.
+	 */
+	size_t FindJSONStructuralCharacter(const cc7::byte * p, size_t length);
+	
+	/**
+	 Returns number of JSON whitespace characters at the beginning of |length| bytes
+	 at |p|. The number of skipped newlines is stored to |newlines_count| and the
+	 offset of the last skipped newline to |last_newline|. The |last_newline| is
+	 not changed, if there's no newline. On SSE2, 16 bytes are classified at once.
+	 */
+	size_t SkipJSONWhitespace(const cc7::byte * p, size_t length, size_t & newlines_count, size_t & last_newline);
+	
+	
+} // cc7::tests::detail
+} // cc7::tests
+} // cc7
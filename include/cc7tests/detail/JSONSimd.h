@@ -0,0 +1,85 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cc7/Platform.h>
+
+//
+// Detection of SIMD instructions, used by the JSON scanning functions.
+// The header is private for the JSON implementation.
+//
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define CC7_JSON_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+	#include <arm_neon.h>
+	#define CC7_JSON_NEON
+#endif
+#if defined(_MSC_VER)
+	#include <intrin.h>
+#endif
+
+namespace cc7
+{
+namespace tests
+{
+namespace detail
+{
+	//
+	// Bit operations for the masks produced by SIMD comparisons. The masks have
+	// one bit per byte, the lowest bit belongs to the first byte. The |mask|
+	// must not be zero.
+	//
+	
+	inline int JSONCountTrailingZeros(cc7::U32 mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (int)index;
+#else
+		return __builtin_ctz(mask);
+#endif
+	}
+	
+	inline int JSONHighestBitIndex(cc7::U32 mask)
+	{
+#if defined(_MSC_VER)
+		unsigned long index;
+		_BitScanReverse(&index, mask);
+		return (int)index;
+#else
+		return 31 - __builtin_clz(mask);
+#endif
+	}
+	
+	inline int JSONPopCount(cc7::U32 mask)
+	{
+#if defined(_MSC_VER)
+		int count = 0;
+		for (; mask; mask &= mask - 1) {
+			count++;
+		}
+		return count;
+#else
+		return __builtin_popcount(mask);
+#endif
+	}
+	
+} // cc7::tests::detail
+} // cc7::tests
+} // cc7
@@ -0,0 +1,149 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cc7tests/JSONValue.h>
+
+namespace cc7
+{
+namespace tests
+{
+namespace detail
+{
+	//
+	// The JSONValueBuilder creates JSONValue DOM. The values are collected on the stack
+	// and moved to the array or object, once the container is complete.
+	//
+	
+	class JSONValueBuilder
+	{
+	public:
+		
+		bool startObject()
+		{
+			return true;
+		}
+		
+		bool key(const cc7::ByteRange & key)
+		{
+			_keys.emplace_back(reinterpret_cast<const char*>(key.data()), key.size());
+			return true;
+		}
+		
+		bool endObject(size_t members_count)
+		{
+			if (members_count == 0) {
+				// The empty container is not allocated.
+				_values.emplace_back(JSONValue::Object);
+				return true;
+			}
+			JSONValue object(JSONValue::Object);
+			auto & result = object.asMutableObject();
+			auto first_key   = _keys.end() - members_count;
+			auto first_value = _values.end() - members_count;
+			result.reserve(members_count);
+			auto value = first_value;
+			for (auto key = first_key; key != _keys.end(); ++key, ++value) {
+				// Both key and value are moved, so no deep copy of the subtree is created.
+				result.appendUnsorted(std::move(*key), std::move(*value));
+			}
+			// The last duplicate key wins.
+			result.sortMembers();
+			_keys.erase(first_key, _keys.end());
+			_values.erase(first_value, _values.end());
+			_values.emplace_back(std::move(object));
+			return true;
+		}
+		
+		bool startArray()
+		{
+			return true;
+		}
+		
+		bool endArray(size_t elements_count)
+		{
+			if (elements_count == 0) {
+				_values.emplace_back(JSONValue::Array);
+				return true;
+			}
+			JSONValue array(JSONValue::Array);
+			auto & result = array.asMutableArray();
+			result.reserve(elements_count);
+			auto first_value = _values.end() - elements_count;
+			for (auto value = first_value; value != _values.end(); ++value) {
+				result.emplace_back(std::move(*value));
+			}
+			_values.erase(first_value, _values.end());
+			_values.emplace_back(std::move(array));
+			return true;
+		}
+		
+		bool stringValue(const cc7::ByteRange & value)
+		{
+			JSONValue string(JSONValue::String);
+			string.assign(reinterpret_cast<const char*>(value.data()), value.size());
+			_values.emplace_back(std::move(string));
+			return true;
+		}
+		
+		bool integerValue(int64_t value)
+		{
+			_values.emplace_back(value);
+			return true;
+		}
+		
+		bool doubleValue(double value)
+		{
+			_values.emplace_back(value);
+			return true;
+		}
+		
+		bool booleanValue(bool value)
+		{
+			_values.emplace_back(value);
+			return true;
+		}
+		
+		bool nullValue()
+		{
+			_values.emplace_back(JSONValue::Null);
+			return true;
+		}
+		
+		/**
+		 Returns the last completed value and removes it from the stack, so the
+		 builder can be used for the next value.
+		 */
+		JSONValue takeResult()
+		{
+			if (_values.empty()) {
+				return JSONValue();
+			}
+			JSONValue result(std::move(_values.back()));
+			_values.pop_back();
+			return result;
+		}
+		
+	private:
+		
+		std::vector<JSONValue> _values;
+		std::vector<std::string> _keys;
+	};
+
+} // cc7::tests::detail
+} // cc7::tests
+} // cc7
@@ -34,7 +34,7 @@ using namespace cc7;
 	// Run tests and evaluate result
 	bool result = manager->runAllTests();
 
-	tests::TestLogData log_data = manager->tl().logData();
+	tests::TestLogData log_data = manager->tl().takeLogData();
 	tests::TestManager::releaseManager(manager);
 	
 	if (!result) {
@@ -48,6 +48,7 @@ LOCAL_C_INCLUDES := \
 # Multiplatform sources
 LOCAL_SRC_FILES := \
 	cc7/DebugFeatures.cpp \
+	cc7/Trace.cpp \
 	cc7/ByteRange.cpp \
 	cc7/ByteArray.cpp \
 	cc7/Base64.cpp \
@@ -85,13 +86,25 @@ LOCAL_SRC_FILES := \
 	cc7tests/TestManager.cpp \
 	cc7tests/UnitTest.cpp \
 	cc7tests/TestLog.cpp \
+	cc7tests/TestLogSink.cpp \
 	cc7tests/TestFile.cpp \
 	cc7tests/TestDirectory.cpp \
 	cc7tests/TestResource.cpp \
 	cc7tests/PerformanceTimer.cpp \
+	cc7tests/AllocationCounter.cpp \
+	cc7tests/SamplingProfiler.cpp \
+	cc7tests/Benchmark.cpp \
+	cc7tests/BenchmarkReport.cpp \
 	cc7tests/JSONReader.cpp \
 	cc7tests/JSONValue.cpp \
-	cc7tests/detail/StringUtils.cpp
+	cc7tests/JSONPath.cpp \
+	cc7tests/JSONDocument.cpp \
+	cc7tests/JSONLazyDocument.cpp \
+	cc7tests/JSONStreamParser.cpp \
+	cc7tests/JSONWriter.cpp \
+	cc7tests/detail/StringUtils.cpp \
+	cc7tests/detail/JSONNumber.cpp \
+	cc7tests/detail/JSONScanner.cpp
 
 # Testing core (Android)
 LOCAL_SRC_FILES += \
@@ -100,7 +113,9 @@ LOCAL_SRC_FILES += \
 # Unit tests (TestCore)
 LOCAL_SRC_FILES += \
 	cc7tests/tests/cc7base/tt7Testception.cpp \
-	cc7tests/tests/cc7base/tt7JSONReaderTests.cpp
+	cc7tests/tests/cc7base/tt7JSONReaderTests.cpp \
+	cc7tests/tests/cc7base/tt7JSONWriterTests.cpp \
+	cc7tests/tests/cc7base/tt7BenchmarkTests.cpp
 
 
 # Unit tests (CC7)
@@ -112,6 +127,11 @@ LOCAL_SRC_FILES += \
 	cc7tests/tests/cc7base/cc7HexStringTests.cpp \
 	cc7tests/tests/cc7base/cc7PlatformTests.cpp
 
+# Benchmarks
+LOCAL_SRC_FILES += \
+	cc7tests/tests/cc7base/cc7CodecBenchmarks.cpp \
+	cc7tests/tests/cc7base/tt7JSONBenchmarks.cpp
+
 # Generated files
 LOCAL_SRC_FILES += \
 	cc7tests/tests/test-data.generated/g_baseFiles.cpp
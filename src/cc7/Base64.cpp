@@ -16,6 +16,8 @@
 
 #include <cc7/Base64.h>
 #include <cc7/Utilities.h>
+#include <cc7/Trace.h>
+#include <algorithm>
 
 namespace cc7
 {
@@ -40,6 +42,8 @@ namespace cc7
 
 	bool Base64_Encode(const ByteRange & range, size_t wrap_size, std::string & out_string)
 	{
+		CC7_TRACE_SCOPE("Base64_Encode");
+		
 		out_string.clear();
 		
 		if (wrap_size > 0) {
@@ -111,7 +115,7 @@ namespace cc7
 		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
 	};
 	
-	static bool Base64_DecodeNoWrap(const std::string & str, size_t sequence_start, size_t sequence_length,
+	static bool Base64_DecodeNoWrap(const ByteRange & str, size_t sequence_start, size_t sequence_length,
 									ByteArray & out_data,
 									bool & end_marker)
 	{
@@ -127,7 +131,7 @@ namespace cc7
 			// this routine also for non-wrapped strings.
 			return false;
 		}
-		if (sequence_start + sequence_length > str.length()) {
+		if (sequence_start + sequence_length > str.size()) {
 			// Internal error. The provided sequence is out of the input string's range.
 			CC7_ASSERT(false, "Internal error. Provided block size is too long");
 			return false;
@@ -135,14 +139,19 @@ namespace cc7
 		
 		//
 		// Reserve bytes in the byte array. The produced_size is a worst case
-		// estimation for length of final data.
+		// estimation for length of final data. The function is called for each line
+		// of wrapped string, so the capacity has to grow geometrically, when the initial
+		// estimation was too low. Otherwise each line would cause a reallocation.
 		//
 		size_t blocks_count  = sequence_length / 4;
 		size_t block_size    = blocks_count * 3;
-		out_data.reserve(out_data.size() + block_size);
+		size_t required_size = out_data.size() + block_size;
+		if (required_size > out_data.capacity()) {
+			out_data.reserve(std::max(required_size, out_data.capacity() * 2));
+		}
 		
 		// Input pointer
-		const byte * block_4 = reinterpret_cast<const byte*>(str.c_str()) + sequence_start;
+		const byte * block_4 = str.data() + sequence_start;
 		
 		// Check if last block contains padding and thus requires additional processing.
 		end_marker = block_4[sequence_length - 1] == '=' || block_4[sequence_length - 2] == '=';
@@ -216,6 +225,13 @@ namespace cc7
 	
 	bool Base64_Decode(const std::string & string, size_t wrap_size, ByteArray & out_data)
 	{
+		return Base64_Decode(MakeRange(string), wrap_size, out_data);
+	}
+	
+	bool Base64_Decode(const ByteRange & string, size_t wrap_size, ByteArray & out_data)
+	{
+		CC7_TRACE_SCOPE("Base64_Decode");
+		
 		bool result = false;
 		out_data.clear();
 		if (wrap_size > 0) {
@@ -238,8 +254,9 @@ namespace cc7
 			out_data.reserve(byte_size);
 			
 			// Current & End pointer
-			const char * str_p   = string.c_str();
-			const char * str_end = string.c_str() + string.length();
+			const char * str_begin = reinterpret_cast<const char*>(string.data());
+			const char * str_p     = str_begin;
+			const char * str_end   = str_begin + string.size();
 			result = true;
 			
 			bool end_marker = false;
@@ -271,7 +288,7 @@ namespace cc7
 						return false;
 					}
 					// The rest of the decoding is handled in the "NoWrap" routine.
-					result = Base64_DecodeNoWrap(string, line_begin - string.c_str(), line_length, out_data, end_marker);
+					result = Base64_DecodeNoWrap(string, line_begin - str_begin, line_length, out_data, end_marker);
 				}
 			}
 			//
@@ -280,7 +297,7 @@ namespace cc7
 			// no wrap impl.
 			//
 			bool foo;
-			result = Base64_DecodeNoWrap(string, 0, string.length(), out_data, foo);
+			result = Base64_DecodeNoWrap(string, 0, string.size(), out_data, foo);
 		}
 		if (!result) {
 			out_data.clear();
@@ -15,6 +15,7 @@
  */
 
 #include <cc7/DebugFeatures.h>
+#include <stdarg.h>
 
 namespace cc7
 {
@@ -53,6 +54,60 @@ namespace debug
 	{
 		return s_assert_setup;
 	}
+	
+	//
+	// Assertion sites
+	//
+	static std::atomic<unsigned int>	s_assert_report_limit(4);
+	static std::atomic<CC7AssertSite*>	s_assert_sites(nullptr);
+	
+	void SetAssertionReportLimit(unsigned int limit)
+	{
+		s_assert_report_limit.store(limit, std::memory_order_relaxed);
+	}
+	
+	unsigned int GetAssertionReportLimit()
+	{
+		return s_assert_report_limit.load(std::memory_order_relaxed);
+	}
+	
+	static void _ReportSuppressedSite(const char * file, int line, unsigned int count, unsigned int limit);
+	
+	void ReportSuppressedAssertions()
+	{
+		unsigned int limit = GetAssertionReportLimit();
+		if (limit == 0) {
+			return;
+		}
+		CC7AssertSite * site = s_assert_sites.load(std::memory_order_acquire);
+		while (site) {
+			unsigned int count = site->count.load(std::memory_order_relaxed);
+			if (count > limit) {
+				// The file and line are stored before the site is published to the list.
+				_ReportSuppressedSite(site->file, site->line, count, limit);
+			}
+			site = site->next;
+		}
+	}
+	
+	void ResetAssertionCounters()
+	{
+		CC7AssertSite * site = s_assert_sites.load(std::memory_order_acquire);
+		while (site) {
+			site->count.store(0, std::memory_order_relaxed);
+			site = site->next;
+		}
+	}
+	
+	static void _RegisterSite(CC7AssertSite * site, const char * file, int line)
+	{
+		site->file = file;
+		site->line = line;
+		CC7AssertSite * head = s_assert_sites.load(std::memory_order_relaxed);
+		do {
+			site->next = head;
+		} while (!s_assert_sites.compare_exchange_weak(head, site, std::memory_order_release, std::memory_order_relaxed));
+	}
 #endif //ENABLE_CC7_ASSERT
 
 	
@@ -79,6 +134,63 @@ namespace debug
 #endif //ENABLE_CC7_LOG
 
 
+#if defined(ENABLE_CC7_ALLOCATION_STATS)
+	//
+	// Allocation statistics
+	//
+	struct AllocationStatsState
+	{
+		AllocationStats	stats;
+		const void *	last_allocated_ptr;
+		size_t			last_allocated_size;
+	};
+	
+	// Each thread has its own counters, so no lock or atomic operation is required.
+	static thread_local AllocationStatsState s_alloc_state;
+	
+	AllocationStats GetAllocationStats()
+	{
+		return s_alloc_state.stats;
+	}
+	
+	void ResetAllocationStats()
+	{
+		s_alloc_state = AllocationStatsState();
+	}
+	
+	namespace detail
+	{
+		void AllocationStatsOnAllocate(const void * ptr, size_t size)
+		{
+			AllocationStatsState & st = s_alloc_state;
+			st.stats.allocations++;
+			st.stats.allocated_bytes += size;
+			st.stats.live_bytes += size;
+			if (st.stats.live_bytes > st.stats.peak_live_bytes) {
+				st.stats.peak_live_bytes = st.stats.live_bytes;
+			}
+			st.last_allocated_ptr  = ptr;
+			st.last_allocated_size = size;
+		}
+		
+		void AllocationStatsOnDeallocate(const void * ptr, size_t size)
+		{
+			AllocationStatsState & st = s_alloc_state;
+			st.stats.deallocations++;
+			st.stats.wiped_bytes += size;
+			st.stats.live_bytes -= size;
+			if (st.last_allocated_ptr && st.last_allocated_ptr != ptr && st.last_allocated_size > size && size > 0) {
+				// Previous operation was allocation of a larger block, and now the smaller
+				// one is going to be released. This is how the vector grows.
+				st.stats.reallocations++;
+			}
+			st.last_allocated_ptr  = nullptr;
+			st.last_allocated_size = 0;
+		}
+	}
+#endif // ENABLE_CC7_ALLOCATION_STATS
+
+
 } // cc7::debug
 } // cc7
 
@@ -87,34 +199,19 @@ namespace debug
 //
 // Real assert implementation, should not be wrapper in any namespace.
 //
-int CC7AssertImpl(int condition, const char * file, int line, const char * fmt, ...)
+static const char * _AssertFileName(const char * file)
 {
-	if (condition) {
-		// assertion did not fail, just return positive value
-		return 1;
-	}
-	
-	// Format input string
-	char buffer[1024];
-	va_list args;
-	va_start(args, fmt);
-	vsnprintf(buffer, 1024, fmt, args);
-	buffer[1024 - 1] = 0;
-	va_end(args);
-	
 	// Look for file name component from "file"
 	// Printing just file name component from the path increases readability (IMO)
 	const char * separator = strrchr(file, '/');
 	if (!separator) {
 		separator = strrchr(file, '\\');
 	}
-	const char * file_name = separator ? separator + 1 : file;
-	
-	// Build final string
-	char message[1024];
-	snprintf(message, 1024, "CC7_ASSERT: %s, %d: %s", file_name, line, buffer);
-	message[1024 - 1] = 0;
+	return separator ? separator + 1 : file;
+}
 	
+static void _AssertReportMessage(const char * file_name, int line, const char * message)
+{
 	// Pass that message to the assert handler
 	if (!cc7::debug::s_assert_setup.handler) {
 		cc7::debug::s_assert_setup = cc7::debug::Platform_GetDefaultAssertionHandler();
@@ -124,10 +221,74 @@ int CC7AssertImpl(int condition, const char * file, int line, const char * fmt,
 	} else {
 		cc7::debug::s_assert_setup.handler(cc7::debug::s_assert_setup.handler_data, file_name, line, message);
 	}
+}
+
+static void _AssertReport(const char * file, int line, const char * fmt, va_list args)
+{
+	// Build final string, the formatted input string follows the prefix
+	const char * file_name = _AssertFileName(file);
+	char message[1024];
+	int prefix_length = snprintf(message, 1024, "CC7_ASSERT: %s, %d: ", file_name, line);
+	if (prefix_length > 0 && prefix_length < 1024) {
+		vsnprintf(message + prefix_length, 1024 - prefix_length, fmt, args);
+	}
+	message[1024 - 1] = 0;
+	
+	_AssertReportMessage(file_name, line, message);
+}
+
+namespace cc7
+{
+namespace debug
+{
+	static void _ReportSuppressedSite(const char * file, int line, unsigned int count, unsigned int limit)
+	{
+		const char * file_name = _AssertFileName(file);
+		char message[1024];
+		snprintf(message, 1024, "CC7_ASSERT: %s, %d: Failed %u times, %u reports suppressed.", file_name, line, count, count - limit);
+		message[1024 - 1] = 0;
+		_AssertReportMessage(file_name, line, message);
+	}
+} // cc7::debug
+} // cc7
+
+int CC7AssertImpl(int condition, const char * file, int line, const char * fmt, ...)
+{
+	if (condition) {
+		// assertion did not fail, just return positive value
+		return 1;
+	}
+	va_list args;
+	va_start(args, fmt);
+	_AssertReport(file, line, fmt, args);
+	va_end(args);
 	
 	// Function must return 0 due to fact, that CC7AssertImpl() is also used in CC7_CHECK() macros.
 	return condition;
 }
+
+int CC7AssertSiteImpl(CC7AssertSite * site, const char * file, int line, const char * fmt, ...)
+{
+	unsigned int count = site->count.fetch_add(1, std::memory_order_relaxed) + 1;
+	if (!site->registered.exchange(true, std::memory_order_acq_rel)) {
+		cc7::debug::_RegisterSite(site, file, line);
+	}
+	unsigned int limit = cc7::debug::GetAssertionReportLimit();
+	if (limit == 0 || count <= limit) {
+		va_list args;
+		va_start(args, fmt);
+		_AssertReport(file, line, fmt, args);
+		va_end(args);
+		
+	} else if ((count & (count - 1)) == 0) {
+		// Power of two, report the summary. Note that the message is not formatted,
+		// to keep hot loops with the failing assertion as cheap as possible. The site
+		// may still be registered by other thread, so the caller's location is used.
+		cc7::debug::_ReportSuppressedSite(file, line, count, limit);
+	}
+	// Always returns 0, because the site implementation is used only for failed conditions.
+	return 0;
+}
 #endif //ENABLE_CC7_ASSERT
 
 
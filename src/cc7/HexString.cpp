@@ -15,6 +15,7 @@
  */
 
 #include <cc7/HexString.h>
+#include <cc7/Trace.h>
 
 namespace cc7
 {
@@ -25,6 +26,8 @@ namespace cc7
 	
 	bool HexString_Encode(const ByteRange & in_data, bool use_lowercase, std::string & out_string)
 	{
+		CC7_TRACE_SCOPE("HexString_Encode");
+		
 		const char * table = use_lowercase ? s_hex_table_lc : s_hex_table_uc;
 		
 		out_string.clear();
@@ -45,13 +48,20 @@ namespace cc7
 	
 	bool HexString_Decode(const std::string & in_string, ByteArray & out_data)
 	{
-		size_t str_len = in_string.length();
+		return HexString_Decode(MakeRange(in_string), out_data);
+	}
+	
+	bool HexString_Decode(const ByteRange & in_string, ByteArray & out_data)
+	{
+		CC7_TRACE_SCOPE("HexString_Decode");
+		
+		size_t str_len = in_string.size();
 		
 		// Reserve buffer for data
 		out_data.clear();
 		out_data.reserve((str_len >> 1) + (str_len & 1));
 		
-		const char * str_p = in_string.c_str();
+		const char * str_p = reinterpret_cast<const char*>(in_string.data());
 		char lc, uc;
 		byte lv, uv;
 		if (str_len & 1) {
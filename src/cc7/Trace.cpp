@@ -0,0 +1,325 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cc7/Trace.h>
+
+#if defined(ENABLE_CC7_TRACE)
+
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+
+namespace cc7
+{
+namespace debug
+{
+	// MARK: Trace buffers -
+
+	/*
+	 The TraceEvent is one record in the per-thread buffer. The |name| pointer
+	 is not copied, so it must point to string with static storage duration.
+	 */
+	struct TraceEvent
+	{
+		const char *	name;
+		cc7::U64		time;
+		int64_t			value;
+		char			phase;
+	};
+
+	/*
+	 The TraceThreadBuffer is a fixed size buffer, owned by one thread. Only the owner
+	 thread writes events and publishes them by a release store to |count|. The exporter
+	 reads only the already published events, so no lock is required for recording.
+	 */
+	struct TraceThreadBuffer
+	{
+		static const size_t Capacity = 8192;
+
+		TraceThreadBuffer(cc7::U32 tid) :
+			thread_id(tid),
+			count(0),
+			dropped(0),
+			in_use(true),
+			next(nullptr)
+		{
+		}
+
+		cc7::U32				thread_id;
+		std::atomic<size_t>		count;
+		std::atomic<size_t>		dropped;
+		std::atomic<bool>		in_use;
+		TraceThreadBuffer *		next;
+		TraceEvent				events[Capacity];
+	};
+
+	/*
+	 The TraceThreadHandle releases the buffer back to the registry, when
+	 the owner thread exits. The empty buffer is freed immediately, the buffer
+	 with events is kept for the export, until ClearTraceEvents() is called.
+	 */
+	struct TraceThreadHandle
+	{
+		TraceThreadBuffer * buffer = nullptr;
+
+		~TraceThreadHandle();
+	};
+
+	namespace detail
+	{
+		std::atomic<bool> g_trace_active(false);
+	}
+
+	static std::mutex					s_registry_lock;
+	static TraceThreadBuffer *			s_registry_head = nullptr;
+	static cc7::U32						s_registry_count = 0;
+	static thread_local TraceThreadHandle	s_thread_handle;
+
+	static TraceClockSetup				s_clock_setup = { nullptr, nullptr };
+	static TraceClockSetup				s_active_clock = { nullptr, nullptr };	// Guarded by s_registry_lock
+	static cc7::U64						s_base_time = 0;						// Guarded by s_registry_lock
+	static std::atomic<TraceGetTimeFunction> s_active_get_time(nullptr);
+
+
+	// MARK: Default clock -
+
+	static cc7::U64 _DefaultGetTime()
+	{
+		auto now = std::chrono::steady_clock::now().time_since_epoch();
+		return (cc7::U64)std::chrono::duration_cast<std::chrono::nanoseconds>(now).count();
+	}
+
+	static double _DefaultTimeDiff(cc7::U64 start, cc7::U64 future)
+	{
+		return (double)(future - start) * 1.0/1000000.0;
+	}
+
+	static TraceClockSetup _ValidClockSetup(const TraceClockSetup & setup)
+	{
+		if (setup.get_time && setup.time_diff) {
+			return setup;
+		}
+		return { _DefaultGetTime, _DefaultTimeDiff };
+	}
+
+
+	// MARK: Registry -
+
+	static TraceThreadBuffer * _AcquireThreadBuffer()
+	{
+		TraceThreadBuffer * buffer = s_thread_handle.buffer;
+		if (buffer) {
+			return buffer;
+		}
+		std::lock_guard<std::mutex> lock(s_registry_lock);
+		buffer = new TraceThreadBuffer(++s_registry_count);
+		buffer->next = s_registry_head;
+		s_registry_head = buffer;
+		s_thread_handle.buffer = buffer;
+		return buffer;
+	}
+
+	/*
+	 Frees buffers of already finished threads. If |only_empty| is true, then
+	 the buffers with events are kept. The s_registry_lock must be acquired.
+	 */
+	static void _ReleaseUnusedBuffers(bool only_empty)
+	{
+		TraceThreadBuffer ** link = &s_registry_head;
+		while (*link != nullptr) {
+			TraceThreadBuffer * b = *link;
+			if (!b->in_use.load(std::memory_order_acquire) && (!only_empty || b->count.load(std::memory_order_acquire) == 0)) {
+				*link = b->next;
+				delete b;
+			} else {
+				link = &b->next;
+			}
+		}
+	}
+
+	TraceThreadHandle::~TraceThreadHandle()
+	{
+		if (buffer) {
+			std::lock_guard<std::mutex> lock(s_registry_lock);
+			buffer->in_use.store(false, std::memory_order_release);
+			_ReleaseUnusedBuffers(true);
+		}
+	}
+
+	static void _RecordEvent(const char * name, char phase, int64_t value)
+	{
+		// The acquire load pairs with the release store in StartTracing(), so
+		// the clock is completely published before it's called.
+		TraceGetTimeFunction get_time = s_active_get_time.load(std::memory_order_acquire);
+		if (!get_time) {
+			return;
+		}
+		TraceThreadBuffer * buffer = _AcquireThreadBuffer();
+		size_t index = buffer->count.load(std::memory_order_relaxed);
+		if (index >= TraceThreadBuffer::Capacity) {
+			buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+		TraceEvent & event = buffer->events[index];
+		event.name  = name;
+		event.time  = get_time();
+		event.value = value;
+		event.phase = phase;
+		buffer->count.store(index + 1, std::memory_order_release);
+	}
+
+	namespace detail
+	{
+		void TraceRecordBegin(const char * name)
+		{
+			_RecordEvent(name, 'B', 0);
+		}
+
+		void TraceRecordEnd(const char * name)
+		{
+			_RecordEvent(name, 'E', 0);
+		}
+
+		void TraceRecordCounter(const char * name, int64_t value)
+		{
+			_RecordEvent(name, 'C', value);
+		}
+	}
+
+
+	// MARK: Public API -
+
+	void SetTraceClock(const TraceClockSetup & new_setup)
+	{
+		s_clock_setup = new_setup;
+	}
+
+	TraceClockSetup GetTraceClock()
+	{
+		return _ValidClockSetup(s_clock_setup);
+	}
+
+	void StartTracing()
+	{
+		ClearTraceEvents();
+		TraceClockSetup clock = _ValidClockSetup(s_clock_setup);
+		{
+			std::lock_guard<std::mutex> lock(s_registry_lock);
+			s_active_clock = clock;
+			s_base_time = clock.get_time();
+		}
+		s_active_get_time.store(clock.get_time, std::memory_order_release);
+		detail::g_trace_active.store(true, std::memory_order_release);
+	}
+
+	void StopTracing()
+	{
+		detail::g_trace_active.store(false, std::memory_order_release);
+	}
+
+	bool IsTracingActive()
+	{
+		return detail::g_trace_active.load(std::memory_order_acquire);
+	}
+
+	void ClearTraceEvents()
+	{
+		std::lock_guard<std::mutex> lock(s_registry_lock);
+		_ReleaseUnusedBuffers(false);
+		for (TraceThreadBuffer * b = s_registry_head; b != nullptr; b = b->next) {
+			b->count.store(0, std::memory_order_release);
+			b->dropped.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	size_t DroppedTraceEventsCount()
+	{
+		std::lock_guard<std::mutex> lock(s_registry_lock);
+		size_t dropped = 0;
+		for (TraceThreadBuffer * b = s_registry_head; b != nullptr; b = b->next) {
+			dropped += b->dropped.load(std::memory_order_relaxed);
+		}
+		return dropped;
+	}
+
+
+	// MARK: Export -
+
+	static void _AppendEscapedName(std::string & out, const char * name)
+	{
+		out.push_back('"');
+		for (const char * p = name ? name : "(null)"; *p; p++) {
+			char c = *p;
+			if (c == '"' || c == '\\') {
+				out.push_back('\\');
+				out.push_back(c);
+			} else if ((unsigned char)c < 32) {
+				char buffer[8];
+				snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned)c);
+				out.append(buffer);
+			} else {
+				out.push_back(c);
+			}
+		}
+		out.push_back('"');
+	}
+
+	std::string ExportTraceEvents()
+	{
+		std::string out;
+		out.reserve(4096);
+		out.append("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+
+		bool first = true;
+		char buffer[128];
+
+		std::lock_guard<std::mutex> lock(s_registry_lock);
+		TraceTimeDiffFunction time_diff = s_active_clock.time_diff ? s_active_clock.time_diff : _DefaultTimeDiff;
+
+		for (TraceThreadBuffer * b = s_registry_head; b != nullptr; b = b->next) {
+			size_t count = b->count.load(std::memory_order_acquire);
+			if (count == 0) {
+				continue;
+			}
+			// Thread name metadata
+			snprintf(buffer, sizeof(buffer), "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"cc7 thread %u\"}}",
+					 first ? "" : ",", b->thread_id, b->thread_id);
+			out.append(buffer);
+			first = false;
+
+			for (size_t i = 0; i < count; i++) {
+				const TraceEvent & event = b->events[i];
+				double ts = time_diff(s_base_time, event.time) * 1000.0;	// ms to us
+				out.append(",\n{\"name\":");
+				_AppendEscapedName(out, event.name);
+				if (event.phase == 'C') {
+					snprintf(buffer, sizeof(buffer), ",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%lld}}",
+							 ts, b->thread_id, (long long)event.value);
+				} else {
+					snprintf(buffer, sizeof(buffer), ",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":1,\"tid\":%u}",
+							 event.phase, ts, b->thread_id);
+				}
+				out.append(buffer);
+			}
+		}
+		out.append("\n]}\n");
+		return out;
+	}
+
+} // cc7::debug
+} // cc7
+
+#endif // defined(ENABLE_CC7_TRACE)
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cc7tests/AllocationCounter.h>
+#include <cc7/DebugFeatures.h>
+#include <new>
+#include <stdlib.h>
+
+namespace cc7
+{
+namespace tests
+{
+#if defined(ENABLE_CC7_ALLOCATION_COUNTER)
+	
+	// The counters are POD and thread local, so they're zero initialized and
+	// can be safely accessed from the operator new, at any time.
+	static thread_local AllocationCounters s_counters;
+	
+	namespace detail
+	{
+		static inline void * CountedAllocate(size_t size)
+		{
+			void * ptr = malloc(size > 0 ? size : 1);
+			if (ptr) {
+				s_counters.allocations++;
+				s_counters.allocated_bytes += size;
+			}
+			return ptr;
+		}
+		
+		static inline void CountedDeallocate(void * ptr)
+		{
+			if (ptr) {
+				s_counters.deallocations++;
+				free(ptr);
+			}
+		}
+	}
+	
+	bool AllocationCountersAvailable()
+	{
+		return true;
+	}
+	
+	AllocationCounters GetAllocationCounters()
+	{
+		return s_counters;
+	}
+	
+	void ResetAllocationCounters()
+	{
+		s_counters = AllocationCounters();
+	}
+	
+#elif defined(ENABLE_CC7_ALLOCATION_STATS)
+	
+	bool AllocationCountersAvailable()
+	{
+		return true;
+	}
+	
+	AllocationCounters GetAllocationCounters()
+	{
+		cc7::debug::AllocationStats stats = cc7::debug::GetAllocationStats();
+		AllocationCounters counters;
+		counters.allocations		= stats.allocations;
+		counters.deallocations		= stats.deallocations;
+		counters.allocated_bytes	= stats.allocated_bytes;
+		return counters;
+	}
+	
+	void ResetAllocationCounters()
+	{
+		cc7::debug::ResetAllocationStats();
+	}
+	
+#else
+	
+	bool AllocationCountersAvailable()
+	{
+		return false;
+	}
+	
+	AllocationCounters GetAllocationCounters()
+	{
+		return AllocationCounters();
+	}
+	
+	void ResetAllocationCounters()
+	{
+	}
+	
+#endif // ENABLE_CC7_ALLOCATION_COUNTER
+	
+} // cc7::tests
+} // cc7
+
+
+#if defined(ENABLE_CC7_ALLOCATION_COUNTER)
+//
+// Replacement of global operator new & delete. The operators must not be wrapped
+// in any namespace.
+//
+void * operator new(size_t size)
+{
+	void * ptr = cc7::tests::detail::CountedAllocate(size);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void * operator new[](size_t size)
+{
+	void * ptr = cc7::tests::detail::CountedAllocate(size);
+	if (!ptr) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+void * operator new(size_t size, const std::nothrow_t &) noexcept
+{
+	return cc7::tests::detail::CountedAllocate(size);
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+	return cc7::tests::detail::CountedAllocate(size);
+}
+
+void operator delete(void * ptr) noexcept
+{
+	cc7::tests::detail::CountedDeallocate(ptr);
+}
+
+void operator delete[](void * ptr) noexcept
+{
+	cc7::tests::detail::CountedDeallocate(ptr);
+}
+
+void operator delete(void * ptr, const std::nothrow_t &) noexcept
+{
+	cc7::tests::detail::CountedDeallocate(ptr);
+}
+
+void operator delete[](void * ptr, const std::nothrow_t &) noexcept
+{
+	cc7::tests::detail::CountedDeallocate(ptr);
+}
+#endif // ENABLE_CC7_ALLOCATION_COUNTER
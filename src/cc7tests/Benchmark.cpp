@@ -0,0 +1,427 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cc7tests/Benchmark.h>
+#include <cc7tests/BenchmarkReport.h>
+#include <cc7tests/TestManager.h>
+#include <cc7tests/PerformanceTimer.h>
+#include <cc7tests/detail/StringUtils.h>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <math.h>
+
+namespace cc7
+{
+namespace tests
+{
+	namespace detail
+	{
+		const void * volatile g_benchmark_sink = nullptr;
+	}
+	
+	// MARK: - BenchmarkResult
+	
+	static double _Percentile(const std::vector<double> & sorted, double p)
+	{
+		if (sorted.empty()) {
+			return 0.0;
+		}
+		double position = p * (sorted.size() - 1);
+		size_t index = (size_t)position;
+		if (index + 1 >= sorted.size()) {
+			return sorted.back();
+		}
+		double fraction = position - index;
+		return sorted[index] + (sorted[index + 1] - sorted[index]) * fraction;
+	}
+	
+	void BenchmarkResult::computeStatistics()
+	{
+		if (samples.empty()) {
+			min = median = mean = p99 = stddev = bytes_per_second = 0.0;
+			return;
+		}
+		std::vector<double> sorted(samples);
+		std::sort(sorted.begin(), sorted.end());
+		
+		double sum = 0.0;
+		for (double s : sorted) {
+			sum += s;
+		}
+		mean = sum / sorted.size();
+		
+		double variance = 0.0;
+		for (double s : sorted) {
+			variance += (s - mean) * (s - mean);
+		}
+		stddev = sorted.size() > 1 ? sqrt(variance / (sorted.size() - 1)) : 0.0;
+		
+		min    = sorted.front();
+		median = _Percentile(sorted, 0.50);
+		p99    = _Percentile(sorted, 0.99);
+		
+		if (bytes_per_iteration > 0 && median > 0.0) {
+			bytes_per_second = (double)bytes_per_iteration * 1e9 / median;
+		} else {
+			bytes_per_second = 0.0;
+		}
+	}
+	
+	std::string BenchmarkResult::toString() const
+	{
+		std::string result = detail::FormattedString("%s: %.3f ns/op (min %.3f, mean %.3f, p99 %.3f, stddev %.3f), %d x %d iterations",
+													 name.c_str(), median, min, mean, p99, stddev,
+													 (int)samples.size(), (int)iterations);
+		if (bytes_per_second > 0.0) {
+			result.append(detail::FormattedString(", %.2f MB/s", bytes_per_second / (1024.0 * 1024.0)));
+		}
+		if (counters_available) {
+			result.append(" [");
+			bool first = true;
+			for (int i = 0; i < PerformanceCounters::CountersCount; i++) {
+				PerformanceCounters::Counter counter = (PerformanceCounters::Counter)i;
+				if (hasCounter(counter)) {
+					result.append(detail::FormattedString(first ? "%s %.1f" : ", %s %.1f", PerformanceCounters::counterName(counter), counters[i]));
+					first = false;
+				}
+			}
+			if (hasCounter(PerformanceCounters::Cycles) && hasCounter(PerformanceCounters::Instructions) && counters[PerformanceCounters::Cycles] > 0.0) {
+				result.append(detail::FormattedString(", IPC %.2f", counters[PerformanceCounters::Instructions] / counters[PerformanceCounters::Cycles]));
+			}
+			result.append("]");
+		}
+		return result;
+	}
+	
+	
+	std::string BenchmarkScalingResult::toString() const
+	{
+		std::string str = detail::FormattedString("%s: %.3f Mops/s, efficiency %.1f%%, %.3f ns/op per thread (variation %.1f%%)",
+												  result.name.c_str(), operations_per_second * 1e-6, efficiency * 100.0,
+												  result.median, thread_variation * 100.0);
+		if (bytes_per_second > 0.0) {
+			str.append(detail::FormattedString(", %.2f MB/s", bytes_per_second / (1024.0 * 1024.0)));
+		}
+		if (pinned) {
+			str.append(", pinned");
+		}
+		return str;
+	}
+	
+	
+	// MARK: - BenchmarkRunner
+	
+	BenchmarkRunner::BenchmarkRunner(const BenchmarkConfig & config) :
+		_config(config)
+	{
+	}
+	
+	const BenchmarkConfig & BenchmarkRunner::config() const
+	{
+		return _config;
+	}
+	
+	static double _MeasureIterations(const BenchmarkFunction & function, size_t iterations, PerformanceCounters * out_counters = nullptr)
+	{
+		PerformanceTimer timer;
+		return timer.measureBlock([&function, iterations]() {
+			function(iterations);
+		}, out_counters);
+	}
+	
+	size_t BenchmarkRunner::calibrate(const BenchmarkFunction & function) const
+	{
+		const double target_time = std::max(_config.target_time, 0.001);
+		const size_t max_iterations = std::max(_config.max_iterations, (size_t)1);
+		size_t iterations = 1;
+		while (true) {
+			double elapsed = _MeasureIterations(function, iterations);
+			if (elapsed >= target_time * 0.2 || iterations >= max_iterations) {
+				// Measured time is long enough to estimate the final count.
+				double estimate = elapsed > 0.0 ? (double)iterations * target_time / elapsed : (double)max_iterations;
+				return (size_t)std::max(1.0, std::min(estimate, (double)max_iterations));
+			}
+			// Grow at most 10 times per step, to do not overshoot on the timer's noise.
+			double multiplier = elapsed > 0.0 ? std::min(10.0, target_time * 0.4 / elapsed) : 10.0;
+			size_t next = (size_t)((double)iterations * std::max(multiplier, 2.0));
+			iterations = std::min(next, max_iterations);
+		}
+	}
+	
+	BenchmarkResult BenchmarkRunner::run(const std::string & name, const BenchmarkFunction & function, size_t bytes_per_iteration) const
+	{
+		BenchmarkResult result;
+		result.name = name;
+		result.bytes_per_iteration = bytes_per_iteration;
+		result.iterations = calibrate(function);
+		
+		for (size_t i = 0; i < _config.warmup_runs; i++) {
+			function(result.iterations);
+		}
+		
+		size_t repetitions = std::max(_config.repetitions, (size_t)1);
+		result.samples.reserve(repetitions);
+		
+		// Counters are summed over all repetitions. The counter is reported only
+		// when it was available in all of them.
+		PerformanceCounters counters;
+		PerformanceCounters * counters_ptr = _config.hardware_counters ? &counters : nullptr;
+		cc7::U64 counter_sums[PerformanceCounters::CountersCount] = { 0 };
+		cc7::U32 available = _config.hardware_counters ? ~0U : 0;
+		
+		for (size_t i = 0; i < repetitions; i++) {
+			double elapsed = _MeasureIterations(function, result.iterations, counters_ptr);
+			result.samples.push_back(elapsed * 1e6 / result.iterations);	// ms to ns per op
+			if (counters_ptr) {
+				available &= counters.available;
+				for (int c = 0; c < PerformanceCounters::CountersCount; c++) {
+					counter_sums[c] += counters.values[c];
+				}
+			}
+		}
+		result.counters_available = available & ((1 << PerformanceCounters::CountersCount) - 1);
+		if (result.counters_available) {
+			double total_iterations = (double)result.iterations * repetitions;
+			for (int c = 0; c < PerformanceCounters::CountersCount; c++) {
+				result.counters[c] = result.hasCounter((PerformanceCounters::Counter)c) ? counter_sums[c] / total_iterations : 0.0;
+			}
+		}
+		result.computeStatistics();
+		return result;
+	}
+	
+	
+	/*
+	 The _ThreadBarrier blocks all threads until the last one arrives.
+	 The barrier can be reused.
+	 */
+	class _ThreadBarrier
+	{
+	public:
+		_ThreadBarrier(size_t count) :
+			_count(count),
+			_waiting(0),
+			_generation(0)
+		{
+		}
+		
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			size_t generation = _generation;
+			if (++_waiting == _count) {
+				_waiting = 0;
+				_generation++;
+				_cond.notify_all();
+			} else {
+				_cond.wait(lock, [this, generation] { return generation != _generation; });
+			}
+		}
+		
+	private:
+		std::mutex _mutex;
+		std::condition_variable _cond;
+		size_t _count;
+		size_t _waiting;
+		size_t _generation;
+	};
+	
+	std::vector<BenchmarkScalingResult> BenchmarkRunner::runScaling(const std::string & name, const BenchmarkFunction & function, size_t bytes_per_iteration) const
+	{
+		size_t max_threads = _config.max_threads;
+		if (max_threads == 0) {
+			max_threads = std::max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+		}
+		std::vector<size_t> steps;
+		for (size_t threads = 1; threads < max_threads; threads *= 2) {
+			steps.push_back(threads);
+		}
+		steps.push_back(max_threads);
+		
+		// Iterations are calibrated for the single thread.
+		const size_t iterations = calibrate(function);
+		const size_t repetitions = std::max(_config.repetitions, (size_t)1);
+		for (size_t i = 0; i < _config.warmup_runs; i++) {
+			function(iterations);
+		}
+		
+		std::vector<BenchmarkScalingResult> results;
+		double single_thread_ops = 0.0;
+		for (size_t threads : steps) {
+			// Each thread has its own samples & elapsed time.
+			std::vector<std::vector<double>> thread_samples(threads);
+			std::vector<double> thread_time(threads, 0.0);
+			std::vector<char> thread_pinned(threads, 0);
+			_ThreadBarrier barrier(threads);
+			
+			auto worker = [&](size_t index) {
+				if (_config.pin_threads) {
+					thread_pinned[index] = Platform_PinCurrentThread(index);
+				}
+				std::vector<double> & samples = thread_samples[index];
+				samples.reserve(repetitions);
+				for (size_t r = 0; r < repetitions; r++) {
+					barrier.wait();
+					PerformanceTimer timer;
+					function(iterations);
+					double elapsed = timer.elapsedTime();
+					thread_time[index] += elapsed;
+					samples.push_back(elapsed * 1e6 / iterations);	// ms to ns per op
+				}
+			};
+			// All workers run in new threads, so the calling thread is never pinned.
+			std::vector<std::thread> workers;
+			workers.reserve(threads);
+			for (size_t i = 0; i < threads; i++) {
+				workers.push_back(std::thread(worker, i));
+			}
+			for (auto && t : workers) {
+				t.join();
+			}
+			
+			BenchmarkScalingResult step;
+			step.threads = threads;
+			step.pinned = _config.pin_threads;
+			step.result.name = detail::FormattedString("%s/threads:%d", name.c_str(), (int)threads);
+			step.result.iterations = iterations;
+			step.result.bytes_per_iteration = bytes_per_iteration;
+			
+			std::vector<double> thread_means;
+			for (size_t i = 0; i < threads; i++) {
+				auto & samples = thread_samples[i];
+				step.result.samples.insert(step.result.samples.end(), samples.begin(), samples.end());
+				if (thread_time[i] > 0.0) {
+					step.operations_per_second += (double)iterations * repetitions * 1e3 / thread_time[i];
+				}
+				thread_means.push_back(thread_time[i] * 1e6 / ((double)iterations * repetitions));
+				step.pinned = step.pinned && thread_pinned[i];
+			}
+			step.result.computeStatistics();
+			step.bytes_per_second = step.operations_per_second * bytes_per_iteration;
+			
+			double mean = 0.0, variance = 0.0;
+			for (double m : thread_means) {
+				mean += m;
+			}
+			mean /= threads;
+			for (double m : thread_means) {
+				variance += (m - mean) * (m - mean);
+			}
+			step.thread_variation = (threads > 1 && mean > 0.0) ? sqrt(variance / (threads - 1)) / mean : 0.0;
+			
+			if (threads == 1) {
+				single_thread_ops = step.operations_per_second;
+			}
+			step.efficiency = single_thread_ops > 0.0 ? step.operations_per_second / (single_thread_ops * threads) : 0.0;
+			results.push_back(step);
+		}
+		return results;
+	}
+	
+	
+	// MARK: - Performance assertions
+	
+	BenchmarkResult detail::MeasureAssertionBlock(const std::function<void()> & block, const char * name, size_t bytes_per_iteration)
+	{
+		// Short repetitions are enough for the assertions, which typically compare
+		// the times with a generous tolerance.
+		BenchmarkConfig config;
+		config.target_time = 2.0;
+		config.repetitions = 7;
+		config.hardware_counters = false;
+		BenchmarkRunner runner(config);
+		return runner.run(name, [&block](size_t iterations) {
+			for (size_t i = 0; i < iterations; i++) {
+				block();
+			}
+		}, bytes_per_iteration);
+	}
+	
+	
+	// MARK: - Benchmark
+	
+	Benchmark::Benchmark()
+	{
+	}
+	
+	void Benchmark::setBenchmarkConfig(const BenchmarkConfig & config)
+	{
+		_config = config;
+	}
+	
+	const BenchmarkConfig & Benchmark::benchmarkConfig() const
+	{
+		return _config;
+	}
+	
+	void Benchmark::registerBenchmarkMethod(BenchmarkFunction method, const char * name, size_t bytes_per_iteration)
+	{
+		if (CC7_CHECK(method != nullptr && name != nullptr, "method & name must be set")) {
+			std::string method_name(name);
+			registerTestMethod([this, method, method_name, bytes_per_iteration]() {
+				this->runBenchmarkMethod(method, method_name, bytes_per_iteration);
+			}, name);
+		}
+	}
+	
+	void Benchmark::registerScalingBenchmarkMethod(BenchmarkFunction method, const char * name, size_t bytes_per_iteration)
+	{
+		if (CC7_CHECK(method != nullptr && name != nullptr, "method & name must be set")) {
+			std::string method_name(name);
+			registerTestMethod([this, method, method_name, bytes_per_iteration]() {
+				this->runScalingBenchmarkMethod(method, method_name, bytes_per_iteration);
+			}, name);
+		}
+	}
+	
+	void Benchmark::runBenchmarkMethod(const BenchmarkFunction & method, const std::string & name, size_t bytes_per_iteration)
+	{
+		std::string full_name = std::string(testName()) + "." + name;
+		BenchmarkRunner runner(_config);
+		BenchmarkResult result = runner.run(full_name, method, bytes_per_iteration);
+		tl().logMessage(result.toString());
+		reportBenchmarkResult(result);
+	}
+	
+	void Benchmark::runScalingBenchmarkMethod(const BenchmarkFunction & method, const std::string & name, size_t bytes_per_iteration)
+	{
+		std::string full_name = std::string(testName()) + "." + name;
+		BenchmarkRunner runner(_config);
+		for (auto && step : runner.runScaling(full_name, method, bytes_per_iteration)) {
+			tl().logMessage(step.toString());
+			reportBenchmarkResult(step.result);
+		}
+	}
+	
+	void Benchmark::reportBenchmarkResult(const BenchmarkResult & result)
+	{
+		testManager().addBenchmarkResult(result);
+		
+		BenchmarkComparison comparison;
+		if (testManager().benchmarkBaseline().compare(result, comparison)) {
+			tl().logMessage(comparison.toString());
+			if (comparison.regression) {
+				// Each regressed benchmark is reported, not only the first one.
+				tl().logUnboundIncident("Performance regression in %s", result.name.c_str());
+			}
+		}
+	}
+	
+} // cc7::tests
+} // cc7
@@ -0,0 +1,287 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cc7tests/BenchmarkReport.h>
+#include <cc7tests/PerformanceTimer.h>
+#include <cc7tests/JSONReader.h>
+#include <cc7tests/detail/StringUtils.h>
+#include <algorithm>
+#include <math.h>
+
+namespace cc7
+{
+namespace tests
+{
+	// MARK: - Context
+	
+	static std::string _BuildFlags()
+	{
+		std::string flags;
+#if defined(__clang__)
+		flags.append("clang " __clang_version__);
+#elif defined(__GNUC__)
+		flags.append("gcc " __VERSION__);
+#elif defined(_MSC_VER)
+		flags.append(detail::FormattedString("msvc %d", (int)_MSC_VER));
+#endif
+#if defined(__x86_64__) || defined(_M_X64)
+		flags.append(" x86_64");
+#elif defined(__i386__) || defined(_M_IX86)
+		flags.append(" x86");
+#elif defined(__aarch64__) || defined(_M_ARM64)
+		flags.append(" arm64");
+#elif defined(__arm__) || defined(_M_ARM)
+		flags.append(" arm");
+#endif
+#if defined(__OPTIMIZE__)
+		flags.append(" optimized");
+#endif
+#if defined(DEBUG)
+		flags.append(" DEBUG");
+#endif
+#if defined(NDEBUG)
+		flags.append(" NDEBUG");
+#endif
+#if defined(ENABLE_CC7_ASSERT)
+		flags.append(" ENABLE_CC7_ASSERT");
+#endif
+#if defined(ENABLE_CC7_LOG)
+		flags.append(" ENABLE_CC7_LOG");
+#endif
+#if defined(ENABLE_CC7_TRACE)
+		flags.append(" ENABLE_CC7_TRACE");
+#endif
+#if defined(ENABLE_CC7_ALLOCATION_STATS)
+		flags.append(" ENABLE_CC7_ALLOCATION_STATS");
+#endif
+		return flags;
+	}
+	
+	BenchmarkContext BenchmarkContext::currentContext()
+	{
+		BenchmarkContext context;
+		context.cpu_model = Platform_GetCPUModel();
+		context.build_flags = _BuildFlags();
+		return context;
+	}
+	
+	
+	// MARK: - JSON export
+	
+	static void _AppendJSONString(std::string & out, const std::string & str)
+	{
+		out.push_back('"');
+		for (char c : str) {
+			if (c == '"' || c == '\\') {
+				out.push_back('\\');
+				out.push_back(c);
+			} else if ((unsigned char)c < 32) {
+				out.append(detail::FormattedString("\\u%04x", (unsigned)c));
+			} else {
+				out.push_back(c);
+			}
+		}
+		out.push_back('"');
+	}
+	
+	std::string BenchmarkResultsToJSON(const std::vector<BenchmarkResult> & results, const BenchmarkContext & context)
+	{
+		std::string out;
+		out.reserve(1024 + results.size() * 512);
+		out.append("{\n  \"context\": {\n    \"cpu_model\": ");
+		_AppendJSONString(out, context.cpu_model);
+		out.append(",\n    \"build_flags\": ");
+		_AppendJSONString(out, context.build_flags);
+		out.append("\n  },\n  \"benchmarks\": [");
+		bool first = true;
+		for (auto && r : results) {
+			out.append(first ? "\n    {\n      \"name\": " : ",\n    {\n      \"name\": ");
+			first = false;
+			_AppendJSONString(out, r.name);
+			out.append(detail::FormattedString(",\n      \"iterations\": %llu,\n      \"bytes_per_iteration\": %llu,\n",
+											   (unsigned long long)r.iterations, (unsigned long long)r.bytes_per_iteration));
+			out.append(detail::FormattedString("      \"stats\": { \"min\": %.4f, \"median\": %.4f, \"mean\": %.4f, \"p99\": %.4f, \"stddev\": %.4f, \"bytes_per_second\": %.1f },\n",
+											   r.min, r.median, r.mean, r.p99, r.stddev, r.bytes_per_second));
+			if (r.counters_available) {
+				out.append("      \"counters\": {");
+				bool first_counter = true;
+				for (int c = 0; c < PerformanceCounters::CountersCount; c++) {
+					PerformanceCounters::Counter counter = (PerformanceCounters::Counter)c;
+					if (r.hasCounter(counter)) {
+						out.append(detail::FormattedString(first_counter ? " \"%s\": %.3f" : ", \"%s\": %.3f", PerformanceCounters::counterName(counter), r.counters[c]));
+						first_counter = false;
+					}
+				}
+				out.append(" },\n");
+			}
+			out.append("      \"samples\": [");
+			for (size_t i = 0; i < r.samples.size(); i++) {
+				out.append(detail::FormattedString(i > 0 ? ", %.4f" : "%.4f", r.samples[i]));
+			}
+			out.append("]\n    }");
+		}
+		out.append("\n  ]\n}\n");
+		return out;
+	}
+	
+	
+	// MARK: - Statistics
+	
+	double MannWhitneyGreaterPValue(const std::vector<double> & a, const std::vector<double> & b)
+	{
+		const size_t n1 = a.size();
+		const size_t n2 = b.size();
+		if (n1 == 0 || n2 == 0) {
+			return 1.0;
+		}
+		// Rank all values together. Ties get an average rank.
+		std::vector<std::pair<double, int>> all;
+		all.reserve(n1 + n2);
+		for (double v : a) {
+			all.push_back(std::make_pair(v, 0));
+		}
+		for (double v : b) {
+			all.push_back(std::make_pair(v, 1));
+		}
+		std::sort(all.begin(), all.end());
+		
+		double rank_sum_a = 0.0;
+		double tie_correction = 0.0;
+		size_t i = 0;
+		while (i < all.size()) {
+			size_t j = i;
+			while (j + 1 < all.size() && all[j + 1].first == all[i].first) {
+				j++;
+			}
+			double rank = (double)(i + j + 2) * 0.5;		// ranks are 1-based
+			double t = (double)(j - i + 1);
+			tie_correction += t * t * t - t;
+			for (size_t k = i; k <= j; k++) {
+				if (all[k].second == 0) {
+					rank_sum_a += rank;
+				}
+			}
+			i = j + 1;
+		}
+		const double N = (double)(n1 + n2);
+		const double u = rank_sum_a - (double)n1 * (n1 + 1) * 0.5;
+		const double mean_u = (double)n1 * n2 * 0.5;
+		const double var_u = (double)n1 * n2 / 12.0 * ((N + 1.0) - tie_correction / (N * (N - 1.0)));
+		if (var_u <= 0.0) {
+			return 1.0;
+		}
+		// Continuity correction
+		const double z = (u - mean_u - 0.5) / sqrt(var_u);
+		return 0.5 * erfc(z / sqrt(2.0));
+	}
+	
+	
+	// MARK: - Baseline
+	
+	std::string BenchmarkComparison::toString() const
+	{
+		return detail::FormattedString("%s: %.3f ns/op vs baseline %.3f ns/op (%+.1f%%, p = %.4f)%s",
+									   name.c_str(), current_median, baseline_median,
+									   (ratio - 1.0) * 100.0, p_value,
+									   regression ? " => REGRESSION" : "");
+	}
+	
+	BenchmarkBaseline::BenchmarkBaseline() :
+		_threshold(0.05),
+		_alpha(0.01)
+	{
+	}
+	
+	static double _NumberValue(const JSONValue & value)
+	{
+		if (value.isType(JSONValue::Integer)) {
+			return (double)value.asInteger();
+		}
+		return value.asDouble();
+	}
+	
+	bool BenchmarkBaseline::load(const cc7::ByteRange & json_data, std::string * out_error)
+	{
+		_samples.clear();
+		JSONValue root;
+		if (!JSON_ParseData(json_data, root, out_error)) {
+			return false;
+		}
+		try {
+			for (auto && item : root.arrayAtPath("benchmarks")) {
+				std::vector<double> samples;
+				for (auto && sample : item.arrayAtPath("samples")) {
+					samples.push_back(_NumberValue(sample));
+				}
+				_samples[item.stringAtPath("name")] = samples;
+			}
+		} catch (std::exception & exc) {
+			if (out_error) {
+				*out_error = exc.what();
+			}
+			_samples.clear();
+			return false;
+		}
+		return true;
+	}
+	
+	bool BenchmarkBaseline::isEmpty() const
+	{
+		return _samples.empty();
+	}
+	
+	void BenchmarkBaseline::setThreshold(double threshold)
+	{
+		_threshold = threshold;
+	}
+	
+	double BenchmarkBaseline::threshold() const
+	{
+		return _threshold;
+	}
+	
+	void BenchmarkBaseline::setSignificanceLevel(double alpha)
+	{
+		_alpha = alpha;
+	}
+	
+	double BenchmarkBaseline::significanceLevel() const
+	{
+		return _alpha;
+	}
+	
+	bool BenchmarkBaseline::compare(const BenchmarkResult & result, BenchmarkComparison & out_comparison) const
+	{
+		auto it = _samples.find(result.name);
+		if (it == _samples.end() || it->second.empty()) {
+			return false;
+		}
+		BenchmarkResult baseline;
+		baseline.samples = it->second;
+		baseline.computeStatistics();
+		
+		out_comparison.name = result.name;
+		out_comparison.baseline_median = baseline.median;
+		out_comparison.current_median = result.median;
+		out_comparison.ratio = baseline.median > 0.0 ? result.median / baseline.median : 1.0;
+		out_comparison.p_value = MannWhitneyGreaterPValue(result.samples, baseline.samples);
+		out_comparison.regression = out_comparison.ratio > 1.0 + _threshold && out_comparison.p_value < _alpha;
+		return true;
+	}
+	
+} // cc7::tests
+} // cc7
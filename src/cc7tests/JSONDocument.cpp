@@ -0,0 +1,191 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cc7tests/JSONDocument.h>
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+namespace cc7
+{
+namespace tests
+{
+	// MARK: - JSONNode
+	
+	const JSONNode & JSONNode::at(size_t index) const
+	{
+		castToType(JSONValue::Array);
+		if (index >= _size) {
+			throw std::out_of_range("Index is out of range");
+		}
+		return _children[index];
+	}
+	
+	const JSONNode & JSONNode::keyAt(size_t index) const
+	{
+		castToType(JSONValue::Object);
+		if (index >= _size) {
+			throw std::out_of_range("Index is out of range");
+		}
+		return _children[index * 2];
+	}
+	
+	const JSONNode & JSONNode::valueAt(size_t index) const
+	{
+		castToType(JSONValue::Object);
+		if (index >= _size) {
+			throw std::out_of_range("Index is out of range");
+		}
+		return _children[index * 2 + 1];
+	}
+	
+	const JSONNode * JSONNode::find(const cc7::ByteRange & key) const
+	{
+		castToType(JSONValue::Object);
+		// The objects are typically small, so the linear search is fast enough.
+		// The search goes backwards, so the last duplicate key wins, like in JSONValue.
+		const JSONNode * member = _children + _size * 2;
+		while (member != _children) {
+			member -= 2;
+			if (member->_size == key.size() && memcmp(member->_string, key.data(), key.size()) == 0) {
+				return member + 1;
+			}
+		}
+		return nullptr;
+	}
+	
+	const JSONNode & JSONNode::valueAtPath(const std::string & path, Type expected_type) const
+	{
+		return valueAtPath(JSONPath::cachedPath(path), expected_type);
+	}
+	
+	const JSONNode & JSONNode::valueAtPath(const JSONPath & path, Type expected_type) const
+	{
+		const JSONNode & selected_node = path.evaluate(*this);
+		if (expected_type != JSONValue::NaT) {
+			if (!selected_node.isType(expected_type)) {
+				throw std::invalid_argument("The selected JSONNode has unexpected type.");
+			}
+		}
+		return selected_node;
+	}
+	
+	JSONValue JSONNode::toValue() const
+	{
+		if ((_t == JSONValue::Object || _t == JSONValue::Array) && _size == 0) {
+			// The empty container is not allocated.
+			return JSONValue(_t);
+		}
+		switch (_t) {
+			case JSONValue::Object: {
+				JSONValue object(JSONValue::Object);
+				auto & result = object.asMutableObject();
+				result.reserve(_size);
+				for (size_t i = 0; i < _size; i++) {
+					const JSONNode & key = _children[i * 2];
+					result.appendUnsorted(std::string(key._string, key._size), _children[i * 2 + 1].toValue());
+				}
+				result.sortMembers();
+				return object;
+			}
+			case JSONValue::Array: {
+				JSONValue array(JSONValue::Array);
+				auto & result = array.asMutableArray();
+				result.reserve(_size);
+				for (size_t i = 0; i < _size; i++) {
+					result.emplace_back(_children[i].toValue());
+				}
+				return array;
+			}
+			case JSONValue::String: {
+				JSONValue string(JSONValue::String);
+				string.assign(_string, _size);
+				return string;
+			}
+			case JSONValue::Integer:
+				return JSONValue(_integer);
+			case JSONValue::Double:
+				return JSONValue(_double);
+			case JSONValue::Boolean:
+				return JSONValue(_boolean);
+			case JSONValue::Null:
+				return JSONValue(JSONValue::Null);
+			default:
+				return JSONValue();
+		}
+	}
+	
+	
+	// MARK: - JSONDocument
+	
+	// The first block in the arena has at least this size.
+	static const size_t kMinimumBlockSize = 4096;
+	
+	JSONDocument::JSONDocument() :
+		_blocks(nullptr),
+		_allocated_bytes(0),
+		_next_block_size(kMinimumBlockSize)
+	{
+	}
+	
+	JSONDocument::~JSONDocument()
+	{
+		clear();
+	}
+	
+	void JSONDocument::clear()
+	{
+		// The nodes are trivially destructible, so only the blocks are released.
+		Block * block = _blocks;
+		while (block) {
+			Block * next = block->next;
+			free(block);
+			block = next;
+		}
+		_blocks = nullptr;
+		_allocated_bytes = 0;
+		_next_block_size = kMinimumBlockSize;
+		_root = JSONNode();
+	}
+	
+	void * JSONDocument::allocate(size_t size)
+	{
+		// Size of block's header, aligned to 8 bytes.
+		const size_t kBlockHeaderSize = (sizeof(Block) + 7) & ~size_t(7);
+		size = (size + 7) & ~size_t(7);
+		Block * block = _blocks;
+		if (!block || block->size - block->used < size) {
+			// Allocate a new block. The size of blocks grows exponentially, so the number
+			// of blocks is kept low even for large documents.
+			size_t block_size = std::max(_next_block_size, size);
+			block = reinterpret_cast<Block*>(malloc(kBlockHeaderSize + block_size));
+			if (!block) {
+				throw std::bad_alloc();
+			}
+			block->next = _blocks;
+			block->size = block_size;
+			block->used = 0;
+			_blocks = block;
+			_allocated_bytes += block_size;
+			_next_block_size = block_size * 2;
+		}
+		void * result = reinterpret_cast<cc7::byte*>(block) + kBlockHeaderSize + block->used;
+		block->used += size;
+		return result;
+	}
+	
+} // cc7::tests
+} // cc7
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cc7tests/JSONLazyDocument.h>
+#include <cc7tests/JSONReader.h>
+#include <cc7tests/detail/JSONScanner.h>
+#include <cc7tests/detail/StringUtils.h>
+#include <string.h>
+
+namespace cc7
+{
+namespace tests
+{
+	static const size_t kInvalidOffset = (size_t)-1;
+	
+	// MARK: - Construction
+	
+	JSONLazyDocument::JSONLazyDocument()
+	{
+	}
+	
+	JSONLazyDocument::JSONLazyDocument(const cc7::ByteRange & data) :
+		_data(data)
+	{
+	}
+	
+	void JSONLazyDocument::load(const cc7::ByteRange & data)
+	{
+		clear();
+		_data.assign(data);
+	}
+	
+	void JSONLazyDocument::clear()
+	{
+		_data.clear();
+		_containers.clear();
+		_values.clear();
+	}
+	
+	
+	// MARK: - Queries
+	
+	const JSONValue & JSONLazyDocument::root() const
+	{
+		return *select(JSONPath(), true);
+	}
+	
+	const JSONValue & JSONLazyDocument::valueAtPath(const std::string & path, Type expected_type) const
+	{
+		return valueAtPath(JSONPath::cachedPath(path), expected_type);
+	}
+	
+	const JSONValue & JSONLazyDocument::valueAtPath(const JSONPath & path, Type expected_type) const
+	{
+		const JSONValue & selected_obj = *select(path, true);
+		if (expected_type != JSONValue::NaT) {
+			if (!selected_obj.isType(expected_type)) {
+				throw std::invalid_argument("The selected JSONValue has unexpected type.");
+			}
+		}
+		return selected_obj;
+	}
+	
+	const JSONValue * JSONLazyDocument::find(const JSONPath & path) const
+	{
+		return select(path, false);
+	}
+	
+	
+	// MARK: - Private methods
+	
+	const JSONValue * JSONLazyDocument::select(const JSONPath & path, bool throw_error) const
+	{
+		Span span;
+		span.begin = skipWhitespace(0);
+		span.end   = kInvalidOffset;
+		if (span.begin == _data.size()) {
+			// Empty document
+			if (path.size() > 0) {
+				if (!throw_error) {
+					return nullptr;
+				}
+				throw std::invalid_argument("JSONLazyDocument is empty.");
+			}
+			span.end = span.begin;
+			return &parsedValue(span);
+		}
+		for (auto && component : path._components) {
+			const Member * selected = nullptr;
+			if (!component.is_index) {
+				if (_data[span.begin] != '{') {
+					if (!throw_error) {
+						return nullptr;
+					}
+					throw std::invalid_argument("JSONValue is not an Object. Key: '" + component.key + "'");
+				}
+				// The search goes backwards, so the last duplicate key wins, like in JSONValue.
+				const Container & object = container(span.begin);
+				for (auto it = object.members.rbegin(); it != object.members.rend(); ++it) {
+					if (isEqualKey(*it, component.key)) {
+						selected = &*it;
+						break;
+					}
+				}
+				if (!selected) {
+					if (!throw_error) {
+						return nullptr;
+					}
+					throw std::invalid_argument("JSONValue has no such key: '" + component.key + "'");
+				}
+			} else {
+				if (_data[span.begin] != '[') {
+					if (!throw_error) {
+						return nullptr;
+					}
+					throw std::invalid_argument(detail::FormattedString("JSONValue is not an Array. Index: %u", (unsigned)component.index));
+				}
+				const Container & array = container(span.begin);
+				if (component.index >= array.members.size()) {
+					if (!throw_error) {
+						return nullptr;
+					}
+					throw std::invalid_argument(detail::FormattedString("JSONValue has no such index: %u", (unsigned)component.index));
+				}
+				selected = &array.members[component.index];
+			}
+			span = selected->value;
+		}
+		if (span.end == kInvalidOffset) {
+			// The root value, the rest of document must contain only whitespaces
+			span.end = skipValue(span.begin);
+			if (skipWhitespace(span.end) != _data.size()) {
+				throwError(span.end, "Unexpected data after the end of document");
+			}
+		}
+		return &parsedValue(span);
+	}
+	
+	const JSONLazyDocument::Container & JSONLazyDocument::container(size_t begin) const
+	{
+		auto it = _containers.find(begin);
+		if (it != _containers.end()) {
+			return it->second;
+		}
+		
+		// Scan the container and record boundaries of its members. The members
+		// are skipped, so the nested containers are not recorded.
+		Container result;
+		const bool is_object = _data[begin] == '{';
+		const cc7::byte closing = is_object ? '}' : ']';
+		size_t offset = skipWhitespace(begin + 1);
+		if (offset < _data.size() && _data[offset] == closing) {
+			offset = kInvalidOffset;
+		}
+		while (offset != kInvalidOffset) {
+			Member member;
+			member.key.begin = member.key.end = 0;
+			member.escaped = false;
+			if (is_object) {
+				if (offset >= _data.size() || _data[offset] != '"') {
+					throwError(offset, "Key is expected");
+				}
+				member.key.begin = offset + 1;
+				member.key.end   = skipString(offset) - 1;
+				member.escaped   = memchr(_data.data() + member.key.begin, '\\', member.key.end - member.key.begin) != nullptr;
+				offset = skipWhitespace(member.key.end + 1);
+				if (offset >= _data.size() || _data[offset] != ':') {
+					throwError(offset, "Colon is expected");
+				}
+				offset = skipWhitespace(offset + 1);
+			}
+			member.value.begin = offset;
+			member.value.end   = skipValue(offset);
+			result.members.push_back(member);
+			offset = skipWhitespace(member.value.end);
+			if (offset < _data.size() && _data[offset] == ',') {
+				offset = skipWhitespace(offset + 1);
+			} else if (offset < _data.size() && _data[offset] == closing) {
+				offset = kInvalidOffset;
+			} else {
+				throwError(offset, is_object ? "Comma or end of object is expected" : "Comma or end of array is expected");
+			}
+		}
+		return _containers.emplace(begin, std::move(result)).first->second;
+	}
+	
+	const JSONValue & JSONLazyDocument::parsedValue(const Span & span) const
+	{
+		auto it = _values.find(span.begin);
+		if (it != _values.end()) {
+			return it->second;
+		}
+		JSONValue value;
+		std::string error;
+		if (!JSON_ParseData(cc7::ByteRange(_data.data() + span.begin, span.end - span.begin), value, &error)) {
+			throw std::invalid_argument("JSONLazyDocument: " + error);
+		}
+		return _values.emplace(span.begin, std::move(value)).first->second;
+	}
+	
+	bool JSONLazyDocument::isEqualKey(const Member & member, const std::string & key) const
+	{
+		const size_t size = member.key.end - member.key.begin;
+		if (!member.escaped) {
+			return size == key.size() && memcmp(_data.data() + member.key.begin, key.data(), size) == 0;
+		}
+		// Rare case, the key has to be unescaped by the parser.
+		JSONValue unescaped;
+		if (!JSON_ParseData(cc7::ByteRange(_data.data() + member.key.begin - 1, size + 2), unescaped)) {
+			throwError(member.key.begin, "Invalid key");
+		}
+		return unescaped.asString() == key;
+	}
+	
+	
+	// MARK: - Scanner
+	
+	size_t JSONLazyDocument::skipWhitespace(size_t offset) const
+	{
+		const size_t length = _data.size();
+		while (offset < length) {
+			cc7::byte c = _data[offset];
+			if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+				break;
+			}
+			offset++;
+		}
+		return offset;
+	}
+	
+	size_t JSONLazyDocument::skipString(size_t offset) const
+	{
+		// |offset| points to the opening quote. Returns offset after the closing quote.
+		const size_t length = _data.size();
+		const cc7::byte * p = _data.data();
+		offset++;
+		while (offset < length) {
+			offset += detail::FindJSONStringSpecialCharacter(p + offset, length - offset);
+			if (offset >= length) {
+				break;
+			}
+			cc7::byte c = p[offset];
+			if (c == '"') {
+				return offset + 1;
+			}
+			// Skip the escaped character. The control characters are reported
+			// later, by the parser.
+			offset += c == '\\' ? 2 : 1;
+		}
+		throwError(length, "Unterminated string");
+		return kInvalidOffset;
+	}
+	
+	size_t JSONLazyDocument::skipValue(size_t offset) const
+	{
+		// Returns offset after the value. The skipped value is not validated,
+		// the scanner only finds its end.
+		const size_t length = _data.size();
+		const cc7::byte * p = _data.data();
+		if (offset >= length) {
+			throwError(offset, "Value is expected");
+		}
+		cc7::byte c = p[offset];
+		if (c == '"') {
+			return skipString(offset);
+		}
+		if (c == '{' || c == '[') {
+			size_t depth = 0;
+			while (offset < length) {
+				offset += detail::FindJSONStructuralCharacter(p + offset, length - offset);
+				if (offset >= length) {
+					break;
+				}
+				c = p[offset];
+				if (c == '"') {
+					offset = skipString(offset);
+					continue;
+				}
+				if (c == '{' || c == '[') {
+					depth++;
+				} else if (--depth == 0) {
+					return offset + 1;
+				}
+				offset++;
+			}
+			throwError(length, "Unterminated object or array");
+		}
+		// Number or literal, ends at the first separator
+		size_t begin = offset;
+		while (offset < length) {
+			c = p[offset];
+			if (c == ',' || c == '}' || c == ']' || c == ':' || c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+				break;
+			}
+			offset++;
+		}
+		if (offset == begin) {
+			throwError(offset, "Value is expected");
+		}
+		return offset;
+	}
+	
+	void JSONLazyDocument::throwError(size_t offset, const char * message) const
+	{
+		throw std::invalid_argument(detail::FormattedString("JSONLazyDocument: %s at offset %u", message, (unsigned)offset));
+	}
+
+} // cc7::tests
+} // cc7
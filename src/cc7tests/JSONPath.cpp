@@ -0,0 +1,202 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cc7tests/JSONPath.h>
+#include <cc7tests/JSONDocument.h>
+#include <cc7tests/detail/StringUtils.h>
+
+namespace cc7
+{
+namespace tests
+{
+	// MARK: - Compilation
+	
+	JSONPath::JSONPath()
+	{
+	}
+	
+	JSONPath::JSONPath(const std::string & path) :
+		_path(path)
+	{
+		const size_t length = path.length();
+		size_t pos = 0;
+		while (pos < length) {
+			char c = path[pos];
+			if (c == '.') {
+				// Empty components are ignored
+				pos++;
+				continue;
+			}
+			if (c != '[') {
+				// Key
+				size_t end = path.find_first_of(".[", pos);
+				if (end == std::string::npos) {
+					end = length;
+				}
+				Component component = { path.substr(pos, end - pos), 0, false };
+				_components.push_back(component);
+				pos = end;
+			}
+			// Optional indices, directly after the key
+			while (pos < length && path[pos] == '[') {
+				pos++;
+				size_t index = 0;
+				size_t digits = 0;
+				while (pos < length && path[pos] >= '0' && path[pos] <= '9') {
+					index = index * 10 + (path[pos] - '0');
+					pos++;
+					digits++;
+				}
+				if (digits == 0 || digits > 9 || pos >= length || path[pos] != ']') {
+					throw std::invalid_argument("The provided path has invalid index: '" + path + "'");
+				}
+				pos++;
+				Component component = { std::string(), index, true };
+				_components.push_back(component);
+			}
+			if (pos < length && path[pos] != '.') {
+				throw std::invalid_argument("The provided path is wrong: '" + path + "'");
+			}
+		}
+		if (_components.empty()) {
+			throw std::invalid_argument("The provided path is wrong or empty.");
+		}
+	}
+	
+	
+	// MARK: - Evaluation
+	
+	//
+	// Access to JSONValue and JSONNode, for the common implementation of select()
+	//
+	
+	static inline const JSONValue * _FindMember(const JSONValue & object, const std::string & key)
+	{
+		auto && members = object.asObject();
+		auto it = members.find(key);
+		return it != members.end() ? &it->second : nullptr;
+	}
+	
+	static inline const JSONValue * _FindElement(const JSONValue & array, size_t index)
+	{
+		auto && elements = array.asArray();
+		return index < elements.size() ? &elements[index] : nullptr;
+	}
+	
+	static inline const JSONNode * _FindMember(const JSONNode & object, const std::string & key)
+	{
+		return object.find(key);
+	}
+	
+	static inline const JSONNode * _FindElement(const JSONNode & array, size_t index)
+	{
+		return index < array.size() ? &array.at(index) : nullptr;
+	}
+	
+	static inline const char * _TypeName(const JSONValue &)
+	{
+		return "JSONValue";
+	}
+	
+	static inline const char * _TypeName(const JSONNode &)
+	{
+		return "JSONNode";
+	}
+	
+	template <typename T>
+	const T * JSONPath::select(const T & root, bool throw_error) const
+	{
+		const T * selected = &root;
+		for (auto && component : _components) {
+			if (!component.is_index) {
+				if (!selected->isType(JSONValue::Object)) {
+					if (!throw_error) {
+						return nullptr;
+					}
+					throw std::invalid_argument(std::string(_TypeName(root)) + " is not an Object. Key: '" + component.key + "'");
+				}
+				selected = _FindMember(*selected, component.key);
+				if (!selected) {
+					if (!throw_error) {
+						return nullptr;
+					}
+					throw std::invalid_argument(std::string(_TypeName(root)) + " has no such key: '" + component.key + "'");
+				}
+			} else {
+				if (!selected->isType(JSONValue::Array)) {
+					if (!throw_error) {
+						return nullptr;
+					}
+					throw std::invalid_argument(detail::FormattedString("%s is not an Array. Index: %u", _TypeName(root), (unsigned)component.index));
+				}
+				selected = _FindElement(*selected, component.index);
+				if (!selected) {
+					if (!throw_error) {
+						return nullptr;
+					}
+					throw std::invalid_argument(detail::FormattedString("%s has no such index: %u", _TypeName(root), (unsigned)component.index));
+				}
+			}
+		}
+		return selected;
+	}
+	
+	const JSONValue & JSONPath::evaluate(const JSONValue & root) const
+	{
+		return *select(root, true);
+	}
+	
+	const JSONNode & JSONPath::evaluate(const JSONNode & root) const
+	{
+		return *select(root, true);
+	}
+	
+	const JSONValue * JSONPath::find(const JSONValue & root) const
+	{
+		return select(root, false);
+	}
+	
+	const JSONNode * JSONPath::find(const JSONNode & root) const
+	{
+		return select(root, false);
+	}
+	
+	
+	// MARK: - Cache
+	
+	// Small per-thread cache of compiled paths. The oldest entry is replaced,
+	// when the cache is full.
+	static const size_t kPathCacheSize = 16;
+	static thread_local JSONPath s_path_cache[kPathCacheSize];
+	static thread_local size_t s_path_cache_next;
+	
+	const JSONPath & JSONPath::cachedPath(const std::string & path)
+	{
+		for (size_t i = 0; i < kPathCacheSize; i++) {
+			if (s_path_cache[i]._path == path && !s_path_cache[i]._components.empty()) {
+				return s_path_cache[i];
+			}
+		}
+		// Compile before the cache is modified, the constructor may throw.
+		JSONPath compiled(path);
+		JSONPath & entry = s_path_cache[s_path_cache_next];
+		s_path_cache_next = (s_path_cache_next + 1) % kPathCacheSize;
+		entry = std::move(compiled);
+		return entry;
+	}
+	
+} // cc7::tests
+} // cc7
@@ -15,9 +15,15 @@
  */
 
 #include <cc7tests/JSONReader.h>
+#include <cc7tests/JSONDocument.h>
 #include <cc7tests/TestDirectory.h>
 #include <cc7tests/detail/StringUtils.h>
-#include <ctype.h>
+#include <cc7tests/detail/JSONNumber.h>
+#include <cc7tests/detail/JSONScanner.h>
+#include <cc7tests/detail/JSONValueBuilder.h>
+#include <cc7/Trace.h>
+#include <string.h>
+#include <algorithm>
 
 namespace cc7
 {
@@ -39,6 +45,7 @@ namespace tests
 		cc7::byte	consumedSeparator;
 		
 		std::string error;
+		std::string stringBuffer;	// Buffer for unescaped strings
 		
 		JSONParserContext(const cc7::ByteRange & range) :
 			ptr(range.data()),
@@ -122,29 +129,51 @@ namespace tests
 	}
 
 	
+	// MARK: Whitespace
+	
+	static inline bool _IsWhitespace(cc7::byte uc)
+	{
+		return uc == ' ' || uc == '\n' || uc == '\r' || uc == '\t';
+	}
+	
 	static cc7::byte _SkipWhitespace(JSONParserContext * ctx)
 	{
 		if (_IsEnd(ctx)) {
 			return 0;
 		}
-		
-		do {
-			cc7::byte uc = ctx->ptr[ctx->offset++];
-			if (!isspace(uc)) {
-				return uc;
-			}
-			if (uc == '\n') {
-				ctx->line++;
-				ctx->lineBegin = ctx->offset - 1;
-			}
-		} while (ctx->offset < ctx->length);
-		
+		// Fast path, there's typically no or just one whitespace between the tokens.
+		cc7::byte uc = ctx->ptr[ctx->offset++];
+		if (!_IsWhitespace(uc)) {
+			return uc;
+		}
+		_SkipBackCount(ctx, 1);
+		// Long whitespace sequences, like the indentation in pretty printed documents,
+		// are skipped by the vectorized scanner.
+		const size_t begin = ctx->offset;
+		size_t newlines_count = 0;
+		size_t last_newline = 0;
+		ctx->offset += detail::SkipJSONWhitespace(_Ptr(ctx), ctx->length - begin, newlines_count, last_newline);
+		if (newlines_count > 0) {
+			ctx->line += newlines_count;
+			ctx->lineBegin = begin + last_newline;
+		}
+		if (ctx->offset < ctx->length) {
+			return ctx->ptr[ctx->offset++];
+		}
 		return 0;
 	}
 	
 	
 	// MARK: Stack & Other
 	
+	static inline bool _CheckHandler(JSONParserContext * ctx, bool result)
+	{
+		if (!result) {
+			_SetParserError(ctx, "Parsing was stopped by the handler");
+		}
+		return result;
+	}
+	
 	static inline bool _PushStack(JSONParserContext * ctx)
 	{
 		ctx->stack++;
@@ -168,51 +197,78 @@ namespace tests
 	
 	// MARK: Forward declarations -
 	
-	static JSONValue _ParseValue  (JSONParserContext * ctx, const cc7::byte * allowedSeparators);
-	static JSONValue _ParseObject (JSONParserContext * ctx);
-	static JSONValue _ParseNumber (JSONParserContext * ctx);
-	static JSONValue _ParseArray  (JSONParserContext * ctx);
-	static JSONValue _ParseString (JSONParserContext * ctx);
+	template <class Handler> static bool _ParseValue (JSONParserContext * ctx, Handler & handler, const cc7::byte * allowedSeparators);
+	template <class Handler> static bool _ParseObject(JSONParserContext * ctx, Handler & handler);
+	template <class Handler> static bool _ParseNumber(JSONParserContext * ctx, Handler & handler);
+	template <class Handler> static bool _ParseArray (JSONParserContext * ctx, Handler & handler);
+	static bool _ParseString(JSONParserContext * ctx, cc7::ByteRange & out_string);
 	static bool _ParseEscapedCharacter(JSONParserContext * ctx, std::string & result);
 	
 	// MARK: Parser -
 	
+	//
+	// The parser reports all parsed values to the handler. The handler must implement
+	// following methods:
+	//
+	//	bool startObject();
+	//	bool key(const cc7::ByteRange & key);
+	//	bool endObject(size_t members_count);
+	//	bool startArray();
+	//	bool endArray(size_t elements_count);
+	//	bool stringValue(const cc7::ByteRange & value);
+	//	bool integerValue(int64_t value);
+	//	bool doubleValue(double value);
+	//	bool booleanValue(bool value);
+	//	bool nullValue();
+	//
+	// If the method returns false, then the parsing is stopped with an error. The public
+	// JSONHandler interface has the same methods, so it can be used directly as a handler.
+	//
+	// The ranges passed to key() and stringValue() points to the parsed data if the string
+	// has no escaped characters. Otherwise the range points to the temporary buffer, which
+	// is valid only during the call.
+	//
+	
 	//
 	// Parse value
 	//
 	
-	static JSONValue _ParseValue(JSONParserContext * ctx, const cc7::byte * allowedSeparators)
+	template <class Handler>
+	static bool _ParseValue(JSONParserContext * ctx, Handler & handler, const cc7::byte * allowedSeparators)
 	{
 		ctx->consumedSeparator = 0;
 		
 		cc7::byte uc = _SkipWhitespace(ctx);
 		if (!uc) {
 			// regular end
-			return JSONValue();
+			return false;
 		}
 		if (uc == '"') {
 			//
 			// string
 			//
-			return _ParseString(ctx);
+			cc7::ByteRange string;
+			if (_ParseString(ctx, string)) {
+				return _CheckHandler(ctx, handler.stringValue(string));
+			}
 			//
 		} else if (uc == '{') {
 			//
 			// object
 			//
-			return _ParseObject(ctx);
+			return _ParseObject(ctx, handler);
 			//
 		} else if (uc == '[') {
 			//
 			// array
 			//
-			return _ParseArray(ctx);
+			return _ParseArray(ctx, handler);
 			//
 		} else if (uc == '-' || (uc >= '0' && uc <= '9')) {
 			//
 			// number
 			//
-			return _ParseNumber(ctx);
+			return _ParseNumber(ctx, handler);
 			//
 		} else if (uc == 't') {
 			//
@@ -221,7 +277,7 @@ namespace tests
 			const cc7::byte * ptr = _ShouldReadPtr(ctx, 3);
 			if (ptr && ptr[0] == 'r' && ptr[1] == 'u' && ptr[2] == 'e') {
 				_SkipCount(ctx, 3);
-				return JSONValue(true);
+				return _CheckHandler(ctx, handler.booleanValue(true));
 			} else {
 				_SetParserError(ctx, "'true' token is expected");
 			}
@@ -233,7 +289,7 @@ namespace tests
 			const cc7::byte * ptr = _ShouldReadPtr(ctx, 4);
 			if (ptr && ptr[0] == 'a' && ptr[1] == 'l' && ptr[2] == 's' && ptr[3] == 'e') {
 				_SkipCount(ctx, 4);
-				return JSONValue(false);
+				return _CheckHandler(ctx, handler.booleanValue(false));
 			} else {
 				_SetParserError(ctx, "'false' token is expected");
 			}
@@ -244,7 +300,7 @@ namespace tests
 			const cc7::byte * ptr = _ShouldReadPtr(ctx, 3);
 			if (ptr && ptr[0] == 'u' && ptr[1] == 'l' && ptr[2] == 'l') {
 				_SkipCount(ctx, 3);
-				return JSONValue(JSONValue::Null);
+				return _CheckHandler(ctx, handler.nullValue());
 			} else {
 				_SetParserError(ctx, "'null' token is expected");
 			}
@@ -253,16 +309,16 @@ namespace tests
 				const cc7::byte * separatorPtr = allowedSeparators;
 				while (*separatorPtr) {
 					if (*separatorPtr++ == uc) {
-						// returns NaT but without error
+						// no value, but without error
 						ctx->consumedSeparator = uc;
-						return JSONValue();
+						return false;
 					}
 				}
 			}
 			_SetParserError(ctx, "Unexpected character in value");
 		}
 		
-		return JSONValue();
+		return false;
 	}
 	
 	
@@ -270,24 +326,27 @@ namespace tests
 	// Parse array
 	//
 	
-	static JSONValue _ParseArray(JSONParserContext * ctx)
+	template <class Handler>
+	static bool _ParseArray(JSONParserContext * ctx, Handler & handler)
 	{
 		if (!_PushStack(ctx)) {
-			return JSONValue();
+			return false;
 		}
 		
 		bool error = false;
-		JSONValue array(JSONValue::Array);
-		auto & result = array.asMutableArray();
+		size_t count = 0;
+		if (!_CheckHandler(ctx, handler.startArray())) {
+			_PopStack(ctx);
+			return false;
+		}
 		
 		// Process values in array
 		static const cc7::byte separator[3] = { ',', ']', 0 };
 		cc7::byte uc;
 		while (1)
 		{
-			JSONValue value = _ParseValue(ctx, separator + 1);
-			if (value.isValid()) {
-				result.push_back(value);
+			if (_ParseValue(ctx, handler, separator + 1)) {
+				count++;
 			} else {
 				if (ctx->consumedSeparator != ']') {
 					// Consumed separator must be ']'. This is error, clear result and break loop.
@@ -320,23 +379,27 @@ namespace tests
 		_PopStack(ctx);
 		
 		if (!error) {
-			return array;
+			return _CheckHandler(ctx, handler.endArray(count));
 		}
-		return JSONValue();
+		return false;
 	}
 	
 	//
 	// Parse object
 	//
-	static JSONValue _ParseObject (JSONParserContext * ctx)
+	template <class Handler>
+	static bool _ParseObject(JSONParserContext * ctx, Handler & handler)
 	{
 		if (!_PushStack(ctx)) {
-			return JSONValue();
+			return false;
 		}
 		
 		bool error = false;
-		JSONValue object(JSONValue::Object);
-		auto & result = object.asMutableObject();
+		size_t count = 0;
+		if (!_CheckHandler(ctx, handler.startObject())) {
+			_PopStack(ctx);
+			return false;
+		}
 		
 		cc7::byte uc;
 		while (1)
@@ -345,8 +408,12 @@ namespace tests
 			// '"' or '}' is expected
 			if (uc == '"') {
 				// Read key
-				JSONValue key = _ParseString(ctx);
-				if (!key.isType(JSONValue::String)) {
+				cc7::ByteRange key;
+				if (!_ParseString(ctx, key)) {
+					error = true;
+					break;
+				}
+				if (!_CheckHandler(ctx, handler.key(key))) {
 					error = true;
 					break;
 				}
@@ -362,10 +429,9 @@ namespace tests
 					break;
 				}
 				// Read value
-				JSONValue value = _ParseValue(ctx, NULL);
-				if (value.isValid()) {
-					// store key - value pair
-					result[key.asString()] = value;
+				if (_ParseValue(ctx, handler, NULL)) {
+					// key - value pair is complete
+					count++;
 				} else {
 					// something is wrong, break loop.
 					// error is already set
@@ -398,48 +464,66 @@ namespace tests
 		_PopStack(ctx);
 		
 		if (!error) {
-			return object;
+			return _CheckHandler(ctx, handler.endObject(count));
 		}
-		return JSONValue();
+		return false;
 	}
 	
 	//
 	// Parse string
 	//
 	
-	static JSONValue _ParseString (JSONParserContext * ctx)
+	static bool _ParseString(JSONParserContext * ctx, cc7::ByteRange & out_string)
 	{
 		if (_IsEnd(ctx)) {
 			_SetParserError(ctx, "Unexpected end of string");
-			return JSONValue();
+			return false;
 		}
 		
 		bool error = false;
-		JSONValue result(JSONValue::String);
-		auto & result_str = result.asMutableString();
+		bool closed = false;
+		// The buffer is used only when the string contains escaped characters.
+		// Otherwise the result points to the parsed data.
+		bool escaped = false;
+		auto & result_str = ctx->stringBuffer;
 		
 		cc7::byte uc;
 		size_t range_location = ctx->offset;
 		size_t range_length   = 0;
 		while (!_IsEnd(ctx))
 		{
+			// Skip all regular characters at once
+			size_t regular_count = detail::FindJSONStringSpecialCharacter(_Ptr(ctx), ctx->length - ctx->offset);
+			_SkipCount(ctx, regular_count);
+			range_length += regular_count;
+			if (_IsEnd(ctx)) {
+				break;
+			}
+			
 			uc = _GetChar(ctx);
 			
 			if (uc == '"') {
 				//
 				// end of string
 				//
-				if (range_length > 0) {
+				if (escaped) {
 					// flush previously captured string fragment
 					result_str.append(_CharPtr(ctx, range_location), range_length);
-					range_length = 0;
+					out_string.assign(result_str);
+				} else {
+					out_string.assign(ctx->ptr + range_location, range_length);
 				}
+				closed = true;
 				break;
 				
 			} else if (uc == '\\') {
 				//
 				// escaped character
 				//
+				if (!escaped) {
+					escaped = true;
+					result_str.clear();
+				}
 				if (range_length > 0) {
 					// flush previously captured string fragment
 					result_str.append(_CharPtr(ctx, range_location), range_length);
@@ -452,28 +536,21 @@ namespace tests
 				// Valid escaped character. Keep start for new fragment
 				range_location = ctx->offset;
 				continue;
-				
-				
-			} else if (uc < 32) {
-				_SetParserError(ctx, "Unexpected control character in string");
-				error = true;
-				break;
 			}
 			
 			//
-			// valid characted, just increase length in capturing range
+			// control character
 			//
-			range_length++;
+			_SetParserError(ctx, "Unexpected control character in string");
+			error = true;
+			break;
 		}
 		
-		if (range_length > 0) {
+		if (!error && !closed) {
 			_SetParserError(ctx, "Unexpected end of string");
 			error = true;
 		}
-		if (!error) {
-			return result;
-		}
-		return JSONValue();
+		return !error;
 	}
 	
 	static inline bool _Hex2Char(const cc7::byte * p, cc7::byte & out)
@@ -607,65 +684,163 @@ namespace tests
 	// Parse number
 	//
 	
-	static JSONValue _ParseNumber(JSONParserContext * ctx)
+	template <class Handler>
+	static bool _ParseNumber(JSONParserContext * ctx, Handler & handler)
 	{
 		size_t begin = ctx->offset - 1;
 		
-		bool has_exponent = false;
-		bool has_decimal_mark = false;
-		bool error = false;
+		// The number is parsed directly from the input data, with no temporary string.
+		detail::JSONNumber number;
+		size_t consumed = detail::ParseJSONNumber(ctx->ptr + begin, ctx->length - begin, number);
+		if (consumed > 0) {
+			ctx->offset = begin + consumed;
+			if (number.is_double) {
+				return _CheckHandler(ctx, handler.doubleValue(number.double_value));
+			}
+			return _CheckHandler(ctx, handler.integerValue(number.integer_value));
+		}
+		// Set pointer back, at the beginning of the number
+		ctx->offset = begin;
+		_SetParserError(ctx, "Invalid number");
+		return false;
+	}
+	
+	
+	//
+	// MARK: Builders -
+	//
+	
+	namespace detail
+	{
+		//
+		// The JSONDocumentBuilder creates nodes in the JSONDocument's arena. The nodes are
+		// collected on the stack and copied to the arena, once the container is complete,
+		// so the children of one container are always stored in a contiguous block.
+		//
 		
-		while (!_IsEnd(ctx) && !error)
+		class JSONDocumentBuilder
 		{
-			cc7::byte uc = _GetChar(ctx);
-			if (uc >= '0' && uc <= '9') {
-				// regular digit
-				continue;
-			} else if (uc == '.') {
-				// decimal mark
-				if (!has_decimal_mark) {
-					has_decimal_mark = true;
-				} else {
-					// double decimal mark
-					error = true;
-				}
-			} else  if (uc == 'e' || uc == 'E') {
-				// exponent
-				if (!has_exponent && _ShouldReadPtr(ctx, 1)) {
-					// validate if E is foolowed by +/- or digit
-					has_exponent = true;
-					uc = _GetChar(ctx);
-					if ((uc >= '0' && uc <= '9') || uc == '+' || uc == '-') {
-						continue;
-					}
-					error = true;
+		public:
+			
+			JSONDocumentBuilder(JSONDocument & document, const cc7::ByteRange & data) :
+				_document(document),
+				_data(data)
+			{
+			}
+			
+			bool startObject()
+			{
+				return true;
+			}
+			
+			bool key(const cc7::ByteRange & key)
+			{
+				pushString(key);
+				return true;
+			}
+			
+			bool endObject(size_t members_count)
+			{
+				pushContainer(JSONValue::Object, members_count, members_count * 2);
+				return true;
+			}
+			
+			bool startArray()
+			{
+				return true;
+			}
+			
+			bool endArray(size_t elements_count)
+			{
+				pushContainer(JSONValue::Array, elements_count, elements_count);
+				return true;
+			}
+			
+			bool stringValue(const cc7::ByteRange & value)
+			{
+				pushString(value);
+				return true;
+			}
+			
+			bool integerValue(int64_t value)
+			{
+				JSONNode node;
+				node._t = JSONValue::Integer;
+				node._integer = value;
+				_nodes.push_back(node);
+				return true;
+			}
+			
+			bool doubleValue(double value)
+			{
+				JSONNode node;
+				node._t = JSONValue::Double;
+				node._double = value;
+				_nodes.push_back(node);
+				return true;
+			}
+			
+			bool booleanValue(bool value)
+			{
+				JSONNode node;
+				node._t = JSONValue::Boolean;
+				node._boolean = value;
+				_nodes.push_back(node);
+				return true;
+			}
+			
+			bool nullValue()
+			{
+				JSONNode node;
+				node._t = JSONValue::Null;
+				_nodes.push_back(node);
+				return true;
+			}
+			
+			JSONNode takeResult()
+			{
+				return _nodes.empty() ? JSONNode() : _nodes.back();
+			}
+			
+		private:
+			
+			void pushString(const cc7::ByteRange & string)
+			{
+				JSONNode node;
+				node._t = JSONValue::String;
+				node._size = (cc7::U32)string.size();
+				if (string.data() >= _data.data() && string.data() + string.size() <= _data.data() + _data.size()) {
+					// The string points to the parsed data, so it's not copied.
+					node._string = reinterpret_cast<const char*>(string.data());
 				} else {
-					// double exponent symbol or unexpected end
-					error = true;
+					// The string was unescaped to the temporary buffer.
+					char * copy = reinterpret_cast<char*>(_document.allocate(string.size()));
+					memcpy(copy, string.data(), string.size());
+					node._string = copy;
 				}
-			} else {
-				// unknown character, may be processed later
-				// we have to go back with offset
-				_SkipBackCount(ctx, 1);
-				break;
+				_nodes.push_back(node);
 			}
-		}
-		if (!error) {
-			try {
-				std::string number(_CharPtr(ctx, + begin), ctx->offset - begin);
-				if (has_exponent || has_decimal_mark) {
-					return JSONValue(std::stod(number));
+			
+			void pushContainer(JSONValue::Type type, size_t size, size_t nodes_count)
+			{
+				JSONNode node;
+				node._t = type;
+				node._size = (cc7::U32)size;
+				if (nodes_count > 0) {
+					JSONNode * children = reinterpret_cast<JSONNode*>(_document.allocate(nodes_count * sizeof(JSONNode)));
+					memcpy(children, &_nodes[_nodes.size() - nodes_count], nodes_count * sizeof(JSONNode));
+					_nodes.resize(_nodes.size() - nodes_count);
+					node._children = children;
 				} else {
-					return JSONValue((int64_t)std::stoll(number));
+					node._children = nullptr;
 				}
-			} catch (std::exception & exc) {
-				error = true;
+				_nodes.push_back(node);
 			}
-		}
-		// Set pointer back, at the beginning of the number
-		ctx->offset = begin;
-		_SetParserError(ctx, "Invalid number");
-		return JSONValue();
+			
+			JSONDocument & _document;
+			cc7::ByteRange _data;
+			std::vector<JSONNode> _nodes;
+		};
 	}
 	
 	
@@ -681,18 +856,41 @@ namespace tests
 	
 	bool JSON_ParseData(const ByteRange & range, JSONValue & out_value, std::string * out_error)
 	{
+		CC7_TRACE_SCOPE("JSON_ParseData");
+		CC7_TRACE_COUNTER("JSON_ParseData.bytes", range.size());
+		
 		JSONParserContext ctx(range);
-		out_value = _ParseValue(&ctx, nullptr);
-		if (out_value.isValid() && ctx.error.empty()) {
+		detail::JSONValueBuilder builder;
+		bool has_value = _ParseValue(&ctx, builder, nullptr);
+		if (has_value && ctx.error.empty()) {
 			// valid result
+			out_value = builder.takeResult();
 			return true;
 		}
-		if (ctx.error.empty() & out_value.isType(JSONValue::NaT)) {
+		if (ctx.error.empty()) {
 			// empty result, no error
 			out_value.assignNull();
 			return true;
 		}
 		// regular error
+		out_value = JSONValue();
+		if (out_error) {
+			out_error->assign(ctx.error);
+		}
+		return false;
+	}
+	
+	
+	bool JSON_ParseData(const ByteRange & range, JSONHandler & handler, std::string * out_error)
+	{
+		CC7_TRACE_SCOPE("JSON_ParseData");
+		CC7_TRACE_COUNTER("JSON_ParseData.bytes", range.size());
+		
+		JSONParserContext ctx(range);
+		_ParseValue(&ctx, handler, nullptr);
+		if (ctx.error.empty()) {
+			return true;
+		}
 		if (out_error) {
 			out_error->assign(ctx.error);
 		}
@@ -712,8 +910,43 @@ namespace tests
 		}
 		return root;
 	}
-
 	
+	
+	//
+	// MARK: Document implementation
+	//
+	
+	bool JSONDocument::parse(const cc7::ByteRange & range, std::string * out_error)
+	{
+		CC7_TRACE_SCOPE("JSONDocument::parse");
+		CC7_TRACE_COUNTER("JSONDocument::parse.bytes", range.size());
+		
+		clear();
+		// The nodes typically occupy more memory than the parsed data, so the
+		// first block can be as big as the data.
+		_next_block_size = std::max(_next_block_size, range.size());
+		
+		JSONParserContext ctx(range);
+		detail::JSONDocumentBuilder builder(*this, range);
+		bool has_value = _ParseValue(&ctx, builder, nullptr);
+		if (has_value && ctx.error.empty()) {
+			// valid result
+			_root = builder.takeResult();
+			return true;
+		}
+		if (ctx.error.empty()) {
+			// empty result, no error
+			builder.nullValue();
+			_root = builder.takeResult();
+			return true;
+		}
+		// regular error
+		clear();
+		if (out_error) {
+			out_error->assign(ctx.error);
+		}
+		return false;
+	}
 
 	
 } // cc7::tests
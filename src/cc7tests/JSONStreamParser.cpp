@@ -0,0 +1,478 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cc7tests/JSONStreamParser.h>
+#include <cc7tests/detail/JSONValueBuilder.h>
+#include <cc7tests/detail/JSONNumber.h>
+#include <cc7tests/detail/JSONScanner.h>
+#include <cc7tests/detail/StringUtils.h>
+
+namespace cc7
+{
+namespace tests
+{
+	// The same limit as in the recursive parser
+	static const size_t kStackLimit = 16;
+	
+	// MARK: - Helper functions
+	
+	static inline bool _IsWhitespace(cc7::byte c)
+	{
+		return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+	}
+	
+	static inline bool _IsNumberCharacter(cc7::byte c)
+	{
+		return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+	}
+	
+	static inline int _HexValue(cc7::byte c)
+	{
+		if (c >= '0' && c <= '9') {
+			return c - '0';
+		} else if (c >= 'A' && c <= 'F') {
+			return c - 'A' + 10;
+		} else if (c >= 'a' && c <= 'f') {
+			return c - 'a' + 10;
+		}
+		return -1;
+	}
+	
+	static void _AppendUTF8(cc7::U32 codepoint, std::string & out)
+	{
+		// The codepoint has only 16 bits, like in the recursive parser.
+		if (codepoint < 0x80) {
+			out.push_back((char)codepoint);
+		} else if (codepoint < 0x800) {
+			out.push_back((char)(0xC0 + (codepoint >> 6)));
+			out.push_back((char)(0x80 + (codepoint & 0x3F)));
+		} else {
+			out.push_back((char)(0xE0 + (codepoint >> 12)));
+			out.push_back((char)(0x80 + ((codepoint >> 6) & 0x3F)));
+			out.push_back((char)(0x80 + (codepoint & 0x3F)));
+		}
+	}
+	
+	
+	// MARK: - Value builder
+	
+	//
+	// The ValueBuilder adapts detail::JSONValueBuilder to JSONHandler interface.
+	//
+	
+	class JSONStreamParser::ValueBuilder : public JSONHandler
+	{
+	public:
+	
+		bool startObject() override								{ return _builder.startObject(); }
+		bool key(const cc7::ByteRange & key) override			{ return _builder.key(key); }
+		bool endObject(size_t members_count) override			{ return _builder.endObject(members_count); }
+		bool startArray() override								{ return _builder.startArray(); }
+		bool endArray(size_t elements_count) override			{ return _builder.endArray(elements_count); }
+		bool stringValue(const cc7::ByteRange & value) override	{ return _builder.stringValue(value); }
+		bool integerValue(int64_t value) override				{ return _builder.integerValue(value); }
+		bool doubleValue(double value) override					{ return _builder.doubleValue(value); }
+		bool booleanValue(bool value) override					{ return _builder.booleanValue(value); }
+		bool nullValue() override								{ return _builder.nullValue(); }
+		
+		JSONValue takeResult()
+		{
+			return _builder.takeResult();
+		}
+		
+		void reset()
+		{
+			_builder = detail::JSONValueBuilder();
+		}
+	
+	private:
+	
+		detail::JSONValueBuilder _builder;
+	};
+	
+	
+	// MARK: - Construction
+	
+	JSONStreamParser::JSONStreamParser(JSONHandler & handler) :
+		_handler(&handler)
+	{
+		reset();
+	}
+	
+	JSONStreamParser::JSONStreamParser(const ValueCallback & callback) :
+		_handler(nullptr),
+		_callback(callback),
+		_builder(new ValueBuilder())
+	{
+		_handler = _builder.get();
+		reset();
+	}
+	
+	JSONStreamParser::~JSONStreamParser()
+	{
+	}
+	
+	void JSONStreamParser::reset()
+	{
+		_state = Value;
+		_stack.clear();
+		_token.clear();
+		_buffered = false;
+		_is_key = false;
+		_literal = nullptr;
+		_literal_offset = 0;
+		_codepoint = 0;
+		_codepoint_digits = 0;
+		_values_count = 0;
+		_offset = 0;
+		_line = 0;
+		_line_begin = 0;
+		_error.clear();
+		if (_builder) {
+			_builder->reset();
+		}
+	}
+	
+	
+	// MARK: - Parser
+	
+	bool JSONStreamParser::feed(const cc7::ByteRange & chunk)
+	{
+		const cc7::byte * p = chunk.data();
+		const size_t length = chunk.size();
+		size_t i = 0;
+		while (i < length) {
+			switch (_state) {
+				case String:
+				{
+					// Skip all regular characters at once
+					const size_t begin = i;
+					i += detail::FindJSONStringSpecialCharacter(p + i, length - i);
+					if (i == length) {
+						// The string continues in the next chunk
+						_token.append(reinterpret_cast<const char*>(p + begin), i - begin);
+						_buffered = true;
+						break;
+					}
+					const cc7::byte c = p[i];
+					if (c == '"') {
+						// If the whole string is in this chunk and has no escaped
+						// characters, then it's reported directly from the chunk.
+						cc7::ByteRange string(p + begin, i - begin);
+						if (_buffered) {
+							_token.append(reinterpret_cast<const char*>(p + begin), i - begin);
+							string.assign(_token);
+						}
+						if (!endString(string, i++)) {
+							return false;
+						}
+					} else if (c == '\\') {
+						_token.append(reinterpret_cast<const char*>(p + begin), i - begin);
+						_buffered = true;
+						_state = StringEscape;
+						i++;
+					} else {
+						return setError("Unexpected control character in string", i);
+					}
+					break;
+				}
+				case StringEscape:
+				{
+					if (!appendEscaped(p[i], i)) {
+						return false;
+					}
+					i++;
+					break;
+				}
+				case StringUnicode:
+				{
+					const int digit = _HexValue(p[i]);
+					if (digit < 0) {
+						return setError("Wrong hexadecimal value in escaped unicode character", i);
+					}
+					_codepoint = (_codepoint << 4) | (cc7::U32)digit;
+					if (++_codepoint_digits == 4) {
+						_AppendUTF8(_codepoint, _token);
+						_state = String;
+					}
+					i++;
+					break;
+				}
+				case Number:
+				{
+					const size_t begin = i;
+					while (i < length && _IsNumberCharacter(p[i])) {
+						i++;
+					}
+					if (i == length) {
+						// The number may continue in the next chunk
+						_token.append(reinterpret_cast<const char*>(p + begin), i - begin);
+						_buffered = true;
+						break;
+					}
+					// The character after the number is not consumed
+					cc7::ByteRange number(p + begin, i - begin);
+					if (_buffered) {
+						_token.append(reinterpret_cast<const char*>(p + begin), i - begin);
+						number.assign(_token);
+					}
+					if (!endNumber(number, begin)) {
+						return false;
+					}
+					break;
+				}
+				case Literal:
+				{
+					if (p[i] != (cc7::byte)_literal[_literal_offset]) {
+						const char * reason = _literal[0] == 't' ? "'true' token is expected" :
+											 (_literal[0] == 'f' ? "'false' token is expected" : "'null' token is expected");
+						return setError(reason, i);
+					}
+					if (_literal[++_literal_offset] == 0) {
+						bool result;
+						if (_literal[0] == 'n') {
+							result = _handler->nullValue();
+						} else {
+							result = _handler->booleanValue(_literal[0] == 't');
+						}
+						if (!checkHandler(result, i) || !endValue(i)) {
+							return false;
+						}
+					}
+					i++;
+					break;
+				}
+				case Failed:
+				{
+					return false;
+				}
+				default:
+				{
+					// Whitespaces are allowed between all tokens
+					const cc7::byte c = p[i];
+					if (_IsWhitespace(c)) {
+						if (c == '\n') {
+							_line++;
+							_line_begin = _offset + i + 1;
+						}
+						i++;
+						break;
+					}
+					if ((_state == Value || _state == FirstElement) && (c == '-' || (c >= '0' && c <= '9'))) {
+						// The number is collected from its first character
+						_token.clear();
+						_buffered = false;
+						_state = Number;
+						break;
+					}
+					const size_t offset = i++;
+					bool result = true;
+					if (_state == Value) {
+						result = startValue(c, offset);
+					} else if (_state == FirstElement) {
+						result = c == ']' ? endContainer(false, offset) : startValue(c, offset);
+					} else if (_state == FirstKey || _state == Key) {
+						if (c == '"') {
+							_token.clear();
+							_buffered = false;
+							_is_key = true;
+							_state = String;
+						} else if (c == '}' && _state == FirstKey) {
+							result = endContainer(true, offset);
+						} else {
+							result = setError("Unknown character in object", offset);
+						}
+					} else if (_state == Colon) {
+						if (c == ':') {
+							_state = Value;
+						} else {
+							result = setError("The colon ':' is expected as key-value separator", offset);
+						}
+					} else {
+						// AfterValue
+						const bool is_object = _stack.back().is_object;
+						if (c == ',') {
+							_state = is_object ? Key : Value;
+						} else if (c == (is_object ? '}' : ']')) {
+							result = endContainer(is_object, offset);
+						} else if (is_object) {
+							result = setError("Unknown character in object", offset);
+						} else {
+							result = setError("Wrong character in array. Characters ']' or ',' are expected", offset);
+						}
+					}
+					if (!result) {
+						return false;
+					}
+					break;
+				}
+			}
+		}
+		_offset += length;
+		return _state != Failed;
+	}
+	
+	bool JSONStreamParser::finish()
+	{
+		if (_state == Failed) {
+			return false;
+		}
+		if (_state == Number && _stack.empty()) {
+			// The number at the end of the stream is complete now.
+			if (!endNumber(cc7::ByteRange(_token), 0)) {
+				return false;
+			}
+		}
+		if (_state != Value || !_stack.empty()) {
+			return setError("Unexpected end of stream", 0);
+		}
+		return true;
+	}
+	
+	
+	// MARK: - Private methods
+	
+	bool JSONStreamParser::startValue(cc7::byte c, size_t offset)
+	{
+		if (c == '"') {
+			_token.clear();
+			_buffered = false;
+			_is_key = false;
+			_state = String;
+			return true;
+		}
+		if (c == '{' || c == '[') {
+			if (_stack.size() + 1 >= kStackLimit) {
+				return setError("The processing stack is too deep", offset);
+			}
+			const bool is_object = c == '{';
+			Level level = { is_object, 0 };
+			_stack.push_back(level);
+			_state = is_object ? FirstKey : FirstElement;
+			return checkHandler(is_object ? _handler->startObject() : _handler->startArray(), offset);
+		}
+		if (c == 't' || c == 'f' || c == 'n') {
+			_literal = c == 't' ? "true" : (c == 'f' ? "false" : "null");
+			_literal_offset = 1;
+			_state = Literal;
+			return true;
+		}
+		return setError("Unexpected character in value", offset);
+	}
+	
+	bool JSONStreamParser::endContainer(bool is_object, size_t offset)
+	{
+		const size_t count = _stack.back().count;
+		_stack.pop_back();
+		if (!checkHandler(is_object ? _handler->endObject(count) : _handler->endArray(count), offset)) {
+			return false;
+		}
+		return endValue(offset);
+	}
+	
+	bool JSONStreamParser::endValue(size_t offset)
+	{
+		if (!_stack.empty()) {
+			_stack.back().count++;
+			_state = AfterValue;
+			return true;
+		}
+		// Top-level value is complete
+		_values_count++;
+		_state = Value;
+		if (_builder) {
+			return checkHandler(_callback(_builder->takeResult()), offset);
+		}
+		return true;
+	}
+	
+	bool JSONStreamParser::endString(const cc7::ByteRange & string, size_t offset)
+	{
+		if (_is_key) {
+			_is_key = false;
+			_state = Colon;
+			return checkHandler(_handler->key(string), offset);
+		}
+		if (!checkHandler(_handler->stringValue(string), offset)) {
+			return false;
+		}
+		return endValue(offset);
+	}
+	
+	bool JSONStreamParser::endNumber(const cc7::ByteRange & number, size_t offset)
+	{
+		detail::JSONNumber result;
+		const size_t consumed = detail::ParseJSONNumber(number.data(), number.size(), result);
+		if (consumed == 0 || consumed != number.size()) {
+			return setError("Invalid number", offset);
+		}
+		if (result.is_double) {
+			if (!checkHandler(_handler->doubleValue(result.double_value), offset)) {
+				return false;
+			}
+		} else {
+			if (!checkHandler(_handler->integerValue(result.integer_value), offset)) {
+				return false;
+			}
+		}
+		return endValue(offset);
+	}
+	
+	bool JSONStreamParser::appendEscaped(cc7::byte c, size_t offset)
+	{
+		switch (c) {
+			case '"':
+			case '/':
+			case '\\':
+				_token.push_back((char)c);
+				break;
+			case 'n': _token.push_back('\n'); break;
+			case 'r': _token.push_back('\r'); break;
+			case 't': _token.push_back('\t'); break;
+			case 'b': _token.push_back('\b'); break;
+			case 'f': _token.push_back('\f'); break;
+			case 'u':
+				_codepoint = 0;
+				_codepoint_digits = 0;
+				_state = StringUnicode;
+				return true;
+			default:
+				return setError("Wrong escaped character in string", offset);
+		}
+		_state = String;
+		return true;
+	}
+	
+	bool JSONStreamParser::checkHandler(bool result, size_t offset)
+	{
+		if (!result) {
+			return setError("Parsing was stopped by the handler", offset);
+		}
+		return true;
+	}
+	
+	bool JSONStreamParser::setError(const char * reason, size_t offset)
+	{
+		// |offset| is relative to the current chunk
+		const size_t line   = _line + 1;
+		const size_t column = _offset + offset - _line_begin + 1;
+		_error = detail::FormattedString("JSON parser error: %s (line %d, offset %d)", reason, (int)line, (int)column);
+		_state = Failed;
+		return false;
+	}
+
+} // cc7::tests
+} // cc7
@@ -15,47 +15,79 @@
  */
 
 #include <cc7tests/JSONReader.h>
-#include <cc7tests/detail/StringUtils.h>
+#include <cc7tests/JSONPath.h>
 #include <cc7/HexString.h>
 #include <cc7/Base64.h>
+#include <stddef.h>
 
 namespace cc7
 {
 namespace tests
 {
-	const JSONValue & JSONValue::valueAtPath(const std::string & path, Type expected_type) const
+	static_assert(sizeof(JSONValue) == 16, "JSONValue is expected to have 16 bytes");
+	
+	void JSONValue::assign(const char * value, size_t length)
 	{
-		auto path_components = detail::SplitString(path, '.');
-		if (path_components.empty()) {
-			throw std::invalid_argument("The provided path is wrong or empty.");
+		if (length <= kInlineCapacity) {
+			// Characters are copied before the old content is released.
+			InlineLayout layout;
+			layout.type = String;
+			layout.inline_length = static_cast<cc7::byte>(length);
+			memcpy(layout.chars, value, length);
+			layout.chars[length] = 0;
+			destroy();
+			_s = layout;
+			return;
 		}
-		if (!isType(Object)) {
-			throw std::invalid_argument("JSONValue is not an Object. Key: *this*");
-		}
-		const JSONValue * selected_obj = this;
-		for (auto&& key : path_components) {
-			if (selected_obj->isType(JSONValue::Object)) {
-				auto&& object_map = selected_obj->asObject();
-				auto value = object_map.find(key);
-				if (value != object_map.end()) {
-					selected_obj = &value->second;
-				}
-			} else {
-				throw std::invalid_argument("JSONValue is not an Object. Key: '" + key + "'");
-			}
+		if (_v.type == String && _v.inline_length == kHeapString && _v.string->capacity >= length) {
+			memmove(_v.string->chars, value, length);
+			_v.string->chars[length] = 0;
+			_v.string->length = length;
+			return;
 		}
+		HeapString * string = static_cast<HeapString*>(::operator new(offsetof(HeapString, chars) + length + 1));
+		string->length = length;
+		string->capacity = length;
+		memcpy(string->chars, value, length);
+		string->chars[length] = 0;
+		destroy();
+		_v.type = String;
+		_v.inline_length = kHeapString;
+		_v.string = string;
+	}
+	
+	const JSONValue::TObject & JSONValue::emptyObject()
+	{
+		static const TObject s_empty;
+		return s_empty;
+	}
+	
+	const JSONValue::TArray & JSONValue::emptyArray()
+	{
+		static const TArray s_empty;
+		return s_empty;
+	}
+	
+	const JSONValue & JSONValue::valueAtPath(const std::string & path, Type expected_type) const
+	{
+		return valueAtPath(JSONPath::cachedPath(path), expected_type);
+	}
+	
+	const JSONValue & JSONValue::valueAtPath(const JSONPath & path, Type expected_type) const
+	{
+		const JSONValue & selected_obj = path.evaluate(*this);
 		if (expected_type != NaT) {
-			if (!selected_obj->isType(expected_type)) {
+			if (!selected_obj.isType(expected_type)) {
 				throw std::invalid_argument("The selected JSONValue has unexpected type.");
 			}
 		}
-		return *selected_obj;
+		return selected_obj;
 	}
 	
 	cc7::ByteArray JSONValue::dataFromBase64StringAtPath(const std::string & path) const
 	{
 		ByteArray result;
-		if (!Base64_Decode(stringAtPath(path), 0, result)) {
+		if (!Base64_Decode(stringAtPath(path).range(), 0, result)) {
 			throw std::invalid_argument("The selected string is not a Base64 string.");
 		}
 		return result;
@@ -64,7 +96,7 @@ namespace tests
 	cc7::ByteArray JSONValue::dataFromHexStringAtPath(const std::string & path) const
 	{
 		ByteArray result;
-		if (!HexString_Decode(stringAtPath(path), result)) {
+		if (!HexString_Decode(stringAtPath(path).range(), result)) {
 			throw std::invalid_argument("The selected string is not a hexadecimal string.");
 		}
 		return result;
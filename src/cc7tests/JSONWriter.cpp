@@ -0,0 +1,325 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cc7tests/JSONWriter.h>
+#include <cc7tests/detail/JSONNumber.h>
+#include <cc7tests/detail/JSONScanner.h>
+#include <math.h>
+
+namespace cc7
+{
+namespace tests
+{
+	// MARK: - Construction
+	
+	JSONWriter::JSONWriter(Mode mode) :
+		_mode(mode),
+		_buffer_size(0),
+		_after_key(false),
+		_root_done(false)
+	{
+	}
+	
+	JSONWriter::JSONWriter(const Sink & sink, Mode mode, size_t buffer_size) :
+		_mode(mode),
+		_sink(sink),
+		_buffer_size(buffer_size),
+		_after_key(false),
+		_root_done(false)
+	{
+		_buffer.reserve(buffer_size);
+	}
+	
+	
+	// MARK: - Output
+	
+	void JSONWriter::flush()
+	{
+		if (_sink && !_buffer.empty()) {
+			_sink(_buffer.data(), _buffer.size());
+			_buffer.clear();
+		}
+	}
+	
+	void JSONWriter::reset()
+	{
+		_buffer.clear();
+		_stack.clear();
+		_after_key = false;
+		_root_done = false;
+	}
+	
+	
+	// MARK: - JSONHandler
+	
+	bool JSONWriter::startObject()
+	{
+		return startContainer(true, '{');
+	}
+	
+	bool JSONWriter::key(const cc7::ByteRange & key)
+	{
+		if (_stack.empty() || !_stack.back().is_object || _after_key) {
+			return false;
+		}
+		Level & level = _stack.back();
+		if (level.count++ > 0) {
+			_buffer.push_back(',');
+		}
+		if (_mode == Pretty) {
+			writeNewLine(_stack.size());
+		}
+		writeString(key.data(), key.size());
+		if (_mode == Pretty) {
+			_buffer.append(": ", 2);
+		} else {
+			_buffer.push_back(':');
+		}
+		_after_key = true;
+		return true;
+	}
+	
+	bool JSONWriter::endObject(size_t /*members_count*/)
+	{
+		return endContainer(true, '}');
+	}
+	
+	bool JSONWriter::startArray()
+	{
+		return startContainer(false, '[');
+	}
+	
+	bool JSONWriter::endArray(size_t /*elements_count*/)
+	{
+		return endContainer(false, ']');
+	}
+	
+	bool JSONWriter::stringValue(const cc7::ByteRange & value)
+	{
+		if (!beginValue()) {
+			return false;
+		}
+		writeString(value.data(), value.size());
+		return endValue();
+	}
+	
+	bool JSONWriter::integerValue(int64_t value)
+	{
+		if (!beginValue()) {
+			return false;
+		}
+		char buffer[20];
+		_buffer.append(buffer, detail::FormatJSONInteger(value, buffer));
+		return endValue();
+	}
+	
+	bool JSONWriter::doubleValue(double value)
+	{
+		if (!beginValue()) {
+			return false;
+		}
+		if (isfinite(value)) {
+			char buffer[32];
+			_buffer.append(buffer, detail::FormatJSONDouble(value, buffer));
+		} else {
+			// JSON has no representation of NaN and infinity
+			_buffer.append("null", 4);
+		}
+		return endValue();
+	}
+	
+	bool JSONWriter::booleanValue(bool value)
+	{
+		if (!beginValue()) {
+			return false;
+		}
+		if (value) {
+			_buffer.append("true", 4);
+		} else {
+			_buffer.append("false", 5);
+		}
+		return endValue();
+	}
+	
+	bool JSONWriter::nullValue()
+	{
+		if (!beginValue()) {
+			return false;
+		}
+		_buffer.append("null", 4);
+		return endValue();
+	}
+	
+	bool JSONWriter::value(const JSONValue & value)
+	{
+		switch (value.type()) {
+			case JSONValue::Object:
+			{
+				if (!startObject()) {
+					return false;
+				}
+				for (auto && member : value.asObject()) {
+					if (!key(member.first) || !this->value(member.second)) {
+						return false;
+					}
+				}
+				return endObject();
+			}
+			case JSONValue::Array:
+			{
+				if (!startArray()) {
+					return false;
+				}
+				for (auto && element : value.asArray()) {
+					if (!this->value(element)) {
+						return false;
+					}
+				}
+				return endArray();
+			}
+			case JSONValue::String:
+				return stringValue(value.asString().range());
+			case JSONValue::Integer:
+				return integerValue(value.asInteger());
+			case JSONValue::Double:
+				return doubleValue(value.asDouble());
+			case JSONValue::Boolean:
+				return booleanValue(value.asBoolean());
+			default:
+				return nullValue();
+		}
+	}
+	
+	
+	// MARK: - Private methods
+	
+	bool JSONWriter::beginValue()
+	{
+		if (_after_key) {
+			_after_key = false;
+			return true;
+		}
+		if (_stack.empty()) {
+			// Only one top-level value is allowed
+			return !_root_done;
+		}
+		Level & level = _stack.back();
+		if (level.is_object) {
+			// Key is expected
+			return false;
+		}
+		if (level.count++ > 0) {
+			_buffer.push_back(',');
+		}
+		if (_mode == Pretty) {
+			writeNewLine(_stack.size());
+		}
+		return true;
+	}
+	
+	bool JSONWriter::endValue()
+	{
+		if (_stack.empty()) {
+			_root_done = true;
+		}
+		if (_sink && _buffer.size() >= _buffer_size) {
+			flush();
+		}
+		return true;
+	}
+	
+	bool JSONWriter::startContainer(bool is_object, char bracket)
+	{
+		if (!beginValue()) {
+			return false;
+		}
+		_buffer.push_back(bracket);
+		Level level = { is_object, 0 };
+		_stack.push_back(level);
+		return true;
+	}
+	
+	bool JSONWriter::endContainer(bool is_object, char bracket)
+	{
+		if (_stack.empty() || _stack.back().is_object != is_object || _after_key) {
+			return false;
+		}
+		const bool has_elements = _stack.back().count > 0;
+		_stack.pop_back();
+		if (_mode == Pretty && has_elements) {
+			writeNewLine(_stack.size());
+		}
+		_buffer.push_back(bracket);
+		return endValue();
+	}
+	
+	void JSONWriter::writeNewLine(size_t depth)
+	{
+		_buffer.push_back('\n');
+		_buffer.append(depth * 2, ' ');
+	}
+	
+	void JSONWriter::writeString(const cc7::byte * p, size_t length)
+	{
+		static const char s_hex[] = "0123456789abcdef";
+		_buffer.push_back('"');
+		while (length > 0) {
+			// Copy all regular characters at once
+			size_t regular_count = detail::FindJSONStringSpecialCharacter(p, length);
+			_buffer.append(reinterpret_cast<const char*>(p), regular_count);
+			if (regular_count == length) {
+				break;
+			}
+			p += regular_count;
+			length -= regular_count;
+			const cc7::byte uc = *p++;
+			length--;
+			char escaped[6] = { '\\', 0, 0, 0, 0, 0 };
+			size_t escaped_length = 2;
+			switch (uc) {
+				case '"':	escaped[1] = '"'; break;
+				case '\\':	escaped[1] = '\\'; break;
+				case '\n':	escaped[1] = 'n'; break;
+				case '\r':	escaped[1] = 'r'; break;
+				case '\t':	escaped[1] = 't'; break;
+				case '\b':	escaped[1] = 'b'; break;
+				case '\f':	escaped[1] = 'f'; break;
+				default:
+					escaped[1] = 'u';
+					escaped[2] = '0';
+					escaped[3] = '0';
+					escaped[4] = s_hex[uc >> 4];
+					escaped[5] = s_hex[uc & 15];
+					escaped_length = 6;
+					break;
+			}
+			_buffer.append(escaped, escaped_length);
+		}
+		_buffer.push_back('"');
+	}
+	
+	
+	// MARK: - Global functions
+	
+	std::string JSON_Serialize(const JSONValue & value, JSONWriter::Mode mode)
+	{
+		JSONWriter writer(mode);
+		writer.value(value);
+		return writer.output();
+	}
+
+} // cc7::tests
+} // cc7
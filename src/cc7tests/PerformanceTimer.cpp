@@ -18,34 +18,230 @@
 #include <cc7tests/detail/StringUtils.h>
 #include <math.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+	#if defined(__GNUC__)
+		#include <x86intrin.h>
+		#include <cpuid.h>
+		#define CC7_TIMER_TSC
+	#endif
+#elif defined(_M_X64) || defined(_M_IX86)
+	#include <intrin.h>
+	#define CC7_TIMER_TSC
+#elif defined(__aarch64__) && defined(__GNUC__)
+	#define CC7_TIMER_CNTVCT
+#endif
+
 namespace cc7
 {
 namespace tests
 {
+	// MARK: - Timer backend
+	
+	static inline cc7::U64 _ReadCycleCounter()
+	{
+#if defined(CC7_TIMER_TSC)
+		// RDTSCP waits until all previous instructions are executed. The following
+		// LFENCE prevents the execution of next instructions before the counter is read.
+		unsigned int aux;
+		cc7::U64 result = __rdtscp(&aux);
+		_mm_lfence();
+		return result;
+#elif defined(CC7_TIMER_CNTVCT)
+		cc7::U64 result;
+		__asm__ __volatile__("isb; mrs %0, cntvct_el0" : "=r"(result) : : "memory");
+		return result;
+#else
+		return 0;
+#endif
+	}
+	
+	static bool _HasCycleCounter()
+	{
+#if defined(CC7_TIMER_TSC)
+		// Check for RDTSCP and invariant TSC support.
+		unsigned int regs[4] = { 0, 0, 0, 0 };
+	#if defined(_MSC_VER)
+		__cpuid((int*)regs, 0x80000000);
+	#else
+		__get_cpuid(0x80000000, &regs[0], &regs[1], &regs[2], &regs[3]);
+	#endif
+		if (regs[0] < 0x80000007) {
+			return false;
+		}
+	#if defined(_MSC_VER)
+		__cpuid((int*)regs, 0x80000001);
+	#else
+		__get_cpuid(0x80000001, &regs[0], &regs[1], &regs[2], &regs[3]);
+	#endif
+		const bool has_rdtscp = (regs[3] & (1 << 27)) != 0;
+	#if defined(_MSC_VER)
+		__cpuid((int*)regs, 0x80000007);
+	#else
+		__get_cpuid(0x80000007, &regs[0], &regs[1], &regs[2], &regs[3]);
+	#endif
+		const bool has_invariant_tsc = (regs[3] & (1 << 8)) != 0;
+		return has_rdtscp && has_invariant_tsc;
+#elif defined(CC7_TIMER_CNTVCT)
+		return true;
+#else
+		return false;
+#endif
+	}
+	
+	/*
+	 The TimerBackend keeps calibration data for all PerformanceTimer instances.
+	 */
+	struct TimerBackend
+	{
+		bool		cycle_counter;
+		double		ns_per_tick;
+		cc7::U64	overhead_ticks;
+		
+		TimerBackend()
+		{
+			cycle_counter = _HasCycleCounter();
+			if (cycle_counter) {
+				// Calibrate the counter's frequency against the OS clock, for
+				// approximately 10 ms.
+				cc7::U64 os_start = Platform_GetCurrentTime();
+				cc7::U64 cc_start = _ReadCycleCounter();
+				double elapsed_ms;
+				cc7::U64 cc_end;
+				do {
+					cc_end = _ReadCycleCounter();
+					elapsed_ms = Platform_GetTimeDiff(os_start, Platform_GetCurrentTime());
+				} while (elapsed_ms < 10.0);
+				if (cc_end > cc_start) {
+					ns_per_tick = elapsed_ms * 1e6 / (double)(cc_end - cc_start);
+				} else {
+					// Counter doesn't work
+					cycle_counter = false;
+				}
+			}
+			if (!cycle_counter) {
+				// Resolution of OS clock's ticks.
+				const cc7::U64 ticks = 1 << 30;
+				ns_per_tick = Platform_GetTimeDiff(0, ticks) * 1e6 / (double)ticks;
+			}
+			// The overhead is the minimum of many back to back readings.
+			overhead_ticks = ~0ULL;
+			for (int i = 0; i < 1000; i++) {
+				cc7::U64 start = readTicks();
+				cc7::U64 diff  = readTicks() - start;
+				if (diff < overhead_ticks) {
+					overhead_ticks = diff;
+				}
+			}
+		}
+		
+		inline cc7::U64 readTicks() const
+		{
+			return cycle_counter ? _ReadCycleCounter() : Platform_GetCurrentTime();
+		}
+		
+		static const TimerBackend & instance()
+		{
+			static const TimerBackend s_backend;
+			return s_backend;
+		}
+	};
+	
+	
+	// MARK: - PerformanceTimer
 	
-	PerformanceTimer::PerformanceTimer() :
-		_base(Platform_GetCurrentTime())
+	PerformanceTimer::PerformanceTimer()
 	{
+		_base = TimerBackend::instance().readTicks();
 	}
 	
 	
 	void PerformanceTimer::start()
 	{
-		_base = Platform_GetCurrentTime();
+		_base = TimerBackend::instance().readTicks();
 	}
 	
 	
 	double PerformanceTimer::elapsedTime()
 	{
-		return Platform_GetTimeDiff(_base, Platform_GetCurrentTime());
+		return elapsedTicks() * TimerBackend::instance().ns_per_tick * 1e-6;
+	}
+	
+	
+	cc7::U64 PerformanceTimer::elapsedTicks()
+	{
+		return TimerBackend::instance().readTicks() - _base;
+	}
+	
+	
+	double PerformanceTimer::elapsedNanoseconds()
+	{
+		const TimerBackend & backend = TimerBackend::instance();
+		cc7::U64 ticks = backend.readTicks() - _base;
+		ticks = ticks > backend.overhead_ticks ? ticks - backend.overhead_ticks : 0;
+		return ticks * backend.ns_per_tick;
 	}
 	
 	
-	double PerformanceTimer::measureBlock(std::function<void()> block)
+	bool PerformanceTimer::hasCycleCounter()
 	{
+		return TimerBackend::instance().cycle_counter;
+	}
+	
+	
+	const char * PerformanceTimer::backendName()
+	{
+		if (!TimerBackend::instance().cycle_counter) {
+			return "os";
+		}
+#if defined(CC7_TIMER_TSC)
+		return "tsc";
+#else
+		return "cntvct";
+#endif
+	}
+	
+	
+	double PerformanceTimer::ticksToNanoseconds(cc7::U64 ticks)
+	{
+		return ticks * TimerBackend::instance().ns_per_tick;
+	}
+	
+	
+	cc7::U64 PerformanceTimer::overheadTicks()
+	{
+		return TimerBackend::instance().overhead_ticks;
+	}
+	
+	
+	double PerformanceTimer::measureBlock(std::function<void()> block, PerformanceCounters * out_counters)
+	{
+		if (!out_counters) {
+			start();
+			block();
+			return elapsedTime();
+		}
+		*out_counters = PerformanceCounters();
+		void * counters = Platform_StartPerformanceCounters();
 		start();
 		block();
-		return elapsedTime();
+		double elapsed = elapsedTime();
+		if (counters) {
+			Platform_StopPerformanceCounters(counters, *out_counters);
+		}
+		return elapsed;
+	}
+	
+	
+	const char * PerformanceCounters::counterName(Counter counter)
+	{
+		switch (counter) {
+			case Cycles:		return "cycles";
+			case Instructions:	return "instructions";
+			case BranchMisses:	return "branch_misses";
+			case L1DMisses:		return "l1d_misses";
+			case LLCMisses:		return "llc_misses";
+			default:			return "unknown";
+		}
 	}
 	
 	
@@ -0,0 +1,387 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cc7tests/SamplingProfiler.h>
+#include <cc7tests/detail/StringUtils.h>
+#include <algorithm>
+#include <map>
+#include <thread>
+
+#if defined(CC7_ANDROID)
+	#include <signal.h>
+	#include <errno.h>
+	#include <dlfcn.h>
+	#include <pthread.h>
+	#include <ucontext.h>
+	#include <sys/time.h>
+	#include <cxxabi.h>
+	#define CC7_HAS_SAMPLING_PROFILER
+#endif
+
+namespace cc7
+{
+namespace tests
+{
+#if defined(CC7_HAS_SAMPLING_PROFILER)
+	
+	namespace detail
+	{
+		/*
+		 The SamplingProfilerBackend contains the signal handling part of the profiler.
+		 All methods called from the signal handler must be async-signal-safe, so they
+		 don't allocate memory, nor take locks.
+		 */
+		class SamplingProfilerBackend
+		{
+		public:
+			
+			static std::atomic<SamplingProfiler*> s_active_profiler;
+			static std::atomic<int> s_handlers_in_flight;
+			static struct sigaction s_old_action;
+			
+			// Bounds of the stack of the thread, which started the profiler.
+			static std::atomic<uintptr_t> s_stack_low;
+			static std::atomic<uintptr_t> s_stack_high;
+			
+			static bool interruptedRegisters(void * signal_context, uintptr_t & pc, uintptr_t & fp)
+			{
+				const ucontext_t * uc = reinterpret_cast<const ucontext_t*>(signal_context);
+				if (!uc) {
+					return false;
+				}
+#if defined(__x86_64__)
+				pc = (uintptr_t)uc->uc_mcontext.gregs[REG_RIP];
+				fp = (uintptr_t)uc->uc_mcontext.gregs[REG_RBP];
+#elif defined(__i386__)
+				pc = (uintptr_t)uc->uc_mcontext.gregs[REG_EIP];
+				fp = (uintptr_t)uc->uc_mcontext.gregs[REG_EBP];
+#elif defined(__aarch64__)
+				pc = (uintptr_t)uc->uc_mcontext.pc;
+				fp = (uintptr_t)uc->uc_mcontext.regs[29];
+#elif defined(__arm__)
+				// The layout of the frame record depends on the ARM or Thumb mode,
+				// so only the interrupted PC is captured.
+				pc = (uintptr_t)uc->uc_mcontext.arm_pc;
+				fp = 0;
+#else
+				return false;
+#endif
+				return pc != 0;
+			}
+			
+			/*
+			 Walks the chain of frame records {previous frame pointer, return address},
+			 starting at |fp|. The walk is limited to the [low, high) stack range, so it
+			 never reads an unmapped memory, even if some function in the chain doesn't
+			 maintain the frame pointer. Returns number of stored return addresses.
+			 */
+			static size_t walkFrames(uintptr_t fp, uintptr_t low, uintptr_t high, uintptr_t * frames, size_t max_count)
+			{
+				size_t count = 0;
+				while (count < max_count) {
+					if (fp < low || fp > high - 2 * sizeof(uintptr_t) || (fp & (sizeof(uintptr_t) - 1)) != 0) {
+						break;
+					}
+					const uintptr_t * record = reinterpret_cast<const uintptr_t*>(fp);
+					uintptr_t next_fp = record[0];
+					uintptr_t return_address = record[1];
+					if (return_address == 0) {
+						break;
+					}
+					frames[count++] = return_address;
+					if (next_fp <= fp) {
+						// The stack grows down, so the caller's frame must be above.
+						break;
+					}
+					fp = next_fp;
+				}
+				return count;
+			}
+			
+			static void signalHandler(int /*signal*/, siginfo_t * /*info*/, void * signal_context)
+			{
+				int saved_errno = errno;
+				s_handlers_in_flight.fetch_add(1);
+				SamplingProfiler * profiler = s_active_profiler.load();
+				if (profiler) {
+					profiler->captureSample(signal_context);
+				}
+				s_handlers_in_flight.fetch_sub(1);
+				errno = saved_errno;
+			}
+		};
+		
+		std::atomic<SamplingProfiler*> SamplingProfilerBackend::s_active_profiler(nullptr);
+		std::atomic<int> SamplingProfilerBackend::s_handlers_in_flight(0);
+		struct sigaction SamplingProfilerBackend::s_old_action;
+		std::atomic<uintptr_t> SamplingProfilerBackend::s_stack_low(0);
+		std::atomic<uintptr_t> SamplingProfilerBackend::s_stack_high(0);
+	}
+	
+	bool SamplingProfiler::isSupported()
+	{
+		return true;
+	}
+	
+	bool SamplingProfiler::start(unsigned int frequency)
+	{
+		if (_running || frequency == 0) {
+			return false;
+		}
+		SamplingProfiler * expected = nullptr;
+		if (!detail::SamplingProfilerBackend::s_active_profiler.compare_exchange_strong(expected, this)) {
+			// Other profiler is running
+			return false;
+		}
+		// Preallocate the buffer. The buffer is not reallocated until clear().
+		if (_frames.empty()) {
+			_frames.resize(_max_samples * _max_depth);
+			_depths.resize(_max_samples);
+			_labels.resize(_max_samples);
+		}
+		// Keep bounds of the current thread's stack. The stack is walked only when
+		// this thread is interrupted. The pthread functions are not safe in the signal
+		// handler, so the bounds must be evaluated here.
+		uintptr_t stack_low = 0, stack_high = 0;
+		pthread_attr_t attr;
+		if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+			void * stack_addr = nullptr;
+			size_t stack_size = 0;
+			if (pthread_attr_getstack(&attr, &stack_addr, &stack_size) == 0) {
+				stack_low = (uintptr_t)stack_addr;
+				stack_high = stack_low + stack_size;
+			}
+			pthread_attr_destroy(&attr);
+		}
+		detail::SamplingProfilerBackend::s_stack_low.store(stack_low);
+		detail::SamplingProfilerBackend::s_stack_high.store(stack_high);
+		
+		struct sigaction action;
+		memset(&action, 0, sizeof(action));
+		action.sa_sigaction = detail::SamplingProfilerBackend::signalHandler;
+		action.sa_flags = SA_SIGINFO | SA_RESTART;
+		sigemptyset(&action.sa_mask);
+		if (sigaction(SIGPROF, &action, &detail::SamplingProfilerBackend::s_old_action) != 0) {
+			detail::SamplingProfilerBackend::s_active_profiler.store(nullptr);
+			return false;
+		}
+		long interval = std::max(1000000L / (long)frequency, 1L);
+		struct itimerval timer;
+		timer.it_interval.tv_sec = interval / 1000000;
+		timer.it_interval.tv_usec = interval % 1000000;
+		timer.it_value = timer.it_interval;
+		if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+			sigaction(SIGPROF, &detail::SamplingProfilerBackend::s_old_action, nullptr);
+			detail::SamplingProfilerBackend::s_active_profiler.store(nullptr);
+			return false;
+		}
+		_running = true;
+		return true;
+	}
+	
+	void SamplingProfiler::stop()
+	{
+		if (!_running) {
+			return;
+		}
+		struct itimerval timer;
+		memset(&timer, 0, sizeof(timer));
+		setitimer(ITIMER_PROF, &timer, nullptr);
+		detail::SamplingProfilerBackend::s_active_profiler.store(nullptr);
+		// Wait for signal handlers, which may still use this profiler.
+		while (detail::SamplingProfilerBackend::s_handlers_in_flight.load() > 0) {
+			std::this_thread::yield();
+		}
+		// SIGPROF may still be pending on other thread. The default action terminates
+		// the process, so such signal is ignored instead.
+		struct sigaction old_action = detail::SamplingProfilerBackend::s_old_action;
+		if (!(old_action.sa_flags & SA_SIGINFO) && old_action.sa_handler == SIG_DFL) {
+			old_action.sa_handler = SIG_IGN;
+		}
+		sigaction(SIGPROF, &old_action, nullptr);
+		_running = false;
+	}
+	
+	void SamplingProfiler::captureSample(void * signal_context)
+	{
+		size_t index = _next_sample.fetch_add(1);
+		if (index >= _max_samples) {
+			_next_sample.fetch_sub(1);
+			_dropped_samples.fetch_add(1);
+			return;
+		}
+		uintptr_t * frames = &_frames[index * _max_depth];
+		size_t count = 0;
+		uintptr_t pc, fp;
+		if (detail::SamplingProfilerBackend::interruptedRegisters(signal_context, pc, fp)) {
+			frames[count++] = pc;
+			// The handler runs on the stack of the interrupted thread, so the address
+			// of the local variable identifies the thread. The interrupted frames are
+			// always above the handler's frame.
+			uintptr_t here = (uintptr_t)&pc;
+			uintptr_t stack_high = detail::SamplingProfilerBackend::s_stack_high.load();
+			if (here >= detail::SamplingProfilerBackend::s_stack_low.load() && here < stack_high) {
+				count += detail::SamplingProfilerBackend::walkFrames(fp, here, stack_high, frames + count, _max_depth - count);
+			}
+		}
+		_depths[index] = (cc7::U32)count;
+		_labels[index] = _label.load();
+	}
+	
+	static std::string _SymbolName(uintptr_t address)
+	{
+		Dl_info info;
+		if (dladdr((const void*)address, &info) != 0) {
+			if (info.dli_sname) {
+				int status = 0;
+				char * demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+				std::string name(status == 0 && demangled ? demangled : info.dli_sname);
+				free(demangled);
+				return name;
+			}
+			if (info.dli_fname) {
+				const char * module = strrchr(info.dli_fname, '/');
+				module = module ? module + 1 : info.dli_fname;
+				return detail::FormattedString("%s+0x%llx", module, (unsigned long long)(address - (uintptr_t)info.dli_fbase));
+			}
+		}
+		return detail::FormattedString("0x%llx", (unsigned long long)address);
+	}
+	
+#else
+	
+	bool SamplingProfiler::isSupported()
+	{
+		return false;
+	}
+	
+	bool SamplingProfiler::start(unsigned int /*frequency*/)
+	{
+		return false;
+	}
+	
+	void SamplingProfiler::stop()
+	{
+	}
+	
+	void SamplingProfiler::captureSample(void * /*signal_context*/)
+	{
+	}
+	
+	static std::string _SymbolName(uintptr_t address)
+	{
+		return detail::FormattedString("0x%llx", (unsigned long long)address);
+	}
+	
+#endif // CC7_HAS_SAMPLING_PROFILER
+	
+	
+	// MARK: - Common implementation
+	
+	SamplingProfiler::SamplingProfiler(size_t max_samples, size_t max_depth) :
+		_max_samples(std::max(max_samples, (size_t)1)),
+		_max_depth(std::max(max_depth, (size_t)1)),
+		_running(false),
+		_next_sample(0),
+		_dropped_samples(0),
+		_label(nullptr)
+	{
+	}
+	
+	SamplingProfiler::~SamplingProfiler()
+	{
+		stop();
+	}
+	
+	bool SamplingProfiler::isRunning() const
+	{
+		return _running;
+	}
+	
+	void SamplingProfiler::setLabel(const char * label)
+	{
+		_label.store(label);
+	}
+	
+	void SamplingProfiler::clear()
+	{
+		if (_running) {
+			// The buffer cannot be released during the profiling.
+			_next_sample.store(0);
+			_dropped_samples.store(0);
+			return;
+		}
+		_next_sample.store(0);
+		_dropped_samples.store(0);
+		_frames.clear();
+		_frames.shrink_to_fit();
+		_depths.clear();
+		_depths.shrink_to_fit();
+		_labels.clear();
+		_labels.shrink_to_fit();
+	}
+	
+	size_t SamplingProfiler::samplesCount() const
+	{
+		return std::min(_next_sample.load(), _max_samples);
+	}
+	
+	size_t SamplingProfiler::droppedSamplesCount() const
+	{
+		return _dropped_samples.load();
+	}
+	
+	std::string SamplingProfiler::foldedStacks() const
+	{
+		std::map<uintptr_t, std::string> symbols;
+		std::map<std::string, size_t> stacks;
+		const size_t count = std::min(samplesCount(), _depths.size());
+		for (size_t i = 0; i < count; i++) {
+			std::string stack;
+			if (_labels[i]) {
+				stack.assign(_labels[i]);
+			}
+			const uintptr_t * frames = &_frames[i * _max_depth];
+			for (size_t depth = _depths[i]; depth > 0; depth--) {
+				// All frames, except the leaf one, contain a return address, which may
+				// point to the next function. Use the address of the call instruction.
+				uintptr_t address = depth > 1 ? frames[depth - 1] - 1 : frames[0];
+				auto it = symbols.find(address);
+				if (it == symbols.end()) {
+					std::string name = _SymbolName(address);
+					std::replace(name.begin(), name.end(), ';', ':');
+					it = symbols.insert(std::make_pair(address, name)).first;
+				}
+				if (!stack.empty()) {
+					stack.push_back(';');
+				}
+				stack.append(it->second);
+			}
+			if (!stack.empty()) {
+				stacks[stack]++;
+			}
+		}
+		std::string result;
+		for (auto && item : stacks) {
+			result.append(item.first);
+			result.append(detail::FormattedString(" %llu\n", (unsigned long long)item.second));
+		}
+		return result;
+	}
+	
+} // cc7::tests
+} // cc7
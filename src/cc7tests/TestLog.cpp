@@ -16,8 +16,10 @@
 
 #include <cc7tests/TestLog.h>
 #include <cc7tests/detail/StringUtils.h>
+#include <algorithm>
 #include <memory>
 #include <string>
+#include <thread>
 
 namespace cc7
 {
@@ -29,51 +31,278 @@ namespace tests
 	
 	static const std::string newline("\n");
 	
+	// If the sink is set, then thread buffers are streamed to the sink, when
+	// one buffer exceeds this size.
+	static const size_t kSinkStreamThreshold = 16 * 1024;
+	
 	static const char * _LookForFileName(const char * path);
 	static void			_AppendMultilineString(const std::string & str, const std::string & indentation, std::string & dest_string);
 	
+	/*
+	 The ThreadBuffer contains messages appended by one thread. Each message has
+	 a sequence number, so the buffers can be merged in the original order. The buffer
+	 has its own lock, which is contended only when the buffers are merged.
+	 */
+	struct TestLog::ThreadBuffer
+	{
+		struct Mark
+		{
+			cc7::U64	sequence;
+			size_t		log_end;
+			size_t		incidents_end;
+		};
+		
+		std::thread::id		owner;
+		std::mutex			lock;
+		std::string			log;
+		std::string			incidents;
+		std::vector<Mark>	marks;
+		// Set to true when the owner thread exits.
+		std::shared_ptr<std::atomic<bool>> released;
+		
+		void clear()
+		{
+			log.clear();
+			incidents.clear();
+			marks.clear();
+		}
+		
+		// Removes first |count| messages from the buffer.
+		void removeFirst(size_t count)
+		{
+			if (count == marks.size()) {
+				clear();
+				return;
+			}
+			const Mark last = marks[count - 1];
+			log.erase(0, last.log_end);
+			incidents.erase(0, last.incidents_end);
+			marks.erase(marks.begin(), marks.begin() + count);
+			for (Mark & mark : marks) {
+				mark.log_end -= last.log_end;
+				mark.incidents_end -= last.incidents_end;
+			}
+		}
+	};
+	
+	// Global sequence of messages, shared between all logs.
+	static std::atomic<cc7::U64> s_message_sequence(0);
+	// Global sequence of log identifiers.
+	static std::atomic<cc7::U64> s_log_id_sequence(0);
+	
+	// Small per-thread cache, mapping log identifier to its thread buffer.
+	struct ThreadBufferCacheEntry
+	{
+		cc7::U64	log_id;
+		void *		buffer;
+	};
+	static const size_t kThreadBufferCacheSize = 4;
+	static thread_local ThreadBufferCacheEntry s_buffer_cache[kThreadBufferCacheSize];
+	static thread_local size_t s_buffer_cache_next;
+	
+	// Flags of all buffers created by the thread. When the thread exits, all flags
+	// are set, so the logs can release the buffers during the next merge.
+	struct ThreadBufferReleaser
+	{
+		std::vector<std::shared_ptr<std::atomic<bool>>> flags;
+		
+		~ThreadBufferReleaser()
+		{
+			for (auto && flag : flags) {
+				flag->store(true);
+			}
+		}
+		
+		void add(const std::shared_ptr<std::atomic<bool>> & flag)
+		{
+			// Forget flags of buffers, which were already destroyed by their logs.
+			flags.erase(std::remove_if(flags.begin(), flags.end(), [](const std::shared_ptr<std::atomic<bool>> & f) {
+				return f.use_count() == 1;
+			}), flags.end());
+			flags.push_back(flag);
+		}
+	};
+	static thread_local ThreadBufferReleaser s_buffer_releaser;
+	
+	template <typename T>
+	static void _AtomicAdd(std::atomic<T> & value, T increment)
+	{
+		T current = value.load();
+		while (!value.compare_exchange_weak(current, current + increment)) {
+		}
+	}
 	
 	
 	// MARK: Construction / Destruction
 	
 	TestLog::TestLog() :
+		_log_id(++s_log_id_sequence),
 		_lock(new std::mutex()),
+		_indentation(nullptr),
+		_indentation_level(0),
+		_has_sink(false),
+		_incidents_count(0),
+		_current_test_incidents_count(0),
+		_executed_tests(0),
+		_passed_tests(0),
+		_failed_tests(0),
+		_skipped_tests(0),
+		_elapsed_time(0.0),
+		_cpu_time(0.0),
 		_dump_to_system_log(false),
 		_incident_breakpoint(false)
 	{
 		_log_data.log.reserve(2048);
 		_log_data.incidents.reserve(1024);
-		_indentation.reserve(64);
+		updateIndentationToLevel(0);
 	}
 	
 	
 	TestLog::~TestLog()
 	{
+		if (_sink) {
+			flush();
+		}
+		for (ThreadBuffer * buffer : _buffers) {
+			delete buffer;
+		}
 		delete _lock;
 	}
 	
 	
 	
+	// MARK: Thread buffers
+	
+	TestLog::ThreadBuffer * TestLog::threadBuffer()
+	{
+		for (size_t i = 0; i < kThreadBufferCacheSize; i++) {
+			if (s_buffer_cache[i].log_id == _log_id) {
+				return reinterpret_cast<ThreadBuffer*>(s_buffer_cache[i].buffer);
+			}
+		}
+		// Not in cache, look for buffer in the list. The identifier of the exited
+		// thread may be reused, so the released buffers are ignored.
+		GUARD_LOCK();
+		std::thread::id this_thread = std::this_thread::get_id();
+		ThreadBuffer * buffer = nullptr;
+		for (ThreadBuffer * b : _buffers) {
+			if (b->owner == this_thread && !b->released->load()) {
+				buffer = b;
+				break;
+			}
+		}
+		if (!buffer) {
+			// Create a new buffer and push it to the list
+			buffer = new ThreadBuffer();
+			buffer->owner = this_thread;
+			buffer->released = std::make_shared<std::atomic<bool>>(false);
+			s_buffer_releaser.add(buffer->released);
+			_buffers.push_back(buffer);
+		}
+		ThreadBufferCacheEntry & entry = s_buffer_cache[s_buffer_cache_next];
+		s_buffer_cache_next = (s_buffer_cache_next + 1) % kThreadBufferCacheSize;
+		entry.log_id = _log_id;
+		entry.buffer = buffer;
+		return buffer;
+	}
+	
+	
+	void TestLog::mergeThreadBuffers() const
+	{
+		// Only messages numbered before the merge are processed. Each message has
+		// sequence number acquired under the buffer's lock, so once the buffer is
+		// locked, it contains all such messages from its thread. Newer messages stay
+		// in the buffers, so they cannot be merged before an older message.
+		const cc7::U64 last_sequence = s_message_sequence.load();
+		std::vector<MergeEntry> & entries = _merge_entries;
+		std::vector<std::pair<ThreadBuffer*, size_t>> & buffers = _merge_counts;
+		entries.clear();
+		buffers.clear();
+		for (ThreadBuffer * buffer : _buffers) {
+			buffer->lock.lock();
+			size_t count = 0;
+			while (count < buffer->marks.size() && buffer->marks[count].sequence <= last_sequence) {
+				MergeEntry entry = { buffer->marks[count].sequence, buffer, count };
+				entries.push_back(entry);
+				count++;
+			}
+			buffers.push_back(std::make_pair(buffer, count));
+		}
+		// Sort all collected messages by their sequence numbers.
+		std::sort(entries.begin(), entries.end(), [](const MergeEntry & a, const MergeEntry & b) {
+			return a.sequence < b.sequence;
+		});
+		TestLogSink * sink = _sink.get();
+		for (const MergeEntry & entry : entries) {
+			const ThreadBuffer * buffer = entry.buffer;
+			const size_t index = entry.index;
+			const size_t log_begin = index > 0 ? buffer->marks[index - 1].log_end : 0;
+			const size_t incidents_begin = index > 0 ? buffer->marks[index - 1].incidents_end : 0;
+			const ThreadBuffer::Mark & mark = buffer->marks[index];
+			if (sink) {
+				sink->write(buffer->log.data() + log_begin, mark.log_end - log_begin);
+			} else {
+				_log_data.log.append(buffer->log, log_begin, mark.log_end - log_begin);
+			}
+			_log_data.incidents.append(buffer->incidents, incidents_begin, mark.incidents_end - incidents_begin);
+		}
+		// Remove merged messages and release buffers of exited threads.
+		size_t kept = 0;
+		for (auto && item : buffers) {
+			ThreadBuffer * buffer = item.first;
+			if (item.second > 0) {
+				buffer->removeFirst(item.second);
+			}
+			bool release = buffer->marks.empty() && buffer->released->load();
+			buffer->lock.unlock();
+			if (release) {
+				delete buffer;
+			} else {
+				_buffers[kept++] = buffer;
+			}
+		}
+		_buffers.resize(kept);
+	}
+	
+	
+	
 	// MARK: Logging
 	
-	void TestLog::appendMultilineString(const std::string & string)
+	void TestLog::streamToSinkIfNeeded(ThreadBuffer * buffer)
+	{
+		if (_has_sink && buffer->log.length() > kSinkStreamThreshold) {
+			// Don't block the logging thread, if other thread is merging now.
+			std::unique_lock<std::mutex> lock(*_lock, std::try_to_lock);
+			if (lock.owns_lock()) {
+				mergeThreadBuffers();
+			}
+		}
+	}
+	
+	void TestLog::appendMultilineString(const std::string & string, bool incident)
 	{
-//		if (_dump_to_system_log) {
-//			CC7_LOG("%s", string.c_str());
-//		}
-		_AppendMultilineString(string, _indentation, _log_data.log);
+		const std::string & indentation = *_indentation.load();
+		ThreadBuffer * buffer = threadBuffer();
+		{
+			std::lock_guard<std::mutex> lock(buffer->lock);
+			_AppendMultilineString(string, indentation, buffer->log);
+			if (incident) {
+				_AppendMultilineString(string, std::string(), buffer->incidents);
+			}
+			ThreadBuffer::Mark mark = { ++s_message_sequence, buffer->log.length(), buffer->incidents.length() };
+			buffer->marks.push_back(mark);
+		}
+		streamToSinkIfNeeded(buffer);
 	}
 	
 	void TestLog::logMessage(const char * message)
 	{
-		GUARD_LOCK();
 		appendMultilineString(std::string(message));
 	}
 	
 	
 	void TestLog::logMessage(const std::string & message)
 	{
-		GUARD_LOCK();
 		appendMultilineString(message);
 	}
 	
@@ -96,8 +325,6 @@ namespace tests
 				message.assign(buffer.get());
 			}
 		}
-		// Lock now. All previous operations were local.
-		GUARD_LOCK();
 		appendMultilineString(message);
 	}
 	
@@ -139,38 +366,47 @@ namespace tests
 		}
 #undef BUF_COUNT
 		
-		std::string message(message_buffer);
-		bool dump_to_syslog;
-		bool break_execution;
-		
-		_lock->lock();
+		// Look for already reported location
+		bool new_incident;
 		{
-			// Look for already reported location
-			std::string file_location_key(full_path);
-			file_location_key.append(":");
-			file_location_key.append(std::to_string(line));
+			std::lock_guard<std::mutex> lock(_incident_locations_lock);
+			new_incident = _incident_locations_set.insert({ full_path, line }).second;
+		}
+		reportIncident(message_buffer, new_incident);
+	}
+		
 			
-			if (_incident_locations_set.find(file_location_key) == _incident_locations_set.end()) {
-				// New incident, store key to locations set
-				_incident_locations_set.insert(file_location_key);
-				// Append message to log
-				_AppendMultilineString(message, _indentation,  _log_data.log);
-				_AppendMultilineString(message, std::string(), _log_data.incidents);
-			}
+	void TestLog::logUnboundIncident(const char * format, ...)
+	{
+		char formatted_message[1024];
+		va_list args;
+		va_start(args, format);
+		vsnprintf(formatted_message, sizeof(formatted_message), format, args);
+		va_end(args);
 			
-			_log_data.c.incidents_count += 1;
-			_log_data.c.current_test_incidents_count += 1;
+		char message_buffer[1024+16];
+		snprintf(message_buffer, sizeof(message_buffer), "FAIL: %s", formatted_message);
+		reportIncident(message_buffer, true);
+	}
 			
-			dump_to_syslog = _dump_to_system_log && !_incident_breakpoint;
-			break_execution = _incident_breakpoint;
+	
+	void TestLog::reportIncident(const char * message, bool new_incident)
+	{
+		if (new_incident) {
+			// Append message to log & incidents
+			appendMultilineString(std::string(message), true);
 		}
-		_lock->unlock();
+		_incidents_count++;
+		_current_test_incidents_count++;
+		
+		bool break_execution = _incident_breakpoint;
+		bool dump_to_syslog = _dump_to_system_log && !break_execution;
 		
 		if (dump_to_syslog) {
-			CC7_LOG("%s", message_buffer);
+			CC7_LOG("%s", message);
 		}
 		if (break_execution) {
-			CC7_LOG("%s", message_buffer);
+			CC7_LOG("%s", message);
 			CC7_BREAKPOINT();
 		}
 	}
@@ -181,45 +417,93 @@ namespace tests
 	
 	void TestLog::setDumpToSystemLogEnabled(bool enable)
 	{
-		GUARD_LOCK();
 		_dump_to_system_log = enable;
 	}
 	
 	
 	bool TestLog::dumpToSystemLogEnabled() const
 	{
-		GUARD_LOCK();
 		return _dump_to_system_log;
 	}
 	
 	
 	void TestLog::setIncidentBreakpointEnabled(bool enable)
 	{
-		GUARD_LOCK();
 		_incident_breakpoint = enable;
 	}
 	
 	
 	bool TestLog::incidentBreakpointEnabled() const
 	{
-		GUARD_LOCK();
 		return _incident_breakpoint;
 	}
+	
+	
+	void TestLog::setSink(std::shared_ptr<TestLogSink> sink)
+	{
+		GUARD_LOCK();
+		// Pending messages belong to the previous destination.
+		mergeThreadBuffers();
+		if (_sink) {
+			_sink->flush();
+		}
+		_sink = sink;
+		_has_sink = _sink != nullptr;
+	}
+	
+	
+	std::shared_ptr<TestLogSink> TestLog::sink() const
+	{
+		GUARD_LOCK();
+		return _sink;
+	}
+	
+	
+	void TestLog::flush()
+	{
+		GUARD_LOCK();
+		mergeThreadBuffers();
+		if (_sink) {
+			_sink->flush();
+		}
+	}
 
 	
 	// MARK: Log results and control
 
-	TestLogData TestLog::logData() const
+	const TestLogData & TestLog::logData() const
 	{
 		GUARD_LOCK();
+		mergeThreadBuffers();
+		_log_data.c = logDataCounters();
 		return _log_data;
 	}
 	
 	
-	TestLogData::Counters TestLog::logDataCounters() const
+	TestLogData TestLog::takeLogData()
 	{
 		GUARD_LOCK();
-		return _log_data.c;
+		mergeThreadBuffers();
+		TestLogData data;
+		data.log.swap(_log_data.log);
+		data.incidents.swap(_log_data.incidents);
+		data.c = logDataCounters();
+		return data;
+	}
+	
+	
+	TestLogData::Counters TestLog::logDataCounters() const
+	{
+		TestLogData::Counters c;
+		c.incidents_count				= _incidents_count;
+		c.current_test_incidents_count	= _current_test_incidents_count;
+		c.executed_tests				= _executed_tests;
+		c.passed_tests					= _passed_tests;
+		c.failed_tests					= _failed_tests;
+		c.skipped_tests					= _skipped_tests;
+		c.elapsed_time					= _elapsed_time;
+		c.cpu_time						= _cpu_time;
+		return c;
 	}
 	
 	
@@ -227,18 +511,49 @@ namespace tests
 	{
 		GUARD_LOCK();
 		
+		for (ThreadBuffer * buffer : _buffers) {
+			std::lock_guard<std::mutex> buffer_lock(buffer->lock);
+			buffer->clear();
+		}
 		_log_data.reset();
-		_incident_locations_set.clear();
-		_indentation.clear();
+		{
+			std::lock_guard<std::mutex> lock(_incident_locations_lock);
+			_incident_locations_set.clear();
+		}
+		_incidents_count = 0;
+		_current_test_incidents_count = 0;
+		_executed_tests = 0;
+		_passed_tests = 0;
+		_failed_tests = 0;
+		_skipped_tests = 0;
+		_elapsed_time = 0.0;
+		_cpu_time = 0.0;
+		
 		_indentation_prefix.clear();
 		_indentation_suffix.clear();
+		updateIndentationToLevel(0);
 	}
 	
 	
 	void TestLog::clearCurrentTestIncidentsCount()
 	{
-		GUARD_LOCK();
-		_log_data.c.current_test_incidents_count = 0;
+		_current_test_incidents_count = 0;
+	}
+	
+	
+	void TestLog::appendLogData(const TestLogData & data)
+	{
+		ThreadBuffer * buffer = threadBuffer();
+		{
+			std::lock_guard<std::mutex> lock(buffer->lock);
+			buffer->log.append(data.log);
+			buffer->incidents.append(data.incidents);
+			ThreadBuffer::Mark mark = { ++s_message_sequence, buffer->log.length(), buffer->incidents.length() };
+			buffer->marks.push_back(mark);
+		}
+		streamToSinkIfNeeded(buffer);
+		_incidents_count += data.c.incidents_count;
+		_AtomicAdd(_cpu_time, data.c.cpu_time);
 	}
 	
 	
@@ -255,16 +570,15 @@ namespace tests
 	size_t TestLog::indentationLevel() const
 	{
 		GUARD_LOCK();
-		return indentationLevelImpl();
+		return _indentation_level;
 	}
 	
 
 	void TestLog::setIndentationPrefix(const std::string & prefix)
 	{
 		GUARD_LOCK();
-		size_t current_level = indentationLevelImpl();
 		_indentation_prefix = prefix;
-		updateIndentationToLevel(current_level);
+		updateIndentationToLevel(_indentation_level);
 	}
 	
 	
@@ -278,9 +592,8 @@ namespace tests
 	void TestLog::setIndentationSuffix(const std::string & suffix)
 	{
 		GUARD_LOCK();
-		size_t current_level = indentationLevelImpl();
 		_indentation_suffix = suffix;
-		updateIndentationToLevel(current_level);
+		updateIndentationToLevel(_indentation_level);
 	}
 	
 	
@@ -293,47 +606,53 @@ namespace tests
 	
 	void TestLog::updateIndentationToLevel(size_t level)
 	{
-		_indentation = _indentation_prefix;
-		_indentation.append(level, ' ');
-		_indentation.append(_indentation_suffix);
-		
+		_indentation_level = level;
+		std::string indentation(_indentation_prefix);
+		indentation.append(level, ' ');
+		indentation.append(_indentation_suffix);
+		// There's typically only a few different indentations, so reuse the previous one.
+		for (auto && prev_indentation : _indentations) {
+			if (*prev_indentation == indentation) {
+				_indentation.store(prev_indentation.get());
+				return;
+			}
+		}
+		_indentations.push_back(std::unique_ptr<std::string>(new std::string(indentation)));
+		_indentation.store(_indentations.back().get());
 	}
 	
-	size_t TestLog::indentationLevelImpl() const
-	{
-		return _indentation.length() - _indentation_prefix.length() - _indentation_suffix.length();
-	}
-
 	
 	// MARK: Passed / Failed counters
 	
 	void TestLog::addPassedTest()
 	{
-		GUARD_LOCK();
-		_log_data.c.passed_tests++;
-		_log_data.c.executed_tests++;
+		_passed_tests++;
+		_executed_tests++;
 	}
 	
 	
 	void TestLog::addFailedTest()
 	{
-		GUARD_LOCK();
-		_log_data.c.failed_tests++;
-		_log_data.c.executed_tests++;
+		_failed_tests++;
+		_executed_tests++;
 	}
 	
 	
 	void TestLog::addSkippedTest()
 	{
-		GUARD_LOCK();
-		_log_data.c.skipped_tests++;
+		_skipped_tests++;
 	}
 	
 	
 	void TestLog::setElapsedTime(double time)
 	{
-		GUARD_LOCK();
-		_log_data.c.elapsed_time = time;
+		_elapsed_time = time;
+	}
+	
+	
+	void TestLog::addCpuTime(double time)
+	{
+		_AtomicAdd(_cpu_time, time);
 	}
 
 	
@@ -0,0 +1,125 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cc7tests/TestLogSink.h>
+#include <string>
+#include <errno.h>
+
+#if defined(CC7_WINDOWS)
+	#include <io.h>
+#else
+	#include <unistd.h>
+#endif
+
+namespace cc7
+{
+namespace tests
+{
+	TestLogSink::~TestLogSink()
+	{
+	}
+	
+	void TestLogSink::flush()
+	{
+	}
+	
+	
+	// MARK: - Buffered sink
+	
+	/*
+	 The BufferedTestLogSink collects written data to the buffer and passes them
+	 to the callback when the buffer is full, or when the sink is flushed.
+	 */
+	class BufferedTestLogSink : public TestLogSink
+	{
+	public:
+		
+		BufferedTestLogSink(std::function<void(const char * data, size_t size)> callback, size_t buffer_size) :
+			_callback(callback),
+			_buffer_size(buffer_size)
+		{
+			_buffer.reserve(buffer_size);
+		}
+		
+		~BufferedTestLogSink()
+		{
+			flush();
+		}
+		
+		void write(const char * data, size_t size) override
+		{
+			if (_buffer.size() + size > _buffer_size) {
+				flush();
+				if (size >= _buffer_size) {
+					// Too big to be buffered
+					_callback(data, size);
+					return;
+				}
+			}
+			_buffer.append(data, size);
+		}
+		
+		void flush() override
+		{
+			if (!_buffer.empty()) {
+				_callback(_buffer.data(), _buffer.size());
+				_buffer.clear();
+			}
+		}
+		
+	private:
+		
+		std::function<void(const char * data, size_t size)> _callback;
+		size_t _buffer_size;
+		std::string _buffer;
+	};
+	
+	
+	static void _WriteToFileDescriptor(int fd, const char * data, size_t size)
+	{
+		while (size > 0) {
+#if defined(CC7_WINDOWS)
+			int written = _write(fd, data, (unsigned int)size);
+#else
+			ssize_t written = ::write(fd, data, size);
+#endif
+			if (written < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				CC7_LOG("TestLogSink: Failed to write to file descriptor %d. Error %d", fd, errno);
+				return;
+			}
+			data += written;
+			size -= (size_t)written;
+		}
+	}
+	
+	std::shared_ptr<TestLogSink> TestLogSink::createFileDescriptorSink(int fd, size_t buffer_size)
+	{
+		return std::make_shared<BufferedTestLogSink>([fd](const char * data, size_t size) {
+			_WriteToFileDescriptor(fd, data, size);
+		}, buffer_size);
+	}
+	
+	std::shared_ptr<TestLogSink> TestLogSink::createCallbackSink(std::function<void(const char * data, size_t size)> callback, size_t buffer_size)
+	{
+		return std::make_shared<BufferedTestLogSink>(callback, buffer_size);
+	}
+	
+} // cc7::tests
+} // cc7
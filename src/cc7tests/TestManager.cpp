@@ -20,6 +20,9 @@
 
 #include <cc7/DebugFeatures.h>
 #include <algorithm>
+#include <atomic>
+#include <memory>
+#include <thread>
 
 namespace cc7
 {
@@ -32,8 +35,14 @@ namespace tests
 		_test_manager_name("CC7"),
 		_assertion_breakpoint_enabled(false),
 		_log_capturig_enabled(false),
+		_tracing_enabled(false),
+		_profiling_enabled(false),
+		_parallel_execution_enabled(false),
+		_parallel_execution_active(false),
+		_parallel_workers_count(0),
 		_old_assertion_setup({nullptr, nullptr}),
-		_old_log_setup({nullptr, nullptr})
+		_old_log_setup({nullptr, nullptr}),
+		_old_trace_clock({nullptr, nullptr})
 	{
 		
 	}
@@ -44,6 +53,7 @@ namespace tests
 	}
 	
 	extern const UnitTestCreationInfoList _GetDefaultUnitTestCreationInfoList();
+	extern const UnitTestCreationInfoList _GetDefaultBenchmarkCreationInfoList();
 	
 	TestManager * TestManager::createDefaultManager()
 	{
@@ -53,6 +63,15 @@ namespace tests
 	}
 	
 	
+	TestManager * TestManager::createDefaultBenchmarkManager()
+	{
+		TestManager * tm = new TestManager();
+		tm->setTestManagerName("CC7 Benchmarks");
+		tm->addUnitTestList(_GetDefaultBenchmarkCreationInfoList());
+		return tm;
+	}
+	
+	
 	TestManager * TestManager::createEmptyManager()
 	{
 		return new TestManager();
@@ -99,6 +118,70 @@ namespace tests
 		return _log_capturig_enabled;
 	}
 	
+	void TestManager::setTracingEnabled(bool enabled)
+	{
+		_tracing_enabled = enabled;
+	}
+	
+	bool TestManager::tracingEnabled() const
+	{
+		return _tracing_enabled;
+	}
+	
+	void TestManager::setProfilingEnabled(bool enabled)
+	{
+		_profiling_enabled = enabled;
+	}
+	
+	bool TestManager::profilingEnabled() const
+	{
+		return _profiling_enabled;
+	}
+	
+	void TestManager::setProfilingSink(std::shared_ptr<TestLogSink> sink)
+	{
+		_profiling_sink = sink;
+	}
+	
+	std::shared_ptr<TestLogSink> TestManager::profilingSink() const
+	{
+		return _profiling_sink;
+	}
+	
+	SamplingProfiler & TestManager::profiler()
+	{
+		return _profiler;
+	}
+	
+	const SamplingProfiler & TestManager::profiler() const
+	{
+		return _profiler;
+	}
+	
+	void TestManager::setParallelExecutionEnabled(bool enabled)
+	{
+		_parallel_execution_enabled = enabled;
+	}
+	
+	bool TestManager::parallelExecutionEnabled() const
+	{
+		return _parallel_execution_enabled;
+	}
+	
+	void TestManager::setParallelWorkersCount(size_t count)
+	{
+		_parallel_workers_count = count;
+	}
+	
+	size_t TestManager::parallelWorkersCount() const
+	{
+		if (_parallel_workers_count > 0) {
+			return _parallel_workers_count;
+		}
+		size_t count = std::thread::hardware_concurrency();
+		return count > 0 ? count : 1;
+	}
+	
 	
 	
 	// ------------------------------------------------------------------------------------
@@ -147,14 +230,20 @@ namespace tests
 		// Keep current assertion handler and setup ours
 		setupAssertionHandler();
 		setupLogCapturingHandler();
+		setupTracing();
 		
 		// Prepare tags for filtering
 		auto included_tags = detail::SplitString(incl, ' ');
 		auto excluded_tags = detail::SplitString(excl, ' ');
 		
 		_test_log.clearLogData();
+		{
+			std::lock_guard<std::mutex> lock(_benchmark_results_lock);
+			_benchmark_results.clear();
+		}
 		
 		logHeader("== " + _test_manager_name + " Unit Tests Log");
+		setupProfiling();
 		
 		if (included_tags.size() > 0 || excluded_tags.size() > 0) {
 			if (included_tags.size()) {
@@ -181,16 +270,22 @@ namespace tests
 			//
 		}
 
+		finishProfiling();
+		
 		// Keep elapsed time & report results to log
 		tl().setElapsedTime(elapsed_time);
 		TestLogData::Counters log_data_counters = tl().logDataCounters();
-		logHeader(detail::FormattedString("== RESULTS:  %d passed,  %d failed,  %d skipped,  time %s",
+		logHeader(detail::FormattedString("== RESULTS:  %d passed,  %d failed,  %d skipped,  time %s,  cpu time %s",
 										  log_data_counters.passed_tests,
 										  log_data_counters.failed_tests,
 										  log_data_counters.skipped_tests,
-										  PerformanceTimer::humanReadableTime(elapsed_time).c_str()));
+										  PerformanceTimer::humanReadableTime(elapsed_time).c_str(),
+										  PerformanceTimer::humanReadableTime(log_data_counters.cpu_time).c_str()));
+		// Write all pending messages to the sink, if it's set.
+		tl().flush();
 		
 		// Set previous assertion handler back
+		finishTracing();
 		restoreLogCapturingHandler();
 		restoreAssertionHandler();
 		return tests_result;
@@ -202,58 +297,142 @@ namespace tests
 		return detail::FormattedString("Test [ %d / %d ] ::: %s", (int)index + 1, (int)count, ti->name);
 	}
 	
-	bool TestManager::executeFilteredTests(const std::vector<std::string> & included_tags, const std::vector<std::string> & excluded_tags)
+	static bool _ShouldRunTest(UnitTestCreationInfo ti, const std::vector<std::string> & included_tags, const std::vector<std::string> & excluded_tags)
 	{
-		bool final_result = true;
-		
 		bool include_all = included_tags.size() == 0;
 		bool no_excludes = excluded_tags.size() == 0;
 		
-		size_t test_index = 0;
-		for (auto ti : _registered_tests) {
-			// Build text for headers
-			std::string full_test_desc = BuildFullTestDescription(ti, test_index++, _registered_tests.size());
-			//
-			// apply test filter
-			//
-			bool should_run = false;
-			if (no_excludes && include_all) {
-				// no filter
-				should_run = true;
-			} else if (ti->tags) {
-				// has tags, split test tags by space
-				std::vector<std::string> test_tags = detail::SplitString(std::string(ti->tags), ' ');
-				if (test_tags.size() > 0) {
-					bool is_included = false;
-					if (!include_all) {
-						for (std::string incl : included_tags) {
-							if (std::find(test_tags.begin(), test_tags.end(), incl) != test_tags.end()) {
-								is_included = true;		// found tag from included vector
-								break;
-							}
-						}
-					} else {
-						is_included = true;
-					}
-					bool is_excluded = false;
-					for (std::string excl : excluded_tags) {
-						if (std::find(test_tags.begin(), test_tags.end(), excl) != test_tags.end()) {
-							is_excluded = true;		// found tag from excluded vector
+		bool should_run = false;
+		if (no_excludes && include_all) {
+			// no filter
+			should_run = true;
+		} else if (ti->tags) {
+			// has tags, split test tags by space
+			std::vector<std::string> test_tags = detail::SplitString(std::string(ti->tags), ' ');
+			if (test_tags.size() > 0) {
+				bool is_included = false;
+				if (!include_all) {
+					for (std::string incl : included_tags) {
+						if (std::find(test_tags.begin(), test_tags.end(), incl) != test_tags.end()) {
+							is_included = true;		// found tag from included vector
 							break;
 						}
 					}
-					should_run = is_included && !is_excluded;
-					
 				} else {
-					// test tags string has wrong format, assume that there's no tag at all
-					should_run = include_all;
+					is_included = true;
+				}
+				bool is_excluded = false;
+				for (std::string excl : excluded_tags) {
+					if (std::find(test_tags.begin(), test_tags.end(), excl) != test_tags.end()) {
+						is_excluded = true;		// found tag from excluded vector
+						break;
+					}
 				}
+				should_run = is_included && !is_excluded;
+				
 			} else {
-				// test has no tags, if included is not present, then ignore this test
+				// test tags string has wrong format, assume that there's no tag at all
 				should_run = include_all;
 			}
-			if (should_run) {
-				bool test_result = executeTest(ti, full_test_desc);
+		} else {
+			// test has no tags, if included is not present, then ignore this test
+			should_run = include_all;
+		}
+		return should_run;
+	}
+	
+	static bool _IsSerialTest(UnitTestCreationInfo ti)
+	{
+		if (!ti->tags) {
+			return false;
+		}
+		std::vector<std::string> test_tags = detail::SplitString(std::string(ti->tags), ' ');
+		return std::find(test_tags.begin(), test_tags.end(), "serial") != test_tags.end();
+	}
+	
+	
+	/*
+	 The TestRun structure keeps state of one test, executed in the parallel mode.
+	 */
+	struct TestManager::TestRun
+	{
+		UnitTestCreationInfo		ti;
+		std::string					full_test_desc;
+		bool						should_run;
+		bool						serial;
+		bool						result;
+		std::unique_ptr<TestLog>	log;
+	};
+	
+	/*
+	 The thread local binding between the manager and the log, where the current thread
+	 should put its messages. The manager is part of the binding, because the tests may
+	 create and run another TestManager instances.
+	 */
+	struct CurrentLogBinding
+	{
+		const TestManager *	manager;
+		TestLog *			log;
+	};
+	
+	static thread_local CurrentLogBinding t_current_log = { nullptr, nullptr };
+	
+	class ScopedCurrentLog
+	{
+	public:
+		ScopedCurrentLog(const TestManager * manager, TestLog * log) :
+			_previous(t_current_log)
+		{
+			t_current_log = { manager, log };
+		}
+		~ScopedCurrentLog()
+		{
+			t_current_log = _previous;
+		}
+	private:
+		CurrentLogBinding _previous;
+	};
+	
+	TestLog & TestManager::currentLog()
+	{
+		if (t_current_log.manager == this && t_current_log.log) {
+			return *t_current_log.log;
+		}
+		return _test_log;
+	}
+	
+	
+	bool TestManager::executeFilteredTests(const std::vector<std::string> & included_tags, const std::vector<std::string> & excluded_tags)
+	{
+		bool final_result = true;
+		
+		std::vector<TestRun> runs(_registered_tests.size());
+		size_t test_index = 0;
+		for (auto ti : _registered_tests) {
+			TestRun & run = runs[test_index];
+			run.ti = ti;
+			// Build text for headers
+			run.full_test_desc = BuildFullTestDescription(ti, test_index++, _registered_tests.size());
+			// apply test filter
+			run.should_run = _ShouldRunTest(ti, included_tags, excluded_tags);
+			run.serial = _IsSerialTest(ti);
+			run.result = false;
+		}
+					
+		if (_parallel_execution_enabled) {
+			executeParallelTests(runs);
+		}
+		
+		for (auto && run : runs) {
+			if (run.should_run) {
+				bool test_result;
+				if (run.log) {
+					// Already executed in parallel mode, just merge the log
+					tl().appendLogData(run.log->takeLogData());
+					test_result = run.result;
+				} else {
+					test_result = executeTest(run.ti, run.full_test_desc);
+				}
 				if (test_result) {
 					tl().addPassedTest();
 				} else {
@@ -261,7 +440,7 @@ namespace tests
 				}
 				final_result = final_result && test_result;
 			} else {
-				std::string skipped = full_test_desc + " ::: SKIPPED";
+				std::string skipped = run.full_test_desc + " ::: SKIPPED";
 				logMessage(skipped);
 				tl().addSkippedTest();
 			}
@@ -270,8 +449,75 @@ namespace tests
 		return final_result;
 	}
 	
+	
+	void TestManager::executeParallelTests(std::vector<TestRun> & runs)
+	{
+		// Prepare per-test logs
+		std::vector<size_t> parallel_runs;
+		std::vector<size_t> serial_runs;
+		for (size_t index = 0; index < runs.size(); index++) {
+			TestRun & run = runs[index];
+			if (!run.should_run) {
+				continue;
+			}
+			run.log.reset(new TestLog());
+			run.log->setIndentationPrefix(tl().indentationPrefix());
+			run.log->setIndentationSuffix(tl().indentationSuffix());
+			run.log->setDumpToSystemLogEnabled(tl().dumpToSystemLogEnabled());
+			run.log->setIncidentBreakpointEnabled(tl().incidentBreakpointEnabled());
+			if (run.serial) {
+				serial_runs.push_back(index);
+			} else {
+				parallel_runs.push_back(index);
+			}
+		}
+		
+		logMessage(detail::FormattedString(" * parallel workers : %d", (int)parallelWorkersCount()));
+		logSeparator();
+		
+#ifdef ENABLE_CC7_ASSERT
+		cc7::debug::ResetAssertionCounters();
+#endif
+		_parallel_execution_active = true;
+		
+		std::atomic<size_t> next_run(0);
+		auto worker = [&]() {
+			size_t i;
+			while ((i = next_run.fetch_add(1)) < parallel_runs.size()) {
+				TestRun & run = runs[parallel_runs[i]];
+				ScopedCurrentLog scope(this, run.log.get());
+				run.result = executeTest(run.ti, run.full_test_desc);
+			}
+		};
+		size_t workers_count = std::min(parallelWorkersCount(), parallel_runs.size());
+		std::vector<std::thread> workers;
+		for (size_t i = 1; i < workers_count; i++) {
+			workers.emplace_back(worker);
+		}
+		// The calling thread is also one of the workers
+		worker();
+		for (auto && thread : workers) {
+			thread.join();
+		}
+		
+		_parallel_execution_active = false;
+		
+		// Serial tests, on the calling thread
+		for (size_t index : serial_runs) {
+			TestRun & run = runs[index];
+			ScopedCurrentLog scope(this, run.log.get());
+			run.result = executeTest(run.ti, run.full_test_desc);
+		}
+		
+#ifdef ENABLE_CC7_ASSERT
+		cc7::debug::ReportSuppressedAssertions();
+#endif
+	}
+	
 	bool TestManager::executeTest(UnitTestCreationInfo ti, const std::string & full_test_desc)
 	{
+		CC7_TRACE_SCOPE(ti->name);
+		
 		bool test_result = false;
 		
 		detail::UnitTestFactoryFunction test_factory = ti->factory;
@@ -282,12 +528,24 @@ namespace tests
 			logMessage(begin_message);
 			
 			// Set indentation and run test
-			tl().setIndentationLevel(2);
+			TestLog & log = currentLog();
+			log.setIndentationLevel(2);
 			PerformanceTimer timer;
 			double elapsed_time = 0.0;
+			double cpu_time_start = Platform_GetThreadCPUTime();
 			
+#ifdef ENABLE_CC7_ASSERT
+			if (!_parallel_execution_active) {
+				// Each test should see the first failures of all assertion sites
+				cc7::debug::ResetAssertionCounters();
+			}
+#endif
+			unit_test->_test_name = ti->name;
+			if (_profiling_enabled && !_parallel_execution_active) {
+				_profiler.setLabel(ti->name);
+			}
 			try {
-				test_result = unit_test->runTest(this, &_test_log);
+				test_result = unit_test->runTest(this, &log);
 				elapsed_time = timer.elapsedTime();
 			} catch (std::exception & exc) {
 				std::string message("FAILED: Exception: ");
@@ -299,8 +557,18 @@ namespace tests
 				test_result = false;
 			}
 			
+#ifdef ENABLE_CC7_ASSERT
+			if (!_parallel_execution_active) {
+				cc7::debug::ReportSuppressedAssertions();
+			}
+#endif
+			if (_profiling_enabled && !_parallel_execution_active) {
+				_profiler.setLabel(nullptr);
+			}
+			log.addCpuTime(Platform_GetThreadCPUTime() - cpu_time_start);
+			
 			// Clear indentation & dump result
-			tl().setIndentationLevel(0);
+			log.setIndentationLevel(0);
 			
 			std::string end_message = full_test_desc;
 			if (test_result) {
@@ -339,25 +607,62 @@ namespace tests
 	
 	void TestManager::logHeader(const std::string & message)
 	{
-		size_t indent = tl().indentationLevel();
+		TestLog & log = currentLog();
+		size_t indent = log.indentationLevel();
 		indent = std::min(indent, s_header_line.length() - min_line);
 		const char * line_begin = s_header_line.c_str() + indent;
-		tl().logFormattedMessage("%s\n%s\n%s", line_begin, message.c_str(), line_begin);
+		log.logFormattedMessage("%s\n%s\n%s", line_begin, message.c_str(), line_begin);
 	}
 	
 	
 	void TestManager::logMessage(const std::string & message)
 	{
-		tl().logMessage(message);
+		currentLog().logMessage(message);
 	}
 	
 	
 	void TestManager::logSeparator()
 	{
-		size_t indent = tl().indentationLevel();
+		TestLog & log = currentLog();
+		size_t indent = log.indentationLevel();
 		indent = std::min(indent, s_normal_line.length() - min_line);
 		const char * line_begin = s_normal_line.c_str() + indent;
-		tl().logMessage(line_begin);
+		log.logMessage(line_begin);
+	}
+	
+	// ------------------------------------------------------------------------------------
+	// MARK: Benchmarks
+	
+	void TestManager::addBenchmarkResult(const BenchmarkResult & result)
+	{
+		std::lock_guard<std::mutex> lock(_benchmark_results_lock);
+		_benchmark_results.push_back(result);
+	}
+	
+	std::vector<BenchmarkResult> TestManager::benchmarkResults() const
+	{
+		std::lock_guard<std::mutex> lock(_benchmark_results_lock);
+		return _benchmark_results;
+	}
+	
+	std::string TestManager::benchmarkResultsJSON() const
+	{
+		return BenchmarkResultsToJSON(benchmarkResults(), BenchmarkContext::currentContext());
+	}
+	
+	bool TestManager::loadBenchmarkBaseline(const cc7::ByteRange & json_data, std::string * out_error)
+	{
+		return _benchmark_baseline.load(json_data, out_error);
+	}
+	
+	BenchmarkBaseline & TestManager::benchmarkBaseline()
+	{
+		return _benchmark_baseline;
+	}
+	
+	const BenchmarkBaseline & TestManager::benchmarkBaseline() const
+	{
+		return _benchmark_baseline;
 	}
 	
 	// Log capturing
@@ -371,7 +676,7 @@ namespace tests
 			msg.reserve(len + 7);
 			msg.assign("> CC7: ");
 			msg.append(message, len);
-			manager->tl().logMessage(msg);
+			manager->currentLog().logMessage(msg);
 		}
 	}
 	
@@ -407,6 +712,67 @@ namespace tests
 	}
 
 	
+	// Tracing
+	
+	void TestManager::setupTracing()
+	{
+#ifdef ENABLE_CC7_TRACE
+		if (_tracing_enabled) {
+			_old_trace_clock = cc7::debug::GetTraceClock();
+			cc7::debug::SetTraceClock({Platform_GetCurrentTime, Platform_GetTimeDiff});
+			cc7::debug::StartTracing();
+		}
+#endif
+	}
+	
+	void TestManager::finishTracing()
+	{
+#ifdef ENABLE_CC7_TRACE
+		if (_tracing_enabled) {
+			cc7::debug::StopTracing();
+			cc7::debug::SetTraceClock(_old_trace_clock);
+			_old_trace_clock = {nullptr, nullptr};
+		}
+#endif
+	}
+	
+	
+	// Profiling
+	
+	void TestManager::setupProfiling()
+	{
+		if (_profiling_enabled) {
+			_profiler.clear();
+			if (!_profiler.start()) {
+				logMessage("WARNING: The sampling profiler is not available.");
+			}
+		}
+	}
+	
+	void TestManager::finishProfiling()
+	{
+		if (_profiler.isRunning()) {
+			_profiler.stop();
+			std::string message = detail::FormattedString(" * profiler: %d samples", (int)_profiler.samplesCount());
+			if (_profiler.droppedSamplesCount() > 0) {
+				message.append(detail::FormattedString(", %d dropped", (int)_profiler.droppedSamplesCount()));
+			}
+			logMessage(message);
+			std::string folded = _profiler.foldedStacks();
+			if (_profiling_sink) {
+				_profiling_sink->write(folded.data(), folded.size());
+				_profiling_sink->flush();
+			} else if (!folded.empty()) {
+				logMessage(" * folded stacks:");
+				for (auto && line : detail::SplitString(folded, '\n')) {
+					logMessage(line);
+				}
+			}
+			logSeparator();
+		}
+	}
+	
+	
 	// ------------------------------------------------------------------------------------
 	// MARK: Private assertion handler
 	
@@ -414,7 +780,7 @@ namespace tests
 	{
 		TestManager * manager = reinterpret_cast<TestManager*>(handler_data);
 		if (manager) {
-			manager->tl().logMessage(message);
+			manager->currentLog().logMessage(message);
 			manager->addAssertion(message);
 		}
 	}
@@ -15,6 +15,7 @@
  */
 
 #include <cc7tests/UnitTest.h>
+#include <cc7tests/AllocationCounter.h>
 #include <stdexcept>
 
 namespace cc7
@@ -23,7 +24,8 @@ namespace tests
 {
 	UnitTest::UnitTest() :
 		_log(nullptr),
-		_manager(nullptr)
+		_manager(nullptr),
+		_test_name("")
 	{
 	}
 	
@@ -69,6 +71,12 @@ namespace tests
 	}
 
 	
+	const char * UnitTest::testName() const
+	{
+		return _test_name;
+	}
+	
+	
 	void UnitTest::registerTestMethod(std::function<void()> method, const char * description)
 	{
 		if (CC7_CHECK(method != nullptr && description != nullptr, "method & description must be set")) {
@@ -91,6 +99,7 @@ namespace tests
 		}
 		
 		size_t indent_before = tl().indentationLevel();
+		const bool count_allocations = AllocationCountersAvailable();
 		
 		for (auto&& desc : _methods) {
 			std::function<void()>	method_ptr;
@@ -101,7 +110,17 @@ namespace tests
 			
 			tl().setIndentationLevel(indent_before + 2);
 			setUp();
+			if (count_allocations) {
+				ResetAllocationCounters();
+			}
 			method_ptr();
+			if (count_allocations) {
+				AllocationCounters counters = GetAllocationCounters();
+				tl().logFormattedMessage("Allocations: %llu (%llu bytes), deallocations: %llu",
+										 (unsigned long long)counters.allocations,
+										 (unsigned long long)counters.allocated_bytes,
+										 (unsigned long long)counters.deallocations);
+			}
 			tearDown();
 			tl().setIndentationLevel(indent_before);
 		}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cc7tests/detail/JSONScanner.h>
+
+#include <cc7tests/detail/JSONSimd.h>
+
+namespace cc7
+{
+namespace tests
+{
+namespace detail
+{
+	static inline bool _IsStringSpecialCharacter(cc7::byte uc)
+	{
+		return uc == '"' || uc == '\\' || uc < 32;
+	}
+	
+	size_t FindJSONStringSpecialCharacter(const cc7::byte * p, size_t length)
+	{
+		size_t i = 0;
+#if defined(CC7_JSON_SSE2)
+		const __m128i quote     = _mm_set1_epi8('"');
+		const __m128i backslash = _mm_set1_epi8('\\');
+		const __m128i control   = _mm_set1_epi8(31);
+		for (; i + 16 <= length; i += 16) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+			// Unsigned comparison chunk <= 31 is implemented as max(chunk, 31) == 31
+			__m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+										   _mm_cmpeq_epi8(_mm_max_epu8(chunk, control), control));
+			cc7::U32 mask = (cc7::U32)_mm_movemask_epi8(special);
+			if (mask) {
+				return i + JSONCountTrailingZeros(mask);
+			}
+		}
+#elif defined(CC7_JSON_NEON)
+		const uint8x16_t quote     = vdupq_n_u8('"');
+		const uint8x16_t backslash = vdupq_n_u8('\\');
+		const uint8x16_t control   = vdupq_n_u8(32);
+		for (; i + 16 <= length; i += 16) {
+			uint8x16_t chunk = vld1q_u8(p + i);
+			uint8x16_t special = vorrq_u8(vorrq_u8(vceqq_u8(chunk, quote), vceqq_u8(chunk, backslash)), vcltq_u8(chunk, control));
+			if (vmaxvq_u8(special)) {
+				// The exact position is found by the scalar loop
+				break;
+			}
+		}
+#endif
+		for (; i < length; i++) {
+			if (_IsStringSpecialCharacter(p[i])) {
+				break;
+			}
+		}
+		return i;
+	}
+	
+	static inline bool _IsStructuralCharacter(cc7::byte uc)
+	{
+		return uc == '"' || uc == '{' || uc == '}' || uc == '[' || uc == ']';
+	}
+	
+	size_t FindJSONStructuralCharacter(const cc7::byte * p, size_t length)
+	{
+		size_t i = 0;
+#if defined(CC7_JSON_SSE2)
+		const __m128i quote     = _mm_set1_epi8('"');
+		const __m128i brace_l   = _mm_set1_epi8('{');
+		const __m128i brace_r   = _mm_set1_epi8('}');
+		const __m128i bracket_l = _mm_set1_epi8('[');
+		const __m128i bracket_r = _mm_set1_epi8(']');
+		for (; i + 16 <= length; i += 16) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+			__m128i braces   = _mm_or_si128(_mm_cmpeq_epi8(chunk, brace_l), _mm_cmpeq_epi8(chunk, brace_r));
+			__m128i brackets = _mm_or_si128(_mm_cmpeq_epi8(chunk, bracket_l), _mm_cmpeq_epi8(chunk, bracket_r));
+			__m128i special  = _mm_or_si128(_mm_or_si128(braces, brackets), _mm_cmpeq_epi8(chunk, quote));
+			cc7::U32 mask = (cc7::U32)_mm_movemask_epi8(special);
+			if (mask) {
+				return i + JSONCountTrailingZeros(mask);
+			}
+		}
+#elif defined(CC7_JSON_NEON)
+		const uint8x16_t quote     = vdupq_n_u8('"');
+		const uint8x16_t brace_l   = vdupq_n_u8('{');
+		const uint8x16_t brace_r   = vdupq_n_u8('}');
+		const uint8x16_t bracket_l = vdupq_n_u8('[');
+		const uint8x16_t bracket_r = vdupq_n_u8(']');
+		for (; i + 16 <= length; i += 16) {
+			uint8x16_t chunk = vld1q_u8(p + i);
+			uint8x16_t braces   = vorrq_u8(vceqq_u8(chunk, brace_l), vceqq_u8(chunk, brace_r));
+			uint8x16_t brackets = vorrq_u8(vceqq_u8(chunk, bracket_l), vceqq_u8(chunk, bracket_r));
+			uint8x16_t special  = vorrq_u8(vorrq_u8(braces, brackets), vceqq_u8(chunk, quote));
+			if (vmaxvq_u8(special)) {
+				// The exact position is found by the scalar loop
+				break;
+			}
+		}
+#endif
+		for (; i < length; i++) {
+			if (_IsStructuralCharacter(p[i])) {
+				break;
+			}
+		}
+		return i;
+	}
+	
+	static inline bool _IsWhitespace(cc7::byte uc)
+	{
+		return uc == ' ' || uc == '\n' || uc == '\r' || uc == '\t';
+	}
+	
+	size_t SkipJSONWhitespace(const cc7::byte * p, size_t length, size_t & newlines_count, size_t & last_newline)
+	{
+		size_t i = 0;
+		newlines_count = 0;
+#if defined(CC7_JSON_SSE2)
+		const __m128i space   = _mm_set1_epi8(' ');
+		const __m128i tab     = _mm_set1_epi8('\t');
+		const __m128i cr      = _mm_set1_epi8('\r');
+		const __m128i newline = _mm_set1_epi8('\n');
+		for (; i + 16 <= length; i += 16) {
+			__m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+			__m128i newlines = _mm_cmpeq_epi8(chunk, newline);
+			__m128i whitespaces = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, space), _mm_cmpeq_epi8(chunk, tab)),
+											   _mm_or_si128(_mm_cmpeq_epi8(chunk, cr), newlines));
+			cc7::U32 newlines_mask = (cc7::U32)_mm_movemask_epi8(newlines);
+			cc7::U32 tokens_mask = ~(cc7::U32)_mm_movemask_epi8(whitespaces) & 0xFFFF;
+			size_t count = tokens_mask ? JSONCountTrailingZeros(tokens_mask) : 16;
+			// Keep only newlines before the token
+			newlines_mask &= (cc7::U32)((1U << count) - 1);
+			if (newlines_mask) {
+				newlines_count += JSONPopCount(newlines_mask);
+				last_newline = i + JSONHighestBitIndex(newlines_mask);
+			}
+			if (tokens_mask) {
+				return i + count;
+			}
+		}
+#endif
+		for (; i < length; i++) {
+			cc7::byte uc = p[i];
+			if (!_IsWhitespace(uc)) {
+				break;
+			}
+			if (uc == '\n') {
+				newlines_count++;
+				last_newline = i;
+			}
+		}
+		return i;
+	}
+	
+	
+} // cc7::tests::detail
+} // cc7::tests
+} // cc7
@@ -14,8 +14,15 @@
  * limitations under the License.
  */
 
-#include <cc7/Platform.h>
+#include <cc7tests/PerformanceTimer.h>
 #include <time.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
 
 #if !defined(CC7_ANDROID)
 #error "This file is designed for Android platform only"
@@ -28,15 +35,168 @@ namespace tests
 	cc7::U64 Platform_GetCurrentTime()
 	{
 		struct timespec res;
-		clock_gettime(CLOCK_REALTIME, &res);
-		return (cc7::U64)(1000000.0*res.tv_sec + (double)res.tv_nsec * 1.0/1000.0);
+		clock_gettime(CLOCK_MONOTONIC, &res);
+		return (cc7::U64)res.tv_sec * 1000000000ULL + (cc7::U64)res.tv_nsec;
 	}
 	
 	double Platform_GetTimeDiff(cc7::U64 start, cc7::U64 future)
 	{
-		return (future - start) * 1.0/1000.0;
+		return (future - start) * 1.0/1000000.0;
 	}
 
+	double Platform_GetThreadCPUTime()
+	{
+		struct timespec res;
+		if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &res) != 0) {
+			return 0.0;
+		}
+		return 1000.0*res.tv_sec + (double)res.tv_nsec * 1.0/1000000.0;
+	}
+	
+	std::string Platform_GetCPUModel()
+	{
+		std::string model;
+		FILE * f = fopen("/proc/cpuinfo", "r");
+		if (!f) {
+			return model;
+		}
+		char line[256];
+		while (fgets(line, sizeof(line), f)) {
+			// x86 has "model name", ARM kernels have "Hardware" or "Processor"
+			bool found = strncmp(line, "model name", 10) == 0 ||
+						 strncmp(line, "Hardware", 8) == 0 ||
+						 strncmp(line, "Processor", 9) == 0;
+			const char * colon = found ? strchr(line, ':') : nullptr;
+			if (colon) {
+				model.assign(colon + 1);
+				while (!model.empty() && (model.back() == '\n' || model.back() == ' ')) {
+					model.pop_back();
+				}
+				while (!model.empty() && (model.front() == ' ' || model.front() == '\t')) {
+					model.erase(0, 1);
+				}
+				if (strncmp(line, "model name", 10) == 0) {
+					break;
+				}
+			}
+		}
+		fclose(f);
+		return model;
+	}
+
+
+	
+	bool Platform_PinCurrentThread(size_t cpu_index)
+	{
+		if (cpu_index >= CPU_SETSIZE) {
+			return false;
+		}
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu_index, &set);
+		return sched_setaffinity(0, sizeof(set), &set) == 0;
+	}
+	
+	// MARK: - Hardware counters
+	
+	/*
+	 The PerfCounterGroup keeps file descriptors of one perf_event group. The first
+	 opened counter is a group leader, so all counters are enabled and read at once.
+	 */
+	struct PerfCounterGroup
+	{
+		int			leader;
+		int			count;
+		int			counter_at[PerformanceCounters::CountersCount];
+		int			fds[PerformanceCounters::CountersCount];
+	};
+	
+	static int _OpenPerfEvent(cc7::U32 type, cc7::U64 config, int group_fd)
+	{
+		struct perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size			= sizeof(attr);
+		attr.type			= type;
+		attr.config			= config;
+		attr.disabled		= group_fd == -1 ? 1 : 0;
+		attr.exclude_kernel	= 1;	// allows measurement with perf_event_paranoid = 2
+		attr.exclude_hv		= 1;
+		attr.read_format	= PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+		return (int)syscall(__NR_perf_event_open, &attr, 0, -1, group_fd, 0);
+	}
+	
+	static void _ClosePerfGroup(PerfCounterGroup * group)
+	{
+		for (int i = 0; i < group->count; i++) {
+			close(group->fds[i]);
+		}
+		delete group;
+	}
+	
+	void * Platform_StartPerformanceCounters()
+	{
+		static const struct { cc7::U32 type; cc7::U64 config; } s_events[PerformanceCounters::CountersCount] = {
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+			{ PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+			{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+		};
+		PerfCounterGroup * group = new PerfCounterGroup();
+		group->leader = -1;
+		group->count = 0;
+		for (int i = 0; i < PerformanceCounters::CountersCount; i++) {
+			int fd = _OpenPerfEvent(s_events[i].type, s_events[i].config, group->leader);
+			if (fd < 0) {
+				// Not supported by CPU, or not allowed in this environment (typically
+				// in containers). The first failure of the leader disables all counters.
+				if (group->leader == -1 && i == 0) {
+					break;
+				}
+				continue;
+			}
+			if (group->leader == -1) {
+				group->leader = fd;
+			}
+			group->counter_at[group->count] = i;
+			group->fds[group->count] = fd;
+			group->count++;
+		}
+		if (group->count == 0) {
+			delete group;
+			return nullptr;
+		}
+		ioctl(group->leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+		ioctl(group->leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+		return group;
+	}
+	
+	void Platform_StopPerformanceCounters(void * handle, PerformanceCounters & out_counters)
+	{
+		PerfCounterGroup * group = reinterpret_cast<PerfCounterGroup*>(handle);
+		if (!group) {
+			return;
+		}
+		ioctl(group->leader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+		
+		// nr, time_enabled, time_running, values[nr]
+		cc7::U64 buffer[3 + PerformanceCounters::CountersCount];
+		ssize_t expected = (ssize_t)((3 + group->count) * sizeof(cc7::U64));
+		if (read(group->leader, buffer, sizeof(buffer)) == expected && buffer[0] == (cc7::U64)group->count) {
+			cc7::U64 time_enabled = buffer[1];
+			cc7::U64 time_running = buffer[2];
+			if (time_running > 0) {
+				// The group was multiplexed with other events, scale the values.
+				double scale = time_enabled > time_running ? (double)time_enabled / time_running : 1.0;
+				for (int i = 0; i < group->count; i++) {
+					int counter = group->counter_at[i];
+					out_counters.values[counter] = (cc7::U64)(buffer[3 + i] * scale);
+					out_counters.available |= 1 << counter;
+				}
+			}
+		}
+		_ClosePerfGroup(group);
+	}
 
 } // cc7::tests
 } // cc7
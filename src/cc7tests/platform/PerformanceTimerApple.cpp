@@ -18,6 +18,7 @@
 
 #include <mach/mach.h>
 #include <mach/mach_time.h>
+#include <sys/sysctl.h>
 #include <unistd.h>
 
 #if !defined(CC7_APPLE)
@@ -52,6 +53,59 @@ namespace tests
 		return s_timebase_multiplier * (future - start);
 	}
 	
+	double Platform_GetThreadCPUTime()
+	{
+		mach_port_t thread = mach_thread_self();
+		thread_basic_info_data_t info;
+		mach_msg_type_number_t count = THREAD_BASIC_INFO_COUNT;
+		kern_return_t kr = thread_info(thread, THREAD_BASIC_INFO, (thread_info_t)&info, &count);
+		mach_port_deallocate(mach_task_self(), thread);
+		if (kr != KERN_SUCCESS) {
+			return 0.0;
+		}
+		return 1000.0 * (info.user_time.seconds + info.system_time.seconds) +
+			   1.0/1000.0 * (info.user_time.microseconds + info.system_time.microseconds);
+	}
+	
+	static std::string _SysctlString(const char * name)
+	{
+		char buffer[256];
+		size_t size = sizeof(buffer);
+		if (sysctlbyname(name, buffer, &size, NULL, 0) != 0 || size == 0) {
+			return std::string();
+		}
+		return std::string(buffer, strnlen(buffer, size));
+	}
+	
+	std::string Platform_GetCPUModel()
+	{
+		std::string model = _SysctlString("machdep.cpu.brand_string");
+		if (model.empty()) {
+			// iOS devices doesn't provide the brand string
+			model = _SysctlString("hw.machine");
+		}
+		return model;
+	}
+	
+	
+	
+	bool Platform_PinCurrentThread(size_t /*cpu_index*/)
+	{
+		// Apple platforms don't support thread to core binding.
+		return false;
+	}
+	
+	// MARK: - Hardware counters
+	
+	void * Platform_StartPerformanceCounters()
+	{
+		// Not supported on this platform
+		return nullptr;
+	}
+	
+	void Platform_StopPerformanceCounters(void * /*handle*/, PerformanceCounters & /*out_counters*/)
+	{
+	}
 	
 } // cc7::tests
 } // cc7
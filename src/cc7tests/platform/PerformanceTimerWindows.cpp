@@ -14,7 +14,8 @@
  * limitations under the License.
  */
 
-#include <cc7/Platform.h>
+#include <cc7tests/PerformanceTimer.h>
+#include <intrin.h>
 
 #if !defined(CC7_WINDOWS)
 #error "This file is designed for Windows platforms only"
@@ -51,6 +52,63 @@ namespace tests
 		return (future - start) * s_inv_frequency;
 	}
 
+	double Platform_GetThreadCPUTime()
+	{
+		FILETIME creation_time, exit_time, kernel_time, user_time;
+		if (!GetThreadTimes(GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time)) {
+			return 0.0;
+		}
+		// FILETIME is in 100ns units
+		cc7::U64 kernel = ((cc7::U64)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime;
+		cc7::U64 user   = ((cc7::U64)user_time.dwHighDateTime << 32)   | user_time.dwLowDateTime;
+		return (double)(kernel + user) * 1.0/10000.0;
+	}
+	
+	std::string Platform_GetCPUModel()
+	{
+#if defined(_M_IX86) || defined(_M_X64)
+		int regs[4];
+		__cpuid(regs, 0x80000000);
+		if ((unsigned)regs[0] < 0x80000004) {
+			return std::string();
+		}
+		char brand[49];
+		for (int i = 0; i < 3; i++) {
+			__cpuid(regs, 0x80000002 + i);
+			memcpy(brand + i * 16, regs, 16);
+		}
+		brand[48] = 0;
+		std::string model(brand);
+		while (!model.empty() && model.front() == ' ') {
+			model.erase(0, 1);
+		}
+		return model;
+#else
+		return std::string();
+#endif
+	}
+
+	
+	bool Platform_PinCurrentThread(size_t cpu_index)
+	{
+		if (cpu_index >= sizeof(DWORD_PTR) * 8) {
+			return false;
+		}
+		return SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << cpu_index) != 0;
+	}
+	
+	// MARK: - Hardware counters
+	
+	void * Platform_StartPerformanceCounters()
+	{
+		// Not supported on this platform
+		return nullptr;
+	}
+	
+	void Platform_StopPerformanceCounters(void * /*handle*/, PerformanceCounters & /*out_counters*/)
+	{
+	}
+	
 } // cc7::tests
 } // cc7
 
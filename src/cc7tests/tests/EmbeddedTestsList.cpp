@@ -27,6 +27,8 @@ namespace tests
 		// cc7::tests framework tests
 		CC7_ADD_UNIT_TEST(tt7Testception, list);
 		CC7_ADD_UNIT_TEST(tt7JSONReaderTests, list);
+		CC7_ADD_UNIT_TEST(tt7JSONWriterTests, list);
+		CC7_ADD_UNIT_TEST(tt7BenchmarkTests, list);
 		
 		// cc7 framework tests
 		CC7_ADD_UNIT_TEST(cc7PlatformTests, list);
@@ -38,5 +40,16 @@ namespace tests
 		return list;
 	}
 	
+	const UnitTestCreationInfoList _GetDefaultBenchmarkCreationInfoList()
+	{
+		UnitTestCreationInfoList list;
+		
+		// cc7 framework benchmarks
+		CC7_ADD_UNIT_TEST(cc7CodecBenchmarks, list);
+		CC7_ADD_UNIT_TEST(tt7JSONBenchmarks, list);
+		
+		return list;
+	}
+	
 } // cc7::tests
 } // cc7
\ No newline at end of file
@@ -31,10 +31,45 @@ namespace tests
 			CC7_REGISTER_TEST_METHOD(testNoWrapBadData);
 			CC7_REGISTER_TEST_METHOD(testWrap);
 			CC7_REGISTER_TEST_METHOD(testWrapBadData);
+			CC7_REGISTER_TEST_METHOD(testAllocationBudget);
 		}
 		
 		// UNIT TESTS
 		
+		void testAllocationBudget()
+		{
+			if (!AllocationCountersAvailable()) {
+				ccstMessage("Allocation counters are not available.");
+			}
+			ByteArray data = getTestRandomData(1000);
+			std::string encoded, encoded64;
+			ByteArray decoded, decoded64;
+			bool result = false;
+			// The assertion doesn't reset the counters of the test method
+			const cc7::U64 allocations_before = GetAllocationCounters().allocations;
+			ccstAssertNoAllocations(result = data.empty());
+			ccstAssertTrue(GetAllocationCounters().allocations >= allocations_before);
+			if (AllocationCountersAvailable()) {
+				ccstAssertTrue(allocations_before > 0);
+			}
+			// Only output buffers are allocated
+			ccstAssertMaxAllocations(result = Base64_Encode(data, 0, encoded), 1);
+			ccstAssertTrue(result);
+			ccstAssertMaxAllocations(result = Base64_Encode(data, 64, encoded64), 1);
+			ccstAssertTrue(result);
+			ccstAssertMaxAllocations(result = Base64_Decode(encoded, 0, decoded), 1);
+			ccstAssertTrue(result && decoded == data);
+			ccstAssertMaxAllocations(result = Base64_Decode(encoded64, 64, decoded64), 1);
+			ccstAssertTrue(result && decoded64 == data);
+			// Output buffers have enough capacity
+			ccstAssertNoAllocations(result = Base64_Encode(data, 0, encoded));
+			ccstAssertTrue(result);
+			ccstAssertNoAllocations(result = Base64_Decode(encoded, 0, decoded));
+			ccstAssertTrue(result && decoded == data);
+			ccstAssertNoAllocations(result = Base64_Decode(encoded64, 64, decoded64));
+			ccstAssertTrue(result && decoded64 == data);
+		}
+		
 		void testEncodeDecode()
 		{
 			// Good scenarios
@@ -55,21 +90,21 @@ namespace tests
 				if (!result) return;
 				
 				ByteArray plain_dec, padded64_dec, padded76_dec;
-				result = Base64_Decode(plain, 0, plain_dec);
+				ccstAssertMaxReallocations(result = Base64_Decode(plain, 0, plain_dec), 0);
 				ccstAssertTrue(result);
 				if (!result) return;
 				result = plain_dec == source_data;
 				ccstAssertTrue(result);
 				if (!result) return;
 				
-				result = Base64_Decode(padded64, 64, padded64_dec);
+				ccstAssertMaxReallocations(result = Base64_Decode(padded64, 64, padded64_dec), 0);
 				ccstAssertTrue(result);
 				if (!result) return;
 				result = padded64_dec == source_data;
 				ccstAssertTrue(result);
 				if (!result) return;
 				
-				result = Base64_Decode(padded76, 76, padded76_dec);
+				ccstAssertMaxReallocations(result = Base64_Decode(padded76, 76, padded76_dec), 0);
 				ccstAssertTrue(result);
 				if (!result) return;
 				result = padded76_dec == source_data;
@@ -243,6 +278,15 @@ namespace tests
 			result = Base64_Decode(input, 64, output_data);
 			ccstAssertTrue(result);
 			ccstAssertEqual(output_data.size(), 0);
+			
+			// Lines longer than wrap_size makes the size estimation too low.
+			// The output buffer still should not be reallocated for each line.
+			ByteArray long_data = getTestRandomData(8192);
+			result = Base64_Encode(long_data, 76, input);
+			ccstAssertTrue(result);
+			ccstAssertMaxReallocations(result = Base64_Decode(input, 4, output_data), 4);
+			ccstAssertTrue(result);
+			ccstAssertEqual(output_data, long_data);
 		}
 		
 		void testWrapBadData()
@@ -35,6 +35,7 @@ namespace tests
 			CC7_REGISTER_TEST_METHOD(testRelationalOperators)
 			CC7_REGISTER_TEST_METHOD(testOtherMethods)
 			CC7_REGISTER_TEST_METHOD(testIterators)
+			CC7_REGISTER_TEST_METHOD(testAllocationStats)
 		}
 		
 		// Helper methods
@@ -399,6 +400,41 @@ namespace tests
 			ccstAssertEqual(a2, ByteArray({8, 7, 6, 5, 4, 3, 2, 1}));
 		}
 		
+		void testAllocationStats()
+		{
+#if defined(ENABLE_CC7_ALLOCATION_STATS)
+			debug::ResetAllocationStats();
+			{
+				ByteArray a1;
+				a1.reserve(16);
+				a1.assign(16, 0xAA);
+				a1.append(ByteArray(32, 0x55));		// temporary array + growth of a1
+			}
+			debug::AllocationStats stats = debug::GetAllocationStats();
+			ccstAssertEqual(stats.allocations, stats.deallocations);
+			ccstAssertEqual(stats.live_bytes, 0);
+			ccstAssertTrue(stats.allocations >= 3);
+			ccstAssertTrue(stats.peak_live_bytes >= 16 + 32 + 48);
+			ccstAssertEqual(stats.wiped_bytes, stats.allocated_bytes);
+			ccstAssertEqual(stats.reallocations, 1);
+			
+			// Concatenation with reserved capacity must not reallocate
+			const ByteArray a2(100, 1);
+			const ByteArray a3(200, 2);
+			ByteArray concat;
+			ccstAssertMaxReallocations({
+				concat.reserve(a2.size() + a3.size());
+				concat.append(a2).append(a3);
+			}, 0);
+			ccstAssertEqual(concat.size(), 300);
+			
+			debug::ResetAllocationStats();
+			stats = debug::GetAllocationStats();
+			ccstAssertEqual(stats.allocations, 0);
+			ccstAssertEqual(stats.peak_live_bytes, 0);
+#endif
+		}
+		
 	};
 	
 	CC7_CREATE_UNIT_TEST(cc7ByteArrayTests, "cc7")
@@ -0,0 +1,116 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cc7tests/CC7Tests.h>
+#include <cc7/Base64.h>
+#include <cc7/HexString.h>
+
+namespace cc7
+{
+namespace tests
+{
+	class cc7CodecBenchmarks : public Benchmark
+	{
+	public:
+		
+		static const size_t kDataSize = 4096;
+		
+		cc7CodecBenchmarks()
+		{
+			CC7_REGISTER_BENCHMARK_METHOD(benchBase64Encode, kDataSize)
+			CC7_REGISTER_BENCHMARK_METHOD(benchBase64Decode, kDataSize)
+			CC7_REGISTER_BENCHMARK_METHOD(benchBase64DecodeWrapped, kDataSize)
+			CC7_REGISTER_BENCHMARK_METHOD(benchHexEncode, kDataSize)
+			CC7_REGISTER_BENCHMARK_METHOD(benchHexDecode, kDataSize)
+			CC7_REGISTER_SCALING_BENCHMARK_METHOD(benchBase64EncodeThreads, kDataSize)
+		}
+		
+		ByteArray	_data;
+		std::string	_base64;
+		std::string	_base64_wrapped;
+		std::string	_hex;
+		
+		void instanceSetUp()
+		{
+			_data = getTestRandomData(kDataSize);
+			_base64 = ToBase64String(_data);
+			_base64_wrapped = ToBase64String(_data, 64);
+			_hex = ToHexString(_data);
+		}
+		
+		// BENCHMARKS
+		
+		void benchBase64Encode(size_t iterations)
+		{
+			std::string out;
+			for (size_t i = 0; i < iterations; i++) {
+				Base64_Encode(_data, 0, out);
+				BenchmarkKeepValue(out);
+			}
+		}
+		
+		void benchBase64Decode(size_t iterations)
+		{
+			ByteArray out;
+			for (size_t i = 0; i < iterations; i++) {
+				Base64_Decode(_base64, 0, out);
+				BenchmarkKeepValue(out);
+			}
+		}
+		
+		void benchBase64DecodeWrapped(size_t iterations)
+		{
+			ByteArray out;
+			for (size_t i = 0; i < iterations; i++) {
+				Base64_Decode(_base64_wrapped, 64, out);
+				BenchmarkKeepValue(out);
+			}
+		}
+		
+		void benchBase64EncodeThreads(size_t iterations)
+		{
+			// Each iteration allocates a new string, to see the allocator contention.
+			for (size_t i = 0; i < iterations; i++) {
+				std::string out;
+				Base64_Encode(_data, 0, out);
+				BenchmarkKeepValue(out);
+			}
+		}
+		
+		void benchHexEncode(size_t iterations)
+		{
+			std::string out;
+			for (size_t i = 0; i < iterations; i++) {
+				HexString_Encode(_data, false, out);
+				BenchmarkKeepValue(out);
+			}
+		}
+		
+		void benchHexDecode(size_t iterations)
+		{
+			ByteArray out;
+			for (size_t i = 0; i < iterations; i++) {
+				HexString_Decode(_hex, out);
+				BenchmarkKeepValue(out);
+			}
+		}
+	};
+	
+	CC7_CREATE_BENCHMARK(cc7CodecBenchmarks, "cc7")
+	
+} // cc7::tests
+} // cc7
@@ -16,6 +16,7 @@
 
 #include <cc7tests/CC7Tests.h>
 #include <cc7/CC7.h>
+#include <thread>
 
 namespace cc7
 {
@@ -28,10 +29,12 @@ namespace tests
 		{
 			CC7_REGISTER_TEST_METHOD(testPlatformBits)
 			CC7_REGISTER_TEST_METHOD(testDebugFeatures)
+			CC7_REGISTER_TEST_METHOD(testAssertionRateLimit)
 			CC7_REGISTER_TEST_METHOD(testEndian16)
 			CC7_REGISTER_TEST_METHOD(testEndian32)
 			CC7_REGISTER_TEST_METHOD(testEndian64)
 			CC7_REGISTER_TEST_METHOD(testEndianIntrinsics)
+			CC7_REGISTER_TEST_METHOD(testTracing)
 		}
 		
 		void testPlatformBits()
@@ -67,6 +70,121 @@ namespace tests
 #endif
 		}
 		
+#if defined(ENABLE_CC7_ASSERT)
+		static void countingAssertionHandler(void * handler_data, const char * /*file*/, int /*line*/, const char * /*message*/)
+		{
+			(*reinterpret_cast<int*>(handler_data))++;
+		}
+		
+		int failingCheck(int value)
+		{
+			return CC7_CHECK(value < 0, "Value %d is not negative", value);
+		}
+#endif
+		
+		void testAssertionRateLimit()
+		{
+#if defined(ENABLE_CC7_ASSERT)
+			int reports = 0;
+			cc7::debug::AssertionHandlerSetup old_handler = cc7::debug::GetAssertionHandler();
+			unsigned int old_limit = cc7::debug::GetAssertionReportLimit();
+			cc7::debug::SetAssertionHandler({ countingAssertionHandler, &reports });
+			cc7::debug::SetAssertionReportLimit(4);
+			
+			// 4 reports + summaries at 8, 16, 32 & 64
+			for (int i = 0; i < 100; i++) {
+				CC7_ASSERT(i < 0, "Failure %d", i);
+			}
+			int assert_reports = reports;
+			// 4 reports + summaries at 8 & 16
+			reports = 0;
+			int check_result = 1;
+			for (int i = 0; i < 20; i++) {
+				check_result &= failingCheck(i);
+			}
+			int check_reports = reports;
+			// Both sites have suppressed reports
+			reports = 0;
+			cc7::debug::ReportSuppressedAssertions();
+			int summary_reports = reports;
+			// All failures are reported without the limit
+			cc7::debug::ResetAssertionCounters();
+			cc7::debug::SetAssertionReportLimit(0);
+			reports = 0;
+			for (int i = 0; i < 10; i++) {
+				failingCheck(i);
+			}
+			int unlimited_reports = reports;
+			
+			cc7::debug::SetAssertionReportLimit(old_limit);
+			cc7::debug::SetAssertionHandler(old_handler);
+			cc7::debug::ResetAssertionCounters();
+			
+			ccstAssertEqual(assert_reports, 8);
+			ccstAssertEqual(check_reports, 6);
+			ccstAssertEqual(check_result, 0);
+			ccstAssertEqual(summary_reports, 2);
+			ccstAssertEqual(unlimited_reports, 10);
+			ccstAssertTrue(failingCheck(-1) == 1);
+#endif
+		}
+		
+		void testTracing()
+		{
+#if defined(ENABLE_CC7_TRACE)
+			if (cc7::debug::IsTracingActive()) {
+				ccstMessage("Tracing is already active. Skipping the test.");
+				return;
+			}
+			cc7::debug::StartTracing();
+			{
+				CC7_TRACE_SCOPE("testTracing");
+				CC7_TRACE_COUNTER("testTracing.counter", 42);
+				std::string encoded = ToBase64String(getTestRandomData(64));
+				ccstAssertTrue(FromBase64String(encoded).size() == 64);
+			}
+			// Events of finished thread are kept for the export
+			std::thread([]() {
+				CC7_TRACE_COUNTER("testTracing.thread", 7);
+			}).join();
+			cc7::debug::StopTracing();
+			
+			JSONValue root;
+			std::string error;
+			bool result = JSON_ParseString(cc7::debug::ExportTraceEvents(), root, &error);
+			ccstAssertTrue(result, "Exported trace is not valid JSON: %s", error.c_str());
+			if (!result) {
+				return;
+			}
+			int begins = 0, ends = 0, counters = 0, thread_counters = 0, base64 = 0;
+			for (auto && event : root.arrayAtPath("traceEvents")) {
+				const JSONString ph = event.stringAtPath("ph");
+				if (ph == "B") {
+					begins++;
+				} else if (ph == "E") {
+					ends++;
+				} else if (ph == "C" && event.stringAtPath("name") == "testTracing.thread") {
+					ccstAssertEqual(event.integerAtPath("args.value"), 7);
+					thread_counters++;
+				} else if (ph == "C") {
+					ccstAssertEqual(event.stringAtPath("name"), "testTracing.counter");
+					ccstAssertEqual(event.integerAtPath("args.value"), 42);
+					counters++;
+				}
+				if (ph != "M" && event.stringAtPath("name").find("Base64_") == 0) {
+					base64++;
+				}
+			}
+			ccstAssertEqual(begins, 3);
+			ccstAssertEqual(ends, 3);
+			ccstAssertEqual(counters, 1);
+			ccstAssertEqual(thread_counters, 1);
+			ccstAssertEqual(base64, 4);
+			cc7::debug::ClearTraceEvents();
+			ccstAssertTrue(cc7::debug::ExportTraceEvents().find("cc7 thread") == std::string::npos);
+#endif
+		}
+		
 		void testEndianIntrinsics()
 		{
 #if !defined(CC7_BSWAP_16)
@@ -137,7 +255,7 @@ namespace tests
 		
 	};
 	
-	CC7_CREATE_UNIT_TEST(cc7PlatformTests, "cc7")
+	CC7_CREATE_UNIT_TEST(cc7PlatformTests, "cc7 serial")
 	
 } // cc7::tests
 } // cc7
\ No newline at end of file
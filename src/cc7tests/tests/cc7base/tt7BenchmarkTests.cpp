@@ -0,0 +1,339 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cc7tests/CC7Tests.h>
+#include <cc7tests/BenchmarkReport.h>
+#include <cc7tests/detail/StringUtils.h>
+#include <atomic>
+#include <math.h>
+#include <signal.h>
+
+namespace cc7
+{
+namespace tests
+{
+	/**
+	 The tt7BenchmarkTests tests the BenchmarkRunner itself.
+	 */
+	class tt7BenchmarkTests : public UnitTest
+	{
+	public:
+		
+		tt7BenchmarkTests()
+		{
+			CC7_REGISTER_TEST_METHOD(testStatistics)
+			CC7_REGISTER_TEST_METHOD(testRunner)
+			CC7_REGISTER_TEST_METHOD(testPerformanceCounters)
+			CC7_REGISTER_TEST_METHOD(testTimerBackend)
+			CC7_REGISTER_TEST_METHOD(testPerformanceAssertions)
+			CC7_REGISTER_TEST_METHOD(testScalingRunner)
+			CC7_REGISTER_TEST_METHOD(testSamplingProfiler)
+			CC7_REGISTER_TEST_METHOD(testMannWhitney)
+			CC7_REGISTER_TEST_METHOD(testBaseline)
+		}
+		
+		void testStatistics()
+		{
+			BenchmarkResult result;
+			result.bytes_per_iteration = 1000;
+			result.samples = { 5.0, 1.0, 4.0, 2.0, 3.0 };
+			result.computeStatistics();
+			ccstAssertEqual(result.min, 1.0);
+			ccstAssertEqual(result.median, 3.0);
+			ccstAssertEqual(result.mean, 3.0);
+			ccstAssertTrue(result.p99 > 4.9 && result.p99 <= 5.0);
+			ccstAssertTrue(fabs(result.stddev - 1.5811388) < 0.0001);
+			ccstAssertEqual(result.bytes_per_second, 1000.0 * 1e9 / 3.0);
+			
+			BenchmarkResult empty;
+			empty.computeStatistics();
+			ccstAssertEqual(empty.median, 0.0);
+			ccstAssertEqual(empty.bytes_per_second, 0.0);
+		}
+		
+		void testRunner()
+		{
+			BenchmarkConfig config;
+			config.target_time = 0.5;
+			config.repetitions = 5;
+			config.max_iterations = 100000;
+			BenchmarkRunner runner(config);
+			
+			size_t total = 0;
+			BenchmarkResult result = runner.run("tt7BenchmarkTests.sum", [&total](size_t iterations) {
+				size_t sum = 0;
+				for (size_t i = 0; i < iterations; i++) {
+					sum += i;
+					BenchmarkKeepValue(sum);
+				}
+				total += iterations;
+			}, 8);
+			
+			ccstAssertEqual(result.name, "tt7BenchmarkTests.sum");
+			ccstAssertEqual(result.samples.size(), 5);
+			ccstAssertTrue(result.iterations >= 1 && result.iterations <= config.max_iterations);
+			ccstAssertTrue(total >= result.iterations * 6);
+			ccstAssertTrue(result.min <= result.median && result.median <= result.p99);
+			ccstAssertTrue(result.bytes_per_second > 0.0);
+			ccstMessage("%s", result.toString().c_str());
+		}
+		
+		void testPerformanceCounters()
+		{
+			const size_t count = 100000;
+			size_t sum = 0;
+			PerformanceCounters counters;
+			PerformanceTimer timer;
+			double elapsed = timer.measureBlock([&sum, count]() {
+				for (size_t i = 0; i < count; i++) {
+					sum += i;
+					BenchmarkKeepValue(sum);
+				}
+			}, &counters);
+			ccstAssertTrue(elapsed >= 0.0);
+			ccstAssertEqual(sum, count * (count - 1) / 2);
+			if (!counters.isAnyAvailable()) {
+				ccstMessage("Hardware performance counters are not available.");
+				return;
+			}
+			if (counters.isAvailable(PerformanceCounters::Instructions)) {
+				// At least one instruction per loop
+				ccstAssertTrue(counters.values[PerformanceCounters::Instructions] >= count);
+			}
+			if (counters.isAvailable(PerformanceCounters::Cycles)) {
+				ccstAssertTrue(counters.values[PerformanceCounters::Cycles] > 0);
+			}
+			
+			// Disabled counters in runner
+			BenchmarkConfig config;
+			config.target_time = 0.2;
+			config.repetitions = 3;
+			config.hardware_counters = false;
+			BenchmarkResult result = BenchmarkRunner(config).run("tt7BenchmarkTests.nop", [](size_t /*iterations*/) { }, 0);
+			ccstAssertEqual(result.counters_available, 0);
+		}
+		
+		void testTimerBackend()
+		{
+			ccstMessage("Timer backend: %s, overhead %.1f ns", PerformanceTimer::backendName(),
+						PerformanceTimer::ticksToNanoseconds(PerformanceTimer::overheadTicks()));
+			
+			// Back to back measurement is close to zero after the overhead subtraction.
+			PerformanceTimer timer;
+			double empty = timer.elapsedNanoseconds();
+			ccstAssertTrue(empty >= 0.0 && empty < 1000.0);
+			
+			// Compare with the OS clock
+			cc7::U64 os_start = Platform_GetCurrentTime();
+			timer.start();
+			double os_elapsed;
+			do {
+				os_elapsed = Platform_GetTimeDiff(os_start, Platform_GetCurrentTime());
+			} while (os_elapsed < 2.0);
+			double elapsed = timer.elapsedTime();
+			double elapsed_ns = timer.elapsedNanoseconds();
+			ccstAssertTrue(fabs(elapsed - os_elapsed) < os_elapsed * 0.1, "Timer %.4f ms vs OS %.4f ms", elapsed, os_elapsed);
+			ccstAssertTrue(elapsed_ns >= elapsed * 1e6 * 0.9);
+			ccstAssertTrue(timer.elapsedTicks() > 0);
+		}
+		
+		static size_t sumBytes(const cc7::byte * data, size_t size)
+		{
+			size_t sum = 0;
+			for (size_t i = 0; i < size; i++) {
+				sum += data[i];
+				BenchmarkKeepValue(sum);
+			}
+			return sum;
+		}
+		
+		void testPerformanceAssertions()
+		{
+			cc7::ByteArray data(4096, 1);
+			size_t sum = 0;
+			ccstAssertThroughputAtLeast(data.size(), 1.0, sum += sumBytes(data.data(), data.size()));
+			ccstAssertFasterThan(sum += sumBytes(data.data(), 16), sum += sumBytes(data.data(), data.size()), 4.0);
+			ccstAssertTrue(sum > 0);
+		}
+		
+		void testScalingRunner()
+		{
+			BenchmarkConfig config;
+			config.target_time = 0.5;
+			config.repetitions = 3;
+			config.max_threads = 3;
+			config.pin_threads = true;
+			BenchmarkRunner runner(config);
+			
+			std::atomic<size_t> total(0);
+			auto results = runner.runScaling("tt7BenchmarkTests.sum", [&total](size_t iterations) {
+				size_t sum = 0;
+				for (size_t i = 0; i < iterations; i++) {
+					sum += i;
+					BenchmarkKeepValue(sum);
+				}
+				total += iterations;
+			}, 8);
+			
+			ccstAssertEqual(results.size(), 3);
+			if (results.size() != 3) {
+				return;
+			}
+			const size_t expected_threads[] = { 1, 2, 3 };
+			for (size_t i = 0; i < results.size(); i++) {
+				auto & step = results[i];
+				ccstMessage("%s", step.toString().c_str());
+				ccstAssertEqual(step.threads, expected_threads[i]);
+				ccstAssertEqual(step.result.samples.size(), step.threads * 3);
+				ccstAssertEqual(step.result.name, detail::FormattedString("tt7BenchmarkTests.sum/threads:%d", (int)step.threads));
+				ccstAssertTrue(step.operations_per_second > 0.0);
+				ccstAssertTrue(step.bytes_per_second > 0.0);
+				ccstAssertTrue(step.efficiency > 0.0);
+			}
+			ccstAssertEqual(results[0].efficiency, 1.0);
+			ccstAssertEqual(results[0].thread_variation, 0.0);
+			ccstAssertTrue(total.load() >= results[0].result.iterations * (1 + 3 + 2 * 3 + 3 * 3));
+		}
+		
+		void testSamplingProfiler()
+		{
+			if (!SamplingProfiler::isSupported()) {
+				ccstMessage("Sampling profiler is not supported on this platform.");
+				return;
+			}
+			SamplingProfiler profiler(1024, 32);
+			if (!profiler.start(1000)) {
+				ccstMessage("Other profiler is already running.");
+				return;
+			}
+			ccstAssertTrue(profiler.isRunning());
+			ccstAssertFalse(SamplingProfiler().start());
+			profiler.setLabel("tt7BenchmarkTests");
+			// Burn at least 50ms of CPU time
+			double cpu_start = Platform_GetThreadCPUTime();
+			size_t sum = 0;
+			while (Platform_GetThreadCPUTime() - cpu_start < 50.0) {
+				sum += sumBytes(reinterpret_cast<const cc7::byte*>(this), sizeof(*this));
+			}
+			profiler.stop();
+			ccstAssertFalse(profiler.isRunning());
+			ccstAssertTrue(sum > 0);
+#if defined(SIGPROF)
+			// Late signal doesn't terminate the process
+			raise(SIGPROF);
+#endif
+			
+			size_t samples = profiler.samplesCount();
+			ccstAssertTrue(samples > 0);
+			std::string folded = profiler.foldedStacks();
+			size_t total = 0;
+			for (auto && line : detail::SplitString(folded, '\n')) {
+				size_t space = line.rfind(' ');
+				ccstAssertTrue(space != std::string::npos && space > 0);
+				if (space == std::string::npos) {
+					break;
+				}
+				ccstAssertTrue(line.find("tt7BenchmarkTests;") == 0, "Unexpected stack: %s", line.c_str());
+				total += (size_t)atoi(line.c_str() + space + 1);
+			}
+			ccstAssertEqual(total, samples);
+			
+			profiler.clear();
+			ccstAssertEqual(profiler.samplesCount(), 0);
+			ccstAssertEqual(profiler.foldedStacks(), "");
+		}
+		
+		void testMannWhitney()
+		{
+			std::vector<double> fast = { 10.0, 10.2, 9.9, 10.1, 10.0, 9.8, 10.3, 10.1 };
+			std::vector<double> slow = { 12.0, 12.2, 11.9, 12.1, 12.0, 11.8, 12.3, 12.1 };
+			ccstAssertTrue(MannWhitneyGreaterPValue(slow, fast) < 0.001);
+			ccstAssertTrue(MannWhitneyGreaterPValue(fast, slow) > 0.99);
+			double p = MannWhitneyGreaterPValue(fast, fast);
+			ccstAssertTrue(p > 0.3 && p < 0.7);
+			ccstAssertEqual(MannWhitneyGreaterPValue(fast, std::vector<double>()), 1.0);
+			// All values are equal
+			std::vector<double> same(8, 1.0);
+			ccstAssertEqual(MannWhitneyGreaterPValue(same, same), 1.0);
+		}
+		
+		void testBaseline()
+		{
+			BenchmarkResult r1;
+			r1.name = "tt7BenchmarkTests.first";
+			r1.iterations = 100;
+			r1.bytes_per_iteration = 64;
+			r1.samples = { 10.0, 10.2, 9.9, 10.1, 10.0, 9.8, 10.3, 10.1 };
+			r1.computeStatistics();
+			BenchmarkResult r2;
+			r2.name = "tt7BenchmarkTests.\"second\"";
+			r2.iterations = 5;
+			r2.samples = { 100.0, 101.0, 99.0, 100.0, 100.5 };
+			r2.computeStatistics();
+			
+			BenchmarkContext context = BenchmarkContext::currentContext();
+			std::string json = BenchmarkResultsToJSON({ r1, r2 }, context);
+			
+			JSONValue root;
+			std::string error;
+			bool result = JSON_ParseString(json, root, &error);
+			ccstAssertTrue(result, "Invalid JSON: %s", error.c_str());
+			if (!result) {
+				return;
+			}
+			ccstAssertEqual(root.stringAtPath("context.build_flags"), context.build_flags);
+			ccstAssertEqual(root.arrayAtPath("benchmarks").size(), 2);
+			ccstAssertEqual(root.arrayAtPath("benchmarks")[1].stringAtPath("name"), r2.name);
+			ccstAssertEqual(root.arrayAtPath("benchmarks")[0].integerAtPath("bytes_per_iteration"), 64);
+			
+			BenchmarkBaseline baseline;
+			ccstAssertTrue(baseline.isEmpty());
+			result = baseline.load(ByteRange(json), &error);
+			ccstAssertTrue(result, "Baseline load failed: %s", error.c_str());
+			ccstAssertFalse(baseline.isEmpty());
+			
+			// The same results
+			BenchmarkComparison comparison;
+			ccstAssertTrue(baseline.compare(r1, comparison));
+			ccstAssertFalse(comparison.regression);
+			// 20% slower
+			BenchmarkResult slower = r1;
+			for (double & s : slower.samples) {
+				s *= 1.2;
+			}
+			slower.computeStatistics();
+			ccstAssertTrue(baseline.compare(slower, comparison));
+			ccstAssertTrue(comparison.regression);
+			ccstAssertTrue(comparison.ratio > 1.19 && comparison.ratio < 1.21);
+			// 20% slower, but under the threshold
+			baseline.setThreshold(0.25);
+			ccstAssertTrue(baseline.compare(slower, comparison));
+			ccstAssertFalse(comparison.regression);
+			// Unknown benchmark
+			BenchmarkResult unknown = r1;
+			unknown.name = "unknown";
+			ccstAssertFalse(baseline.compare(unknown, comparison));
+			// Invalid document
+			ccstAssertFalse(baseline.load(ByteRange(std::string("{\"benchmarks\":12}")), &error));
+			ccstAssertTrue(baseline.isEmpty());
+		}
+	};
+	
+	CC7_CREATE_UNIT_TEST(tt7BenchmarkTests, "cc7 test")
+	
+} // cc7::tests
+} // cc7
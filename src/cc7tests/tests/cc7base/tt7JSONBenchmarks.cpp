@@ -0,0 +1,309 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cc7tests/CC7Tests.h>
+#include <cc7tests/detail/StringUtils.h>
+
+namespace cc7
+{
+namespace tests
+{
+	class tt7JSONBenchmarks : public Benchmark
+	{
+	public:
+		
+		std::string _document;
+		std::string _pretty_document;
+		std::string _numbers_document;
+		std::string _nested_document_4;
+		std::string _nested_document_8;
+		std::string _nested_document_14;
+		JSONValue _parsed_document;
+		JSONValue _parsed_numbers;
+		
+		tt7JSONBenchmarks()
+		{
+			_document = buildDocument(128);
+			_pretty_document = buildPrettyDocument(128);
+			_numbers_document = buildNumbersDocument(4096);
+			// Each document has the same size, so the throughput should not
+			// depend on the depth of nesting.
+			_nested_document_4  = buildNestedDocument(4, 64 * 1024);
+			_nested_document_8  = buildNestedDocument(8, 64 * 1024);
+			_nested_document_14 = buildNestedDocument(14, 64 * 1024);
+			// Serialization is measured with already parsed documents.
+			JSON_ParseString(_document, _parsed_document);
+			JSON_ParseString(_numbers_document, _parsed_numbers);
+			
+			CC7_REGISTER_BENCHMARK_METHOD(benchParseDocument, _document.size())
+			CC7_REGISTER_BENCHMARK_METHOD(benchParseArenaDocument, _document.size())
+			CC7_REGISTER_BENCHMARK_METHOD(benchParsePrettyDocument, _pretty_document.size())
+			CC7_REGISTER_BENCHMARK_METHOD(benchParseNumbers, _numbers_document.size())
+			CC7_REGISTER_BENCHMARK_METHOD(benchParseNested4, _nested_document_4.size())
+			CC7_REGISTER_BENCHMARK_METHOD(benchParseNested8, _nested_document_8.size())
+			CC7_REGISTER_BENCHMARK_METHOD(benchParseNested14, _nested_document_14.size())
+			CC7_REGISTER_BENCHMARK_METHOD(benchSerializeDocument, JSON_Serialize(_parsed_document).size())
+			CC7_REGISTER_BENCHMARK_METHOD(benchSerializeNumbers, JSON_Serialize(_parsed_numbers).size())
+			CC7_REGISTER_BENCHMARK_METHOD(benchValueAtPath, 0)
+			CC7_REGISTER_BENCHMARK_METHOD(benchCompiledPath, 0)
+			CC7_REGISTER_BENCHMARK_METHOD(benchLazyDocument, _document.size())
+			CC7_REGISTER_BENCHMARK_METHOD(benchStreamParser, _document.size())
+			CC7_REGISTER_TEST_METHOD(reportNodeFootprint)
+		}
+		
+		static std::string buildDocument(size_t count)
+		{
+			std::string doc("{\"items\":[");
+			for (size_t i = 0; i < count; i++) {
+				if (i > 0) {
+					doc.append(",");
+				}
+				doc.append(detail::FormattedString("{\"id\":%d,\"name\":\"item number %d\",\"enabled\":%s,"
+												   "\"ratio\":%d.%d,\"tags\":[\"a\",\"b\",\"c\"],\"child\":{\"value\":null}}",
+												   (int)i, (int)i, (i & 1) ? "true" : "false", (int)i, (int)(i * 7) % 10));
+			}
+			doc.append("]}");
+			return doc;
+		}
+		
+		static std::string buildPrettyDocument(size_t count)
+		{
+			// Indented document with long strings, like the typical test vectors.
+			std::string doc("{\n  \"vectors\": [\n");
+			for (size_t i = 0; i < count; i++) {
+				if (i > 0) {
+					doc.append(",\n");
+				}
+				doc.append(detail::FormattedString("    {\n      \"description\": \"Test vector number %d, with a long description\",\n"
+												   "      \"data\": \"%s\"\n    }",
+												   (int)i, std::string(64 + (i & 63), 'a' + (i % 26)).c_str()));
+			}
+			doc.append("\n  ]\n}\n");
+			return doc;
+		}
+		
+		static std::string buildNumbersDocument(size_t count)
+		{
+			// Array of integers and doubles, in various formats.
+			std::string doc("[");
+			cc7::U32 seed = 1;
+			for (size_t i = 0; i < count; i++) {
+				seed = seed * 1103515245 + 12345;
+				if (i > 0) {
+					doc.append(",");
+				}
+				switch (i & 3) {
+					case 0:  doc.append(detail::FormattedString("%d", (int)seed)); break;
+					case 1:  doc.append(detail::FormattedString("%.17g", (double)seed / 7.0)); break;
+					case 2:  doc.append(detail::FormattedString("%.3f", (double)(seed & 0xFFFFF) / 1000.0)); break;
+					default: doc.append(detail::FormattedString("%.6e", (double)seed * 1e-20)); break;
+				}
+			}
+			doc.append("]");
+			return doc;
+		}
+		
+		static std::string buildNestedDocument(size_t depth, size_t size)
+		{
+			// Each level contains an array of numbers and the next level. All numbers
+			// have the same width and all levels together contain the same number of values,
+			// so the documents with a different depth differ only in the nesting.
+			const size_t values_count = size / 6;
+			std::string doc;
+			for (size_t level = 0; level < depth; level++) {
+				doc.append(detail::FormattedString("{\"level\":%d,\"values\":[", (int)level));
+				size_t level_count = values_count / depth;
+				if (level == depth - 1) {
+					level_count += values_count % depth;
+				}
+				for (size_t i = 0; i < level_count; i++) {
+					doc.append(detail::FormattedString(i > 0 ? ",%d" : "%d", 10000 + (int)(i % 90000)));
+				}
+				doc.append("],\"child\":");
+			}
+			doc.append("null");
+			doc.append(depth, '}');
+			return doc;
+		}
+		
+		static size_t countNodes(const JSONValue & value)
+		{
+			size_t count = 1;
+			if (value.isType(JSONValue::Array)) {
+				for (auto && element : value.asArray()) {
+					count += countNodes(element);
+				}
+			} else if (value.isType(JSONValue::Object)) {
+				for (auto && member : value.asObject()) {
+					count += countNodes(member.second);
+				}
+			}
+			return count;
+		}
+		
+		// MEMORY
+		
+		void reportNodeFootprint()
+		{
+			// Reports the memory cost of one parsed value. The heap usage is known
+			// only when all allocations are counted.
+			JSONValue root;
+#if defined(ENABLE_CC7_ALLOCATION_COUNTER)
+			AllocationCounters before = GetAllocationCounters();
+			JSON_ParseString(_document, root);
+			AllocationCounters after = GetAllocationCounters();
+			const size_t nodes = countNodes(root);
+			ccstMessage("JSONValue: %d bytes, %d values, heap %.1f bytes and %.2f allocations per value",
+						(int)sizeof(JSONValue), (int)nodes,
+						(double)(after.allocated_bytes - before.allocated_bytes) / nodes,
+						(double)(after.allocations - before.allocations) / nodes);
+#else
+			JSON_ParseString(_document, root);
+			ccstMessage("JSONValue: %d bytes, %d values", (int)sizeof(JSONValue), (int)countNodes(root));
+#endif
+		}
+		
+		// BENCHMARKS
+		
+		void benchParseDocument(size_t iterations)
+		{
+			ByteRange range(_document);
+			for (size_t i = 0; i < iterations; i++) {
+				JSONValue root;
+				JSON_ParseData(range, root);
+				BenchmarkKeepValue(root);
+			}
+		}
+		
+		void benchParseArenaDocument(size_t iterations)
+		{
+			ByteRange range(_document);
+			JSONDocument document;
+			for (size_t i = 0; i < iterations; i++) {
+				document.parse(range);
+				BenchmarkKeepValue(document.root());
+			}
+		}
+		
+		void parseRepeatedly(const std::string & document, size_t iterations)
+		{
+			ByteRange range(document);
+			for (size_t i = 0; i < iterations; i++) {
+				JSONValue root;
+				JSON_ParseData(range, root);
+				BenchmarkKeepValue(root);
+			}
+		}
+		
+		void benchParsePrettyDocument(size_t iterations)
+		{
+			parseRepeatedly(_pretty_document, iterations);
+		}
+		
+		void benchParseNumbers(size_t iterations)
+		{
+			parseRepeatedly(_numbers_document, iterations);
+		}
+		
+		void benchParseNested4(size_t iterations)
+		{
+			parseRepeatedly(_nested_document_4, iterations);
+		}
+		
+		void benchParseNested8(size_t iterations)
+		{
+			parseRepeatedly(_nested_document_8, iterations);
+		}
+		
+		void benchParseNested14(size_t iterations)
+		{
+			parseRepeatedly(_nested_document_14, iterations);
+		}
+		
+		void serializeRepeatedly(const JSONValue & value, size_t iterations)
+		{
+			// The writer's buffer is reused
+			JSONWriter writer;
+			for (size_t i = 0; i < iterations; i++) {
+				writer.reset();
+				writer.value(value);
+				BenchmarkKeepValue(writer.output());
+			}
+		}
+		
+		void benchSerializeDocument(size_t iterations)
+		{
+			serializeRepeatedly(_parsed_document, iterations);
+		}
+		
+		void benchSerializeNumbers(size_t iterations)
+		{
+			serializeRepeatedly(_parsed_numbers, iterations);
+		}
+		
+		void benchValueAtPath(size_t iterations)
+		{
+			// Typical test-vector loop, with the same path used again and again
+			const std::string path("items[100].child.value");
+			for (size_t i = 0; i < iterations; i++) {
+				BenchmarkKeepValue(_parsed_document.valueAtPath(path));
+			}
+		}
+		
+		void benchCompiledPath(size_t iterations)
+		{
+			const JSONPath path("items[100].child.value");
+			for (size_t i = 0; i < iterations; i++) {
+				BenchmarkKeepValue(_parsed_document.valueAtPath(path));
+			}
+		}
+		
+		void benchLazyDocument(size_t iterations)
+		{
+			// Reads a few fields from a fresh document, compare with benchParseDocument
+			const JSONPath name_path("items[100].name");
+			const JSONPath ratio_path("items[120].ratio");
+			JSONLazyDocument doc;
+			for (size_t i = 0; i < iterations; i++) {
+				doc.load(ByteRange(_document));
+				BenchmarkKeepValue(doc.valueAtPath(name_path));
+				BenchmarkKeepValue(doc.valueAtPath(ratio_path));
+			}
+		}
+		
+		void benchStreamParser(size_t iterations)
+		{
+			// The document is received in 4KB chunks, and the values are built into DOM
+			const size_t chunk_size = 4096;
+			JSONStreamParser parser([](JSONValue && value) -> bool {
+				BenchmarkKeepValue(value);
+				return true;
+			});
+			for (size_t i = 0; i < iterations; i++) {
+				parser.reset();
+				for (size_t offset = 0; offset < _document.size(); offset += chunk_size) {
+					parser.feed(ByteRange(_document.data() + offset, std::min(chunk_size, _document.size() - offset)));
+				}
+				parser.finish();
+			}
+		}
+	};
+	
+	CC7_CREATE_BENCHMARK(tt7JSONBenchmarks, "test")
+	
+} // cc7::tests
+} // cc7
@@ -16,7 +16,14 @@
 
 #include <cc7tests/CC7Tests.h>
 #include <cc7tests/JSONReader.h>
+#include <cc7tests/JSONDocument.h>
 #include <cc7tests/TestDirectory.h>
+#include <cc7tests/detail/StringUtils.h>
+#include <cc7tests/detail/JSONNumber.h>
+#include <type_traits>
+#include <math.h>
+#include <string.h>
+#include <locale.h>
 
 namespace cc7
 {
@@ -34,6 +41,17 @@ namespace tests
 			CC7_REGISTER_TEST_METHOD(testSimpleJsonString)
 			CC7_REGISTER_TEST_METHOD(testSimpleJsonFile)
 			CC7_REGISTER_TEST_METHOD(testComplexJson)
+			CC7_REGISTER_TEST_METHOD(testMoveSemantics)
+			CC7_REGISTER_TEST_METHOD(testDocument)
+			CC7_REGISTER_TEST_METHOD(testHandler)
+			CC7_REGISTER_TEST_METHOD(testLongTokens)
+			CC7_REGISTER_TEST_METHOD(testNumbers)
+			CC7_REGISTER_TEST_METHOD(testNumbersLocale)
+			CC7_REGISTER_TEST_METHOD(testPath)
+			CC7_REGISTER_TEST_METHOD(testFlatObject)
+			CC7_REGISTER_TEST_METHOD(testInlineStorage)
+			CC7_REGISTER_TEST_METHOD(testLazyDocument)
+			CC7_REGISTER_TEST_METHOD(testStreamParser)
 			
 			loadJsonData();
 		}
@@ -150,6 +168,670 @@ namespace tests
 				ccstAssertEqual(our_name, exp_name);
 			}
 		}
+		
+		void testMoveSemantics()
+		{
+			// std::vector must move values during reallocation
+			static_assert(std::is_nothrow_move_constructible<JSONValue>::value, "JSONValue must have noexcept move constructor");
+			static_assert(std::is_nothrow_move_assignable<JSONValue>::value, "JSONValue must have noexcept move assignment");
+			
+			JSONValue a(JSONValue::Array);
+			a.asMutableArray().emplace_back(JSONValue((int64_t)1));
+			JSONValue b(std::move(a));
+			ccstAssertFalse(a.isValid());
+			ccstAssertEqual(b.asArray().size(), 1);
+			b = JSONValue(true);
+			ccstAssertTrue(b.asBoolean());
+			
+			// Parse into already filled value
+			JSONValue root;
+			ccstAssertTrue(JSON_ParseString(_json1, root));
+			ccstAssertTrue(JSON_ParseString("{\"a\":{\"b\":{\"c\":[1,{\"d\":\"deep\"}]}},\"k\":1,\"k\":2}", root));
+			ccstAssertEqual(root.arrayAtPath("a.b.c").at(1).stringAtPath("d"), "deep");
+			// The last duplicate key wins
+			ccstAssertEqual(root.integerAtPath("k"), 2);
+		}
+		
+		void testDocument()
+		{
+			JSONDocument doc;
+			std::string error;
+			bool result = doc.parse(cc7::MakeRange(_json1), &error);
+			if (!result) {
+				ccstFailure("Parser failed with error: %s", error.c_str());
+				return;
+			}
+			// The document must be equal to the regular DOM
+			simpleJsonValidation(doc.root().toValue());
+			
+			const JSONNode & root = doc.root();
+			ccstAssertEqual(root.size(), 6);
+			ccstAssertEqual(root.keyAt(0).asString(), "key1");
+			ccstAssertEqual(root.valueAtPath("object.zzz.integer").asInteger(), 64);
+			ccstAssertEqual(root.valueAtPath("array").at(4).valueAt(0).size(), 4);
+			ccstAssertTrue(root.find("missing") == nullptr);
+			
+			// Strings without escaped characters point to the parsed data
+			const cc7::byte * begin = reinterpret_cast<const cc7::byte*>(_json1.data());
+			const cc7::byte * end   = begin + _json1.size();
+			cc7::ByteRange value1 = root.valueAtPath("key1", JSONValue::String).asRange();
+			ccstAssertTrue(value1.data() >= begin && value1.data() < end);
+			cc7::ByteRange unicode2 = root.valueAtPath("object.zzz.unicode2", JSONValue::String).asRange();
+			ccstAssertFalse(unicode2.data() >= begin && unicode2.data() < end);
+			ccstAssertEqual(root.valueAtPath("object.zzz.unicode2").asString(), root.valueAtPath("object.zzz.unicode1").asString());
+			
+			// Errors and empty documents
+			ccstAssertFalse(doc.parse(cc7::MakeRange("{\"a\":[1,2}"), &error));
+			ccstAssertFalse(doc.root().isValid());
+			ccstAssertTrue(doc.parse(cc7::MakeRange("  ")));
+			ccstAssertTrue(doc.root().isNull());
+			
+			// Only the arena blocks are allocated
+			std::string big_document("[");
+			for (int i = 0; i < 1000; i++) {
+				big_document.append(i > 0 ? "," : "").append("{\"id\":1,\"name\":\"name\"}");
+			}
+			big_document.append("]");
+			ccstAssertTrue(doc.parse(cc7::MakeRange(big_document)));
+			ccstAssertMaxAllocations(doc.parse(cc7::MakeRange(big_document)), 32);
+			ccstAssertEqual(doc.root().size(), 1000);
+			ccstAssertEqual(doc.root().at(999).valueAtPath("name").asString(), "name");
+		}
+		
+		struct EventsRecorder : public JSONHandler
+		{
+			std::string events;
+			size_t views_count = 0;
+			size_t stop_after = 0;
+			const cc7::ByteRange * data = nullptr;
+			
+			bool record(const std::string & event)
+			{
+				events.append(event).append(" ");
+				return stop_after == 0 || events.size() < stop_after;
+			}
+			bool recordString(const char * prefix, const cc7::ByteRange & str)
+			{
+				if (str.data() >= data->data() && str.data() < data->data() + data->size()) {
+					views_count++;
+				}
+				return record(prefix + std::string(reinterpret_cast<const char*>(str.data()), str.size()));
+			}
+			
+			bool startObject() override							{ return record("{"); }
+			bool key(const cc7::ByteRange & key) override			{ return recordString("k:", key); }
+			bool endObject(size_t count) override					{ return record("}" + std::to_string(count)); }
+			bool startArray() override							{ return record("["); }
+			bool endArray(size_t count) override					{ return record("]" + std::to_string(count)); }
+			bool stringValue(const cc7::ByteRange & value) override	{ return recordString("s:", value); }
+			bool integerValue(int64_t value) override				{ return record("i:" + std::to_string(value)); }
+			bool doubleValue(double value) override				{ return record("d:" + std::to_string(value)); }
+			bool booleanValue(bool value) override				{ return record(value ? "true" : "false"); }
+			bool nullValue() override								{ return record("null"); }
+		};
+		
+		void testHandler()
+		{
+			std::string json("{\"a\":[1,2.5,\"x\\ny\"],\"b\":{\"c\":true,\"d\":null},\"e\":false}");
+			cc7::ByteRange data(json);
+			EventsRecorder recorder;
+			recorder.data = &data;
+			std::string error;
+			ccstAssertTrue(JSON_ParseData(data, recorder, &error));
+			ccstAssertEqual(recorder.events, "{ k:a [ i:1 d:2.500000 s:x\ny ]3 k:b { k:c true k:d null }2 k:e false }3 ");
+			// All keys are views, the escaped string is not
+			ccstAssertEqual(recorder.views_count, 5);
+			
+			// Handler can stop the parsing
+			EventsRecorder stopping;
+			stopping.data = &data;
+			stopping.stop_after = 10;
+			ccstAssertFalse(JSON_ParseData(data, stopping, &error));
+			ccstAssertTrue(error.find("stopped by the handler") != std::string::npos);
+			
+			// The same error reporting as in DOM parser
+			EventsRecorder invalid;
+			invalid.data = &data;
+			ccstAssertFalse(JSON_ParseData(cc7::MakeRange("[1,2"), invalid, &error));
+			ccstAssertEqual(error, "JSON parser error: Unexpected end of array (line 1, offset 4)");
+		}
+		
+		void testLongTokens()
+		{
+			// Strings and whitespaces longer than one vector register, with special
+			// characters at all positions.
+			for (size_t length = 0; length < 40; length++) {
+				for (size_t pos = 0; pos <= length; pos++) {
+					std::string str(length, 'x');
+					std::string expected = str;
+					str.insert(pos, "\\\"");
+					expected.insert(pos, "\"");
+					std::string json = std::string(length, ' ') + "[\"" + str + "\"," + std::string(pos, '\t') + "\"\xC4\xBD" + std::string(length, 'y') + "\"]";
+					JSONValue root;
+					std::string error;
+					bool result = JSON_ParseString(json, root, &error);
+					ccstAssertTrue(result, "Length %d, pos %d: %s", (int)length, (int)pos, error.c_str());
+					if (result) {
+						ccstAssertEqual(root.asArray().at(0).asString(), expected);
+						ccstAssertEqual(root.asArray().at(1).asString(), "\xC4\xBD" + std::string(length, 'y'));
+					}
+					// Control character
+					std::string invalid = "\"" + std::string(length, 'x') + "\"";
+					invalid.insert(pos + 1, "\x1F");
+					ccstAssertFalse(JSON_ParseString(invalid, root, &error));
+					ccstAssertEqual(error, detail::FormattedString("JSON parser error: Unexpected control character in string (line 1, offset %d)", (int)pos + 2));
+				}
+			}
+			// Lines are counted in the long whitespace sequences
+			std::string error;
+			JSONValue root;
+			std::string json = "[\n" + std::string(20, ' ') + "1,\r\n  \t\t" + std::string(33, ' ') + "\n\n" + std::string(17, ' ') + "2,\n" + std::string(18, ' ') + "x]";
+			ccstAssertFalse(JSON_ParseString(json, root, &error));
+			ccstAssertEqual(error, "JSON parser error: Unexpected character in value (line 6, offset 20)");
+			// Unterminated long string
+			ccstAssertFalse(JSON_ParseString("\"" + std::string(50, 'x'), root, &error));
+		}
+		
+		bool parseNumber(const std::string & str, detail::JSONNumber & number)
+		{
+			return detail::ParseJSONNumber(reinterpret_cast<const cc7::byte*>(str.data()), str.size(), number) == str.size();
+		}
+		
+		void testNumbers()
+		{
+			detail::JSONNumber number;
+			// Integers
+			ccstAssertTrue(parseNumber("0", number) && !number.is_double && number.integer_value == 0);
+			ccstAssertTrue(parseNumber("-17", number) && !number.is_double && number.integer_value == -17);
+			ccstAssertTrue(parseNumber("9223372036854775807", number) && number.integer_value == INT64_MAX);
+			ccstAssertTrue(parseNumber("-9223372036854775808", number) && number.integer_value == INT64_MIN);
+			ccstAssertFalse(parseNumber("9223372036854775808", number));
+			ccstAssertFalse(parseNumber("-9223372036854775809", number));
+			ccstAssertFalse(parseNumber("123456789012345678901", number));
+			// Invalid numbers
+			const char * invalid[] = { "-", "1.", "1e", "1e+", "1.2.3", "1e5e5", "--1", "1-", "1e400", "-1e400" };
+			for (auto && str : invalid) {
+				ccstAssertFalse(parseNumber(str, number), "Number %s", str);
+			}
+			// Doubles must be equal to strtod()
+			const char * doubles[] = {
+				"0.0", "-0.0", "1.5", "0.1", "3.14159", "1e10", "1E-5", "-2.5e+3", "123456.789e3",
+				"9007199254740993.0", "9007199254740995.0", "1e23", "8.41e21", "5e-324", "4.9e-324", "2e-324",
+				"2.2250738585072011e-308", "2.2250738585072014e-308", "1.7976931348623157e308",
+				"1e-400", "0.000000000000000000000000000001234", "7.2057594037927933e16",
+				"3.14159265358979323846264338327950288419716939937510", "2.00000000000000011102230246251565404236316680908203125",
+				"2.00000000000000011102230246251565404236316680908203124", "2.00000000000000011102230246251565404236316680908203126",
+				"1234567890123456789012345678901234567890e-20", "0.30000000000000004",
+			};
+			for (auto && str : doubles) {
+				bool result = parseNumber(str, number);
+				ccstAssertTrue(result && number.is_double, "Number %s", str);
+				double expected = strtod(str, nullptr);
+				ccstAssertTrue(memcmp(&expected, &number.double_value, sizeof(double)) == 0, "Number %s: %.17g != %.17g", str, number.double_value, expected);
+			}
+			// Random doubles, formatted with various precisions
+			cc7::U64 seed = 0x12345678;
+			for (int i = 0; i < 10000; i++) {
+				seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+				cc7::U64 bits = seed & 0x7FFFFFFFFFFFFFFFULL;
+				double value;
+				memcpy(&value, &bits, sizeof(value));
+				if (value != value || value == HUGE_VAL) {
+					continue;
+				}
+				int precision = (i & 1) ? 17 : 1 + (int)(seed >> 60);
+				std::string str = detail::FormattedString("%.*g", precision, value);
+				if (str.find_first_of(".e") == std::string::npos) {
+					str.append(".0");
+				}
+				double expected = strtod(str.c_str(), nullptr);
+				bool result = parseNumber(str, number);
+				ccstAssertTrue(result && memcmp(&expected, &number.double_value, sizeof(double)) == 0, "Number %s", str.c_str());
+			}
+		}
+		
+		void testNumbersLocale()
+		{
+			// Numbers with more than 19 significant digits are parsed by the slow path.
+			std::vector<std::string> numbers = {
+				"3.14159265358979323846264338327950288419716939937510",
+				"2.00000000000000011102230246251565404236316680908203125",
+				"-0.000000000000000000000000000000000000000000000000000000000000000000000000001234567890123456789012e-10",
+				"0." + std::string(150, '0') + "12345678901234567890123",
+				"1" + std::string(200, '0') + ".5e-150",
+				// The halfway case, decided by the last digit after 800 digits
+				"1.00000000000000011102230246251565404236316680908203125" + std::string(800, '0') + "1",
+			};
+			std::vector<double> expected;
+			for (auto && str : numbers) {
+				expected.push_back(strtod(str.c_str(), nullptr));
+			}
+			ccstAssertTrue(expected.back() > 1.0);
+			// Switch to locale with decimal comma, if available.
+			const char * locales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "cs_CZ.UTF-8", "fr_FR.UTF-8", "German_Germany.1252" };
+			std::string old_locale(setlocale(LC_NUMERIC, nullptr));
+			const char * locale = nullptr;
+			for (auto && name : locales) {
+				if (setlocale(LC_NUMERIC, name) && localeconv()->decimal_point[0] == ',') {
+					locale = name;
+					break;
+				}
+			}
+			if (!locale) {
+				setlocale(LC_NUMERIC, old_locale.c_str());
+				ccstMessage("No locale with decimal comma is available. Numbers are tested in \"%s\" locale.", old_locale.c_str());
+			}
+			for (size_t i = 0; i < numbers.size(); i++) {
+				detail::JSONNumber number;
+				bool result = parseNumber(numbers[i], number);
+				ccstAssertTrue(result && number.is_double && memcmp(&expected[i], &number.double_value, sizeof(double)) == 0,
+							   "Number %s in %s locale", numbers[i].c_str(), locale ? locale : old_locale.c_str());
+				JSONValue value;
+				ccstAssertTrue(JSON_ParseString("[" + numbers[i] + "]", value));
+				ccstAssertTrue(value.isType(JSONValue::Array) && value.asArray().size() == 1 && value.asArray()[0].asDouble() == expected[i]);
+			}
+			setlocale(LC_NUMERIC, old_locale.c_str());
+		}
+		
+		bool isInvalidPath(const std::string & path)
+		{
+			try {
+				JSONPath compiled(path);
+			} catch (std::invalid_argument & exc) {
+				return true;
+			}
+			return false;
+		}
+		
+		void testPath()
+		{
+			JSONValue root;
+			ccstAssertTrue(JSON_ParseString(_json1, root));
+			
+			// Compilation
+			JSONPath path("array[4].sub-array[2]");
+			ccstAssertEqual(path.path(), "array[4].sub-array[2]");
+			ccstAssertEqual(path.size(), 4);
+			ccstAssertEqual(JSONPath("a..b.").size(), 2);
+			ccstAssertEqual(JSONPath("[1][2]").size(), 2);
+			ccstAssertTrue(isInvalidPath(""));
+			ccstAssertTrue(isInvalidPath("..."));
+			ccstAssertTrue(isInvalidPath("a[]"));
+			ccstAssertTrue(isInvalidPath("a[x]"));
+			ccstAssertTrue(isInvalidPath("a[1"));
+			ccstAssertTrue(isInvalidPath("a[1]b"));
+			
+			// Evaluation
+			ccstAssertEqual(path.evaluate(root).asInteger(), 3);
+			ccstAssertEqual(root.valueAtPath(path, JSONValue::Integer).asInteger(), 3);
+			ccstAssertEqual(root.stringAtPath("array[1]"), "b");
+			ccstAssertEqual(root.doubleAtPath("array[5].sub-array[3]"), 4.4);
+			ccstAssertEqual(root.integerAtPath("object.zzz.integer"), 64);
+			ccstAssertTrue(JSONPath("array[7]").find(root) == nullptr);
+			ccstAssertTrue(JSONPath("key1.x").find(root) == nullptr);
+			ccstAssertTrue(JSONPath("object[0]").find(root) == nullptr);
+			ccstAssertTrue(JSONPath("missing").find(root) == nullptr);
+			try {
+				root.valueAtPath("object.missing");
+				ccstFailure("valueAtPath() must raise exception.");
+			} catch (std::invalid_argument & exc) {
+				ccstAssertTrue(strstr(exc.what(), "missing") != nullptr);
+			}
+			
+			// Arrays at root
+			JSONValue array;
+			ccstAssertTrue(JSON_ParseString("[[1,2],[3,{\"x\":4}]]", array));
+			ccstAssertEqual(array.integerAtPath("[1][1].x"), 4);
+			
+			// The same paths work with JSONDocument
+			JSONDocument doc;
+			ccstAssertTrue(doc.parse(cc7::MakeRange(_json1)));
+			ccstAssertEqual(path.evaluate(doc.root()).asInteger(), 3);
+			ccstAssertEqual(doc.root().valueAtPath("array[1]").asString(), "b");
+			ccstAssertTrue(JSONPath("array[7]").find(doc.root()) == nullptr);
+			
+			// Evaluation of compiled and cached path doesn't allocate
+			const JSONValue * selected = nullptr;
+			ccstAssertNoAllocations(selected = &path.evaluate(root));
+			const std::string key = "array[4].sub-array[2]";
+			root.valueAtPath(key);
+			ccstAssertNoAllocations(selected = &root.valueAtPath(key));
+			ccstAssertEqual(selected->asInteger(), 3);
+			const std::string double_key = "object.zzz.double";
+			root.doubleAtPath(double_key);
+			ccstAssertNoAllocations(root.doubleAtPath(double_key));
+			
+			// Decoding of string at path allocates only the result
+			JSONValue encoded(JSONValue::Object);
+			encoded.asMutableObject()["hex"].assign(std::string(200, 'a'));
+			encoded.asMutableObject()["base64"].assign(std::string(200, 'A'));
+			const std::string hex_key = "hex";
+			const std::string base64_key = "base64";
+			encoded.stringAtPath(hex_key);
+			encoded.stringAtPath(base64_key);
+			cc7::ByteArray decoded;
+			ccstAssertMaxAllocations(decoded = encoded.dataFromHexStringAtPath(hex_key), 1);
+			ccstAssertEqual(decoded.size(), 100);
+			ccstAssertMaxAllocations(decoded = encoded.dataFromBase64StringAtPath(base64_key), 1);
+			ccstAssertEqual(decoded.size(), 150);
+			
+			// The cache is bounded, the paths are still correct after eviction
+			for (int i = 0; i < 100; i++) {
+				std::string index_path = detail::FormattedString("array[%d]", i % 7);
+				ccstAssertTrue(root.valueAtPath(index_path).isValid());
+			}
+			ccstAssertEqual(root.stringAtPath("array[2]"), "c");
+		}
+		
+		void testFlatObject()
+		{
+			// std::map compatible interface
+			JSONValue value(JSONValue::Object);
+			JSONValue::TObject & object = value.asMutableObject();
+			object["b"] = JSONValue((int64_t)2);
+			object["a"] = JSONValue((int64_t)1);
+			ccstAssertTrue(object.emplace("c", JSONValue((int64_t)3)).second);
+			ccstAssertFalse(object.emplace("c", JSONValue((int64_t)4)).second);
+			ccstAssertTrue(object.insert(std::make_pair(std::string("d"), JSONValue(true))).second);
+			ccstAssertEqual(object.size(), 4);
+			ccstAssertEqual(object.count("c"), 1);
+			ccstAssertEqual(object.count("x"), 0);
+			ccstAssertTrue(object.find("x") == object.end());
+			ccstAssertEqual(object.find("b")->second.asInteger(), 2);
+			ccstAssertEqual(object.at("c").asInteger(), 3);
+			ccstAssertEqual(object.erase("d"), 1);
+			ccstAssertEqual(object.erase("d"), 0);
+			// Iteration is ordered by key
+			std::string keys;
+			for (auto && member : value.asObject()) {
+				keys.append(member.first);
+			}
+			ccstAssertEqual(keys, "abc");
+			
+			// Parsed object is sorted and the last duplicate key wins
+			JSONValue root;
+			ccstAssertTrue(JSON_ParseString("{\"z\":1,\"y\":2,\"z\":3,\"x\":4,\"y\":5}", root));
+			ccstAssertEqual(JSON_Serialize(root), "{\"x\":4,\"y\":5,\"z\":3}");
+			
+			// Large objects use a different sort
+			std::string big_object("{");
+			for (int i = 99; i >= 0; i--) {
+				big_object.append(detail::FormattedString("\"k%02d\":%d,\"k%02d\":%d,", i, i, i, i * 2));
+			}
+			big_object.back() = '}';
+			ccstAssertTrue(JSON_ParseString(big_object, root));
+			ccstAssertEqual(root.asObject().size(), 100);
+			ccstAssertEqual(root.asObject().begin()->first, "k00");
+			ccstAssertEqual(root.integerAtPath("k42"), 84);
+			
+			// All members are stored in one block
+			JSONValue::TObject flat;
+			ccstAssertMaxAllocations({
+				flat.reserve(5);
+				flat.appendUnsorted("id", JSONValue((int64_t)1));
+				flat.appendUnsorted("name", JSONValue(JSONValue::Null));
+				flat.appendUnsorted("enabled", JSONValue(true));
+				flat.appendUnsorted("ratio", JSONValue(1.5));
+				flat.appendUnsorted("child", JSONValue(JSONValue::Null));
+				flat.sortMembers();
+			}, 1);
+			ccstAssertEqual(flat.begin()->first, "child");
+		}
+		
+		void testInlineStorage()
+		{
+			ccstAssertEqual(sizeof(JSONValue), 16);
+			
+			// Short strings and empty containers need no allocation
+			ccstAssertNoAllocations({
+				JSONValue str(JSONValue::String);
+				str.assign("short");
+				JSONValue copy(str);
+				JSONValue moved(std::move(copy));
+				JSONValue array(JSONValue::Array);
+				JSONValue object(JSONValue::Object);
+				object = std::move(array);
+			});
+			
+			// Changing value to the same type keeps the content's storage
+			JSONValue value;
+			value.assign(std::string(100, 'x'));
+			ccstAssertNoAllocations(value.assign(std::string("also short")));
+			ccstAssertEqual(value.asString(), "also short");
+			ccstAssertTrue(value.asString() != "short");
+			ccstAssertTrue(value.asString() != std::string("short"));
+			ccstAssertEqual(value.asString() + "!", "also short!");
+			ccstAssertEqual("(" + value.asString() + ")", "(also short)");
+			
+			// Long string reuses its block, even for its own characters
+			const std::string long_string(100, 'x');
+			value.assign(long_string);
+			ccstAssertNoAllocations(value.assign(long_string.data(), 50));
+			ccstAssertEqual(value.asString(), long_string.substr(0, 50));
+			ccstAssertNoAllocations(value.assign(value.asString().data() + 1, 20));
+			ccstAssertEqual(value.asString().size(), 20);
+			ccstAssertNoAllocations(value.assign(value.asString().data() + 1, 10));
+			ccstAssertEqual(value.asString(), "xxxxxxxxxx");
+			value.assign((int64_t)1);
+			ccstAssertEqual(value.asInteger(), 1);
+			
+			// Moved out value is NaT
+			JSONValue source(JSONValue::Array);
+			source.asMutableArray().emplace_back(true);
+			JSONValue target(std::move(source));
+			ccstAssertFalse(source.isValid());
+			ccstAssertEqual(target.asArray().size(), 1);
+			
+			// Parsed array of short strings allocates only its blocks, not the strings
+			std::string doc("[");
+			for (int i = 0; i < 1000; i++) {
+				doc.append(i > 0 ? "," : "").append(detail::FormattedString("\"s%d\"", i));
+			}
+			doc.append(",[],{}]");
+			JSONValue root;
+			ccstAssertTrue(JSON_ParseString(doc, root));
+			ccstAssertMaxAllocations(JSON_ParseString(doc, root), 50);
+			ccstAssertEqual(root.asArray().size(), 1002);
+			ccstAssertEqual(root.stringAtPath("[999]"), "s999");
+		}
+		
+		void testLazyDocument()
+		{
+			JSONLazyDocument doc(cc7::MakeRange(_json1));
+			ccstAssertEqual(doc.parsedValuesCount(), 0);
+			ccstAssertEqual(doc.scannedContainersCount(), 0);
+			
+			// Only containers on the path are scanned
+			ccstAssertEqual(doc.integerAtPath("object.zzz.integer"), 64);
+			ccstAssertEqual(doc.scannedContainersCount(), 3);
+			ccstAssertEqual(doc.parsedValuesCount(), 1);
+			ccstAssertEqual(doc.stringAtPath("object.zzz.unicode2"), u8"Ľalie poľné");
+			ccstAssertEqual(doc.doubleAtPath("array[6].sub-array[3]"), 0.32);
+			ccstAssertEqual(doc.stringAtPath("array[2]"), "c");
+			ccstAssertEqual(doc.booleanAtPath("true"), true);
+			ccstAssertTrue(doc.valueAtPath("empty").isNull());
+			ccstAssertEqual(doc.objectAtPath("object").size(), 3);
+			ccstAssertEqual(doc.arrayAtPath("array[4].sub-array").size(), 4);
+			ccstAssertTrue(doc.find(JSONPath("array[7]")) == nullptr);
+			ccstAssertTrue(doc.find(JSONPath("key1.x")) == nullptr);
+			ccstAssertTrue(doc.find(JSONPath("missing")) == nullptr);
+			try {
+				doc.valueAtPath("object.missing");
+				ccstFailure("valueAtPath() must raise exception.");
+			} catch (std::invalid_argument & exc) {
+				ccstAssertTrue(strstr(exc.what(), "missing") != nullptr);
+			}
+			
+			// Already parsed values are cached
+			const size_t parsed_count = doc.parsedValuesCount();
+			const std::string key = "object.zzz.double";
+			ccstAssertEqual(doc.doubleAtPath(key), 6.4);
+			ccstAssertNoAllocations(doc.doubleAtPath(key));
+			ccstAssertEqual(doc.parsedValuesCount(), parsed_count + 1);
+			
+			// The whole document is equal to fully parsed one
+			JSONValue full;
+			ccstAssertTrue(JSON_ParseString(_json1, full));
+			ccstAssertEqual(JSON_Serialize(doc.root()), JSON_Serialize(full));
+			
+			// Duplicate and escaped keys, root array
+			std::string duplicates("[{\"a\":1,\"a\":2,\"b\\u0031\":\"x\"}]");
+			doc.load(cc7::MakeRange(duplicates));
+			ccstAssertEqual(doc.parsedValuesCount(), 0);
+			ccstAssertEqual(doc.integerAtPath("[0].a"), 2);
+			ccstAssertEqual(doc.stringAtPath("[0].b1"), "x");
+			
+			// Invalid parts are reported only when they're touched
+			std::string invalid("{\"good\":[1, 2], \"bad\":{\"x\":tru}, \"broken\":[1 2]}");
+			doc.load(cc7::MakeRange(invalid));
+			ccstAssertEqual(doc.integerAtPath("good[1]"), 2);
+			ccstAssertTrue(isInvalidLazyPath(doc, "bad.x"));
+			ccstAssertTrue(isInvalidLazyPath(doc, "broken[1]"));
+			ccstAssertTrue(isInvalidLazyPath(doc, ""));
+			std::string truncated("{\"a\":[1,{\"b\":\"]}\"}");
+			doc.load(cc7::MakeRange(truncated));
+			ccstAssertTrue(isInvalidLazyPath(doc, "a"));
+			std::string trailing("[1] 2");
+			doc.load(cc7::MakeRange(trailing));
+			ccstAssertTrue(isInvalidLazyPath(doc, ""));
+			
+			// Empty document has null at root
+			doc.load(cc7::ByteRange());
+			ccstAssertTrue(doc.root().isNull());
+			ccstAssertTrue(doc.find(JSONPath("a")) == nullptr);
+		}
+		
+		bool parseInChunks(const std::string & json, size_t chunk_size, JSONValue & out_value, std::string * out_error = nullptr)
+		{
+			JSONStreamParser parser([&out_value](JSONValue && value) -> bool {
+				out_value = std::move(value);
+				return true;
+			});
+			bool result = true;
+			for (size_t offset = 0; offset < json.size() && result; offset += chunk_size) {
+				// Each chunk is a copy, so the parser can't keep pointers to the data.
+				std::string chunk = json.substr(offset, chunk_size);
+				result = parser.feed(cc7::MakeRange(chunk));
+			}
+			result = result && parser.finish();
+			if (out_error) {
+				*out_error = parser.error();
+			}
+			return result && parser.valuesCount() == 1;
+		}
+		
+		void testStreamParser()
+		{
+			// The document split to chunks of all sizes produces the same value
+			JSONValue full;
+			ccstAssertTrue(JSON_ParseString(_json1, full));
+			const std::string expected = JSON_Serialize(full);
+			for (size_t chunk_size = 1; chunk_size <= 33; chunk_size++) {
+				JSONValue value;
+				ccstAssertTrue(parseInChunks(_json1, chunk_size, value));
+				ccstAssertEqual(JSON_Serialize(value), expected);
+			}
+			JSONValue value;
+			ccstAssertTrue(parseInChunks(_json1, _json1.size(), value));
+			ccstAssertEqual(JSON_Serialize(value), expected);
+			
+			// The same events as from the recursive parser, split at each position
+			std::string json("{\"a\":[1,2.5,\"x\\ny\",\"\\u013d\"],\"b\":{\"c\":true,\"d\":null},\"e\":-12e1}");
+			cc7::ByteRange data(json);
+			EventsRecorder expected_events;
+			expected_events.data = &data;
+			ccstAssertTrue(JSON_ParseData(data, expected_events));
+			for (size_t split = 0; split <= json.size(); split++) {
+				std::string first = json.substr(0, split);
+				std::string second = json.substr(split);
+				EventsRecorder recorder;
+				recorder.data = &data;
+				JSONStreamParser parser(recorder);
+				ccstAssertTrue(parser.feed(cc7::MakeRange(first)));
+				ccstAssertTrue(parser.feed(cc7::MakeRange(second)));
+				ccstAssertTrue(parser.finish());
+				ccstAssertEqual(recorder.events, expected_events.events);
+			}
+			
+			// Sequence of top-level values, the number at the end is completed by finish()
+			std::vector<std::string> values;
+			JSONStreamParser sequence([&values](JSONValue && value) -> bool {
+				values.push_back(JSON_Serialize(value));
+				return true;
+			});
+			ccstAssertTrue(sequence.feed(cc7::MakeRange("1 [2] {\"a\":\n3}\n\"x\" true 4")));
+			ccstAssertEqual(sequence.valuesCount(), 5);
+			ccstAssertTrue(sequence.finish());
+			ccstAssertEqual(sequence.valuesCount(), 6);
+			ccstAssertEqual(values.size(), 6);
+			ccstAssertEqual(values[2], "{\"a\":3}");
+			ccstAssertEqual(values[5], "4");
+			
+			// Errors
+			std::string error;
+			ccstAssertFalse(parseInChunks("[1,2", 1, value, &error));
+			ccstAssertEqual(error, "JSON parser error: Unexpected end of stream (line 1, offset 5)");
+			ccstAssertFalse(parseInChunks("{\n\"a\" 1}", 3, value, &error));
+			ccstAssertEqual(error, "JSON parser error: The colon ':' is expected as key-value separator (line 2, offset 5)");
+			ccstAssertFalse(parseInChunks("[tru]", 2, value, &error));
+			ccstAssertTrue(error.find("'true' token") != std::string::npos);
+			ccstAssertFalse(parseInChunks("[1 2]", 1, value, &error));
+			ccstAssertFalse(parseInChunks("[1,]", 1, value, &error));
+			ccstAssertFalse(parseInChunks("[1.2.3]", 2, value, &error));
+			ccstAssertTrue(error.find("Invalid number") != std::string::npos);
+			ccstAssertFalse(parseInChunks("\"\\u00x1\"", 4, value, &error));
+			ccstAssertFalse(parseInChunks("\"a\tb\"", 1, value, &error));
+			ccstAssertFalse(parseInChunks(std::string(20, '['), 7, value, &error));
+			ccstAssertTrue(error.find("too deep") != std::string::npos);
+			
+			// The callback can stop the parsing, and the parser ignores the rest of the stream
+			std::vector<std::string> stopped_values;
+			JSONStreamParser stopping([&stopped_values](JSONValue && value) -> bool {
+				stopped_values.push_back(JSON_Serialize(value));
+				return false;
+			});
+			ccstAssertFalse(stopping.feed(cc7::MakeRange("[1] [2]")));
+			ccstAssertTrue(stopping.error().find("stopped by the handler") != std::string::npos);
+			ccstAssertFalse(stopping.feed(cc7::MakeRange("[3]")));
+			ccstAssertEqual(stopped_values.size(), 1);
+			ccstAssertEqual(stopped_values.front(), "[1]");
+			stopping.reset();
+			ccstAssertTrue(stopping.error().empty());
+			ccstAssertTrue(stopping.feed(cc7::MakeRange("[")));
+			ccstAssertEqual(stopping.depth(), 1);
+			
+			// In the handler mode, the memory doesn't grow with the document
+			JSONHandler handler;
+			JSONStreamParser streaming(handler);
+			std::string chunk;
+			for (int i = 0; i < 100; i++) {
+				chunk.append(detail::FormattedString("{\"id\":%d,\"name\":\"name \\\"%d\\\"\",\"v\":[1.5,true,null]},", i, i));
+			}
+			ccstAssertTrue(streaming.feed(cc7::MakeRange("[")));
+			ccstAssertTrue(streaming.feed(cc7::MakeRange(chunk)));
+			ccstAssertNoAllocations({
+				for (int i = 0; i < 10; i++) {
+					streaming.feed(cc7::MakeRange(chunk));
+				}
+			});
+			ccstAssertTrue(streaming.feed(cc7::MakeRange("null]")));
+			ccstAssertTrue(streaming.finish());
+			ccstAssertEqual(streaming.valuesCount(), 1);
+		}
+		
+		bool isInvalidLazyPath(const JSONLazyDocument & doc, const std::string & path)
+		{
+			try {
+				if (path.empty()) {
+					doc.root();
+				} else {
+					doc.valueAtPath(path);
+				}
+			} catch (std::invalid_argument & exc) {
+				return true;
+			}
+			return false;
+		}
 	};
 	
 	CC7_CREATE_UNIT_TEST(tt7JSONReaderTests, "cc7 test")
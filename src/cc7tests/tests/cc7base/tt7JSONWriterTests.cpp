@@ -0,0 +1,275 @@
+/*
+ * Copyright 2017 Juraj Durech <durech.juraj@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cc7tests/CC7Tests.h>
+#include <cc7tests/JSONWriter.h>
+#include <cc7tests/detail/JSONNumber.h>
+#include <math.h>
+#include <string.h>
+#include <stdlib.h>
+
+namespace cc7
+{
+namespace tests
+{
+	class tt7JSONWriterTests : public UnitTest
+	{
+	public:
+		
+		tt7JSONWriterTests()
+		{
+			CC7_REGISTER_TEST_METHOD(testCompact)
+			CC7_REGISTER_TEST_METHOD(testPretty)
+			CC7_REGISTER_TEST_METHOD(testEscaping)
+			CC7_REGISTER_TEST_METHOD(testNumbers)
+			CC7_REGISTER_TEST_METHOD(testSink)
+			CC7_REGISTER_TEST_METHOD(testInvalidSequence)
+		}
+		
+		const char * _document =
+			"{ \"name\" : \"cc7\", \"list\" : [ 1, -2, 0.5, true, false, null, {}, [] ],"
+			"  \"nested\" : { \"a\" : [ { \"b\" : \"c\" } ] } }";
+		
+		void testCompact()
+		{
+			// Reformat with SAX, the order of members is kept
+			JSONWriter writer;
+			ccstAssertTrue(JSON_ParseData(cc7::MakeRange(_document), writer));
+			ccstAssertEqual(writer.output(), "{\"name\":\"cc7\",\"list\":[1,-2,0.5,true,false,null,{},[]],\"nested\":{\"a\":[{\"b\":\"c\"}]}}");
+			
+			// Serialize DOM, the object's members are sorted by key
+			JSONValue value;
+			ccstAssertTrue(JSON_ParseString(_document, value));
+			std::string serialized = JSON_Serialize(value);
+			ccstAssertEqual(serialized, "{\"list\":[1,-2,0.5,true,false,null,{},[]],\"name\":\"cc7\",\"nested\":{\"a\":[{\"b\":\"c\"}]}}");
+			// The output is parsed back to the same document
+			JSONValue value2;
+			ccstAssertTrue(JSON_ParseString(serialized, value2));
+			ccstAssertEqual(JSON_Serialize(value2), serialized);
+			
+			// Writer can be reused after reset
+			writer.reset();
+			ccstAssertTrue(writer.startArray());
+			ccstAssertTrue(writer.stringValue("x"));
+			ccstAssertTrue(writer.integerValue(1));
+			ccstAssertTrue(writer.endArray());
+			ccstAssertEqual(writer.output(), "[\"x\",1]");
+			
+			// Scalar documents & NaT
+			ccstAssertEqual(JSON_Serialize(JSONValue(true)), "true");
+			ccstAssertEqual(JSON_Serialize(JSONValue(JSONValue::String)), "\"\"");
+			ccstAssertEqual(JSON_Serialize(JSONValue()), "null");
+		}
+		
+		void testPretty()
+		{
+			JSONWriter writer(JSONWriter::Pretty);
+			ccstAssertTrue(JSON_ParseData(cc7::MakeRange(_document), writer));
+			const char * expected =
+				"{\n"
+				"  \"name\": \"cc7\",\n"
+				"  \"list\": [\n"
+				"    1,\n"
+				"    -2,\n"
+				"    0.5,\n"
+				"    true,\n"
+				"    false,\n"
+				"    null,\n"
+				"    {},\n"
+				"    []\n"
+				"  ],\n"
+				"  \"nested\": {\n"
+				"    \"a\": [\n"
+				"      {\n"
+				"        \"b\": \"c\"\n"
+				"      }\n"
+				"    ]\n"
+				"  }\n"
+				"}";
+			ccstAssertEqual(writer.output(), expected);
+			
+			// Pretty output is parsed back to the same document
+			JSONWriter compact;
+			ccstAssertTrue(JSON_ParseData(cc7::MakeRange(writer.output()), compact));
+			writer.reset();
+			ccstAssertTrue(JSON_ParseData(cc7::MakeRange(_document), writer));
+			JSONWriter compact2;
+			ccstAssertTrue(JSON_ParseData(cc7::MakeRange(writer.output()), compact2));
+			ccstAssertEqual(compact.output(), compact2.output());
+		}
+		
+		void testEscaping()
+		{
+			JSONWriter writer;
+			std::string str("quote\" backslash\\ slash/ \n\r\t\b\f control\x01\x1f del\x7f utf8:\xC4\xBD");
+			str.push_back(0);
+			str.append("after zero");
+			writer.stringValue(str);
+			ccstAssertEqual(writer.output(), "\"quote\\\" backslash\\\\ slash/ \\n\\r\\t\\b\\f control\\u0001\\u001f del\x7f utf8:\xC4\xBD\\u0000after zero\"");
+			
+			// Round trip
+			JSONValue value;
+			ccstAssertTrue(JSON_ParseString(writer.output(), value));
+			ccstAssertEqual(value.asString(), str);
+			
+			// Long strings are processed in chunks
+			std::string long_str;
+			std::string expected("\"");
+			for (int i = 0; i < 200; i++) {
+				long_str.append("abcdefghijklmnopqrstuvwxyz\"");
+				expected.append("abcdefghijklmnopqrstuvwxyz\\\"");
+			}
+			expected.push_back('"');
+			writer.reset();
+			writer.stringValue(long_str);
+			ccstAssertEqual(writer.output(), expected);
+			
+			// Keys are escaped too
+			writer.reset();
+			writer.startObject();
+			writer.key("a\"b");
+			writer.nullValue();
+			writer.endObject();
+			ccstAssertEqual(writer.output(), "{\"a\\\"b\":null}");
+		}
+		
+		std::string formatDouble(double value)
+		{
+			char buffer[32];
+			return std::string(buffer, detail::FormatJSONDouble(value, buffer));
+		}
+		
+		std::string formatInteger(int64_t value)
+		{
+			char buffer[20];
+			return std::string(buffer, detail::FormatJSONInteger(value, buffer));
+		}
+		
+		void testNumbers()
+		{
+			// Integers
+			ccstAssertEqual(formatInteger(0), "0");
+			ccstAssertEqual(formatInteger(7), "7");
+			ccstAssertEqual(formatInteger(-10), "-10");
+			ccstAssertEqual(formatInteger(123456789), "123456789");
+			ccstAssertEqual(formatInteger(INT64_MAX), "9223372036854775807");
+			ccstAssertEqual(formatInteger(INT64_MIN), "-9223372036854775808");
+			
+			// Doubles, always with '.' or exponent
+			ccstAssertEqual(formatDouble(0.0), "0.0");
+			ccstAssertEqual(formatDouble(-0.0), "-0.0");
+			ccstAssertEqual(formatDouble(1.0), "1.0");
+			ccstAssertEqual(formatDouble(-2.5), "-2.5");
+			ccstAssertEqual(formatDouble(0.1), "0.1");
+			ccstAssertEqual(formatDouble(0.3), "0.3");
+			ccstAssertEqual(formatDouble(100.0), "100.0");
+			ccstAssertEqual(formatDouble(0.001234), "0.001234");
+			ccstAssertEqual(formatDouble(1e-7), "1e-7");
+			ccstAssertEqual(formatDouble(1e21), "1e21");
+			ccstAssertEqual(formatDouble(1.5e300), "1.5e300");
+			ccstAssertEqual(formatDouble(5e-324), "5e-324");
+			ccstAssertEqual(formatDouble(1.7976931348623157e308), "1.7976931348623157e308");
+			
+			// Random doubles are parsed back to the same value
+			cc7::U64 seed = 0x123456789ABCDEFULL;
+			for (int i = 0; i < 10000; i++) {
+				seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+				double value;
+				memcpy(&value, &seed, sizeof(value));
+				if (!isfinite(value)) {
+					continue;
+				}
+				std::string str = formatDouble(value);
+				double parsed = strtod(str.c_str(), nullptr);
+				ccstAssertTrue(memcmp(&parsed, &value, sizeof(double)) == 0, "Number %s", str.c_str());
+			}
+			
+			// Non-finite values are written as null
+			JSONWriter writer;
+			writer.startArray();
+			writer.doubleValue(NAN);
+			writer.doubleValue(INFINITY);
+			writer.doubleValue(0.25);
+			writer.endArray();
+			ccstAssertEqual(writer.output(), "[null,null,0.25]");
+		}
+		
+		void testSink()
+		{
+			std::string expected;
+			{
+				JSONWriter writer;
+				writer.startArray();
+				for (int i = 0; i < 1000; i++) {
+					writer.integerValue(i);
+				}
+				writer.endArray();
+				expected = writer.output();
+			}
+			std::string received;
+			size_t chunks = 0;
+			JSONWriter writer([&received, &chunks](const char * data, size_t size) {
+				received.append(data, size);
+				chunks++;
+			}, JSONWriter::Compact, 256);
+			writer.startArray();
+			for (int i = 0; i < 1000; i++) {
+				writer.integerValue(i);
+				// The buffer never grows much over its size
+				ccstAssertTrue(writer.output().size() < 256);
+			}
+			writer.endArray();
+			writer.flush();
+			ccstAssertTrue(writer.output().empty());
+			ccstAssertEqual(received, expected);
+			ccstAssertTrue(chunks > 10);
+		}
+		
+		void testInvalidSequence()
+		{
+			JSONWriter writer;
+			// Key outside of object
+			ccstAssertFalse(writer.key("a"));
+			ccstAssertFalse(writer.endObject());
+			ccstAssertTrue(writer.startObject());
+			// Value without key
+			ccstAssertFalse(writer.integerValue(1));
+			ccstAssertFalse(writer.endArray());
+			ccstAssertTrue(writer.key("a"));
+			// Two keys
+			ccstAssertFalse(writer.key("b"));
+			ccstAssertFalse(writer.endObject());
+			ccstAssertTrue(writer.startArray());
+			ccstAssertFalse(writer.key("c"));
+			ccstAssertTrue(writer.endArray());
+			ccstAssertTrue(writer.endObject());
+			ccstAssertEqual(writer.output(), "{\"a\":[]}");
+			// Second top-level value
+			ccstAssertFalse(writer.integerValue(1));
+			ccstAssertFalse(writer.startArray());
+			ccstAssertEqual(writer.output(), "{\"a\":[]}");
+			// Top-level scalar
+			writer.reset();
+			ccstAssertTrue(writer.stringValue("x"));
+			ccstAssertFalse(writer.nullValue());
+			ccstAssertEqual(writer.output(), "\"x\"");
+		}
+	};
+	
+	CC7_CREATE_UNIT_TEST(tt7JSONWriterTests, "cc7 test")
+	
+} // cc7::tests
+} // cc7
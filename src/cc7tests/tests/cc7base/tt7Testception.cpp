@@ -16,6 +16,8 @@
 
 #include <cc7tests/CC7Tests.h>
 #include <cc7tests/detail/StringUtils.h>
+#include <atomic>
+#include <thread>
 
 namespace cc7
 {
@@ -48,7 +50,7 @@ namespace tests
 			ccstFailure("No test methods, tearDown must not be called");
 		}
 	};
-	CC7_CREATE_UNIT_TEST(UT_Success2, "success group1")
+	CC7_CREATE_UNIT_TEST(UT_Success2, "success group1 serial")
 
 	
 	class UT_Success3 : public UnitTest
@@ -188,6 +190,9 @@ namespace tests
 			CC7_REGISTER_TEST_METHOD(positiveTests);
 			CC7_REGISTER_TEST_METHOD(negativeTests);
 			CC7_REGISTER_TEST_METHOD(filterTests);
+			CC7_REGISTER_TEST_METHOD(parallelTests);
+			CC7_REGISTER_TEST_METHOD(concurrentLogging);
+			CC7_REGISTER_TEST_METHOD(logSink);
 		}
 		
 		~tt7Testception()
@@ -365,9 +370,164 @@ namespace tests
 				dumpCollectedLog();
 			}
 		}
+		
+		void parallelTests()
+		{
+			_manager->setParallelExecutionEnabled(true);
+			_manager->setParallelWorkersCount(3);
+			
+			bool result = _manager->runAllTests();
+			ccstAssertFalse(result);
+			
+			ccstAssertTrue((size_t)_manager->tl().logDataCounters().executed_tests == _positive_count + _negative_count);
+			ccstAssertTrue((size_t)_manager->tl().logDataCounters().passed_tests == _positive_count);
+			ccstAssertTrue((size_t)_manager->tl().logDataCounters().failed_tests  == _negative_count);
+			ccstAssertTrue(_manager->tl().logDataCounters().skipped_tests == 0);
+			ccstAssertTrue(_manager->tl().logDataCounters().incidents_count > 0);
+			
+			// The log must contain tests in order of registration
+			std::string log = _manager->tl().logData().log;
+			size_t count = _positive_count + _negative_count;
+			size_t last_pos = 0;
+			for (size_t i = 0; i < count; i++) {
+				std::string start_line = detail::FormattedString("Test [ %d / %d ] ::: ", (int)i + 1, (int)count);
+				size_t pos = log.find(start_line);
+				ccstAssertTrue(pos != log.npos && pos >= last_pos, "Wrong order of '%s'", start_line.c_str());
+				last_pos = pos;
+			}
+			
+			result = _manager->runTestsWithFilter("success", "");
+			ccstAssertTrue(result);
+			ccstAssertTrue((size_t)_manager->tl().logDataCounters().passed_tests  == _positive_count);
+			ccstAssertTrue((size_t)_manager->tl().logDataCounters().skipped_tests == _negative_count);
+			
+			if (!result) {
+				dumpCollectedLog();
+			}
+		}
+		
+		void concurrentLogging()
+		{
+			const int threads_count = 4;
+			const int messages_count = 500;
+			TestLog log;
+			log.logMessage("begin");
+			std::vector<std::thread> threads;
+			std::atomic<int> finished(0);
+			for (int t = 0; t < threads_count; t++) {
+				threads.push_back(std::thread([&log, &finished, t, messages_count]() {
+					for (int i = 0; i < messages_count; i++) {
+						log.logFormattedMessage("T%d M%d", t, i);
+						if (i % 100 == 0) {
+							// The same location is reported only once
+							log.logIncident(__FILE__, __LINE__, nullptr, "T%d", t);
+						}
+					}
+					log.addPassedTest();
+					finished++;
+				}));
+			}
+			// Merge buffers while other threads are still logging
+			while (finished.load() < threads_count) {
+				log.flush();
+			}
+			for (auto && thread : threads) {
+				thread.join();
+			}
+			log.logMessage("end");
+			
+			TestLogData data = log.logData();
+			ccstAssertEqual(data.c.passed_tests, threads_count);
+			ccstAssertEqual(data.c.incidents_count, threads_count * messages_count / 100);
+			ccstAssertEqual(data.incidents.find("FAIL: "), 0);
+			ccstAssertEqual(data.incidents.find("FAIL: ", 1), std::string::npos);
+			
+			auto lines = detail::SplitString(data.log, '\n');
+			ccstAssertEqual(lines.front(), "begin");
+			ccstAssertEqual(lines.back(), "end");
+			// Messages from each thread must be in the original order
+			std::vector<int> next_message(threads_count, 0);
+			int total = 0;
+			for (auto && line : lines) {
+				int t, i;
+				if (sscanf(line.c_str(), "T%d M%d", &t, &i) == 2) {
+					ccstAssertTrue(t >= 0 && t < threads_count && next_message[t] == i, "Unexpected line %s", line.c_str());
+					if (t >= 0 && t < threads_count) {
+						next_message[t] = i + 1;
+					}
+					total++;
+				}
+			}
+			ccstAssertEqual(total, threads_count * messages_count);
+			
+			// Merged content is not lost
+			log.logMessage("after");
+			ccstAssertEqual(log.logData().log, data.log + "after\n");
+			// Reading of merged log creates no copy
+			ccstAssertNoAllocations(log.logData());
+			log.clearLogData();
+			ccstAssertEqual(log.logData().log, "");
+			ccstAssertEqual(log.logDataCounters().incidents_count, 0);
+		}
+		
+		void logSink()
+		{
+			std::string output;
+			TestLog log;
+			log.logMessage("memory");
+			log.setSink(TestLogSink::createCallbackSink([&output](const char * data, size_t size) {
+				output.append(data, size);
+			}, 64));
+			log.logMessage("sink");
+			log.logIncident(__FILE__, __LINE__, nullptr, "incident");
+			log.flush();
+			
+			// Messages logged before the sink is set stay in the memory
+			TestLogData data = log.logData();
+			ccstAssertEqual(data.log, "memory\n");
+			ccstAssertTrue(data.incidents.find("incident") != std::string::npos);
+			ccstAssertEqual(data.c.incidents_count, 1);
+			ccstAssertTrue(output.find("sink\n") == 0);
+			ccstAssertTrue(output.find("incident") != std::string::npos);
+			
+			// Big amount of messages is streamed without explicit flush
+			output.clear();
+			const std::string line(100, 'x');
+			for (int i = 0; i < 1000; i++) {
+				log.logMessage(line);
+			}
+			ccstAssertTrue(output.length() > 0);
+			log.setSink(nullptr);
+			ccstAssertEqual(output.length(), 1000 * (line.length() + 1));
+			ccstAssertEqual(log.logData().log, "memory\n");
+			
+			// takeLogData() moves the content out of the log
+			data = log.takeLogData();
+			ccstAssertEqual(data.log, "memory\n");
+			ccstAssertEqual(data.c.incidents_count, 1);
+			ccstAssertEqual(log.logData().log, "");
+			
+			// Incident locations are compared by the file name, not by the pointer
+			TestLog locations_log;
+			const std::string file_copy(__FILE__);
+			locations_log.logIncident(__FILE__, 1, nullptr, "first");
+			locations_log.logIncident(file_copy.c_str(), 1, nullptr, "second");
+			data = locations_log.logData();
+			ccstAssertEqual(data.c.incidents_count, 2);
+			ccstAssertTrue(data.incidents.find("first") != std::string::npos);
+			ccstAssertTrue(data.incidents.find("second") == std::string::npos);
+			
+			// Unbound incidents are never merged
+			locations_log.logUnboundIncident("unbound %d", 1);
+			locations_log.logUnboundIncident("unbound %d", 2);
+			data = locations_log.logData();
+			ccstAssertEqual(data.c.incidents_count, 4);
+			ccstAssertTrue(data.incidents.find("FAIL: unbound 1") != std::string::npos);
+			ccstAssertTrue(data.incidents.find("FAIL: unbound 2") != std::string::npos);
+		}
 	};
 	
-	CC7_CREATE_UNIT_TEST(tt7Testception, "cc7 test")
+	CC7_CREATE_UNIT_TEST(tt7Testception, "cc7 test serial")
 	
 } // cc7::tests
 } // cc7